@@ -9,6 +9,8 @@
 #define CPP_VEHICLE_H
 
 #include <array>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -17,13 +19,14 @@
 #include <openssl/ec.h>
 
 #include "ieee16092.h"
+#include "psid_dispatch.h"
+#include "signing_backend.h"
+#include "spdu_capture.h"
+#include "trace_reader.h"
 #include "bsm.h"
 #include "v2vcrypto.h"
-
-enum class signature_scheme {
-    ECDSA = 0,
-    FALCON = 1
-};
+#include "verification.h"
+#include "verify_offload.h"
 
 struct pqc_options {
     signature_scheme scheme = signature_scheme::ECDSA;
@@ -31,6 +34,29 @@ struct pqc_options {
     std::string compression = "none";
 };
 
+struct receive_options {
+    bool busy_poll = false;                     // non-blocking receive that spins before parking in poll()
+    std::chrono::microseconds spin{200};        // how long to spin on an empty socket before parking
+    int socket_busy_poll_us = 50;               // SO_BUSY_POLL budget for the driver, 0 = leave unset
+    dispatch_options dispatch{};                // verify on per-PSID-class threads instead of inline
+    capture_options capture{};                  // log every reassembled SPDU and its verification result
+};
+
+// Time one vehicle spent in each startup phase (zero until Vehicle::load() has run).
+struct startup_timing {
+    std::chrono::microseconds keys{0};      // ECDSA message and certificate keys
+    std::chrono::microseconds trace{0};     // opening the trace and reading its first window
+    std::chrono::microseconds falcon{0};    // Falcon private key, FALCON scheme only
+};
+
+struct transmit_options {
+    signing_backend_options signing{};
+    std::chrono::microseconds interval{100000}; // pause after each message, 0 = send as fast as signing allows
+    std::size_t trace_window_rows = 4096;       // trace rows per read-ahead window (two windows per vehicle)
+    std::vector<uint8_t> psids{0x20};           // PSID of each vehicle's messages, round-robin by vehicle number
+    std::vector<uint8_t> priorities{2};         // user priority (0-7) of each vehicle's messages, likewise
+};
+
 
 class Vehicle {
 
@@ -41,13 +67,15 @@ private:
     std::string hostname;
     uint8_t number;
     pqc_options pqc{};
-    EC_KEY *private_ec_key = nullptr, *cert_private_ec_key = nullptr;
+    transmit_options tx{};
+    receive_options rx{};
+    ec_key_ptr private_ec_key, cert_private_ec_key;
+    bool loaded = false;
+    startup_timing load_timing{};
     ecdsa_explicit_certificate vehicle_certificate_ecdsa;
 
-    unsigned char certificate_signature[72];
-    unsigned int certificate_buffer_length;
-
     std::vector<uint8_t> falcon_private_key;
+    std::shared_ptr<verify_offload_client> verify_offload;
 
     struct spdu_fragment {
         uint8_t vehicle_id;
@@ -59,6 +87,7 @@ private:
         uint8_t wsmp_n_tpid = 0;
         uint8_t wsmp_t_header_length_and_psid = 32;
         uint8_t wsmp_t_length = 0;
+        uint8_t user_priority = 0;      // 802.11 user priority (0-7) the WSM was sent with
         uint8_t signature_scheme = 0;
         uint16_t fragment_index = 0;
         uint16_t fragment_count = 1;
@@ -66,12 +95,14 @@ private:
         unsigned int fragment_length = 0;
         unsigned int signature_offset = 0;
         unsigned int certificate_signature_buffer_length = 0;
+        int64_t sign_start_us = 0;      // transmitter clock, microseconds since the epoch, for the latency budget
+        int64_t sign_end_us = 0;
+        int64_t sent_us = 0;            // set just before this fragment is (re)sent
         ieee1609dot2data_ecdsa_explicit data;
         std::array<uint8_t, MAX_SIGNATURE_FRAGMENT_SIZE> signature_fragment{};
     };
 
-    std::vector<std::vector<float>> timestep;
-    std::vector<float> timestep_data;
+    std::unique_ptr<trace_reader> trace;
 
     void generate_spdu(Vehicle::spdu_fragment &spdu, uint32_t sequence_number, int timestep);
 
@@ -79,31 +110,41 @@ private:
     static void print_bsm(Vehicle::spdu_fragment &spdu);
     static void print_spdu(Vehicle::spdu_fragment &spdu, bool valid);
 
-    static void load_key(int number, bool certificate, EC_KEY *&key_to_store);
-    void load_falcon_private_key(int number);
-    static void load_falcon_public_key(int number, std::vector<uint8_t> &dest);
     void load_trace(int number);
 
-    void sign_message_ecdsa(Vehicle::spdu_fragment &spdu);
-    std::vector<Vehicle::spdu_fragment> sign_message_falcon(const Vehicle::spdu_fragment &spdu);
-    std::vector<Vehicle::spdu_fragment> prepare_signed_fragments(uint32_t sequence_number, int timestep);
+    std::vector<Vehicle::spdu_fragment> fragment_signature(const Vehicle::spdu_fragment &spdu,
+                                                           const std::vector<uint8_t> &signature);
+    std::vector<std::vector<Vehicle::spdu_fragment>> prepare_signed_batch(signing_backend &signer,
+                                                                          uint32_t first_sequence,
+                                                                          int count);
     bool verify_message(Vehicle::spdu_fragment &spdu, const std::vector<uint8_t> &assembled_signature,
                         std::chrono::time_point<std::chrono::system_clock,
                         std::chrono::microseconds> received_time, int vehicle_id);
 
 public:
-    Vehicle(int number, pqc_options pqc_opts = {}) {
+    // Cheap: keys and the trace are read by load(), which transmit() calls on first use if nobody did earlier.
+    explicit Vehicle(int number, pqc_options pqc_opts = {}) {
         hostname = "null_hostname";
         this->number = number;
         this->pqc = pqc_opts;
-        Vehicle::load_key(number, false, private_ec_key);
-        Vehicle::load_key(number, true, cert_private_ec_key);
-        Vehicle::load_trace(number);
-        if (this->pqc.scheme == signature_scheme::FALCON) {
-            load_falcon_private_key(number);
-        }
     };
 
+    // Owns its keys, so moving is cheap and copying is not allowed.
+    Vehicle(Vehicle &&) = default;
+    Vehicle &operator=(Vehicle &&) = default;
+    Vehicle(const Vehicle &) = delete;
+    Vehicle &operator=(const Vehicle &) = delete;
+
+    // Load the signing keys and the trace. Idempotent; different vehicles may load concurrently.
+    void load();
+    const startup_timing &startup() const { return load_timing; }
+
+    void configure_transmit(const transmit_options &options) { tx = options; }
+    void configure_receive(const receive_options &options) { rx = options; }
+
+    // Hand signature checks to the verifier service instead of verifying in this process.
+    void enable_verify_offload(const verify_offload_options &options);
+
     std::string get_hostname();
     void transmit(int num_msgs, bool test);
     static void transmit_static(void* arg, int num_msgs, bool test) {
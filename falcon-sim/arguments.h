@@ -10,7 +10,9 @@
 
 enum mode {
     TRANSMITTER,
-    RECEIVER
+    RECEIVER,
+    VERIFIER,
+    HSM
 };
 
 enum technology {
@@ -0,0 +1,21 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_CPU_FEATURES_H
+#define CPP_CPU_FEATURES_H
+
+#include <string>
+
+// Instruction set extensions relevant to the signing/hashing kernels. All flags stay false on non-x86 hosts.
+struct cpu_features {
+    bool avx2 = false;
+    bool bmi2 = false;
+    bool avx512f = false;
+    bool aes_ni = false;
+    bool sha_ni = false;
+};
+
+cpu_features detect_cpu_features();
+std::string describe_cpu_features(const cpu_features &features);
+
+#endif //CPP_CPU_FEATURES_H
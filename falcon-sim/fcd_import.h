@@ -0,0 +1,34 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_FCD_IMPORT_H
+#define CPP_FCD_IMPORT_H
+
+#include <cstddef>
+#include <string>
+
+enum class fcd_projection {
+    NONE,       // x/y are already metres (SUMO's default network coordinates)
+    GEO         // x/y are longitude/latitude (--fcd-output.geo); projected onto a plane tangent at the origin
+};
+
+struct fcd_import_options {
+    std::string input;                      // FCD XML file, "-" for stdin (e.g. zcat run.fcd.xml.gz |)
+    std::string directory = "trace_files";
+    fcd_projection projection = fcd_projection::NONE;
+    bool origin_set = false;                // GEO: otherwise the first sample is the origin
+    double origin_latitude = 0;
+    double origin_longitude = 0;
+    std::size_t buffer_bytes = 64u << 20;   // rows held in memory before they are appended to the trace files
+};
+
+// "none" or "geo"; exits on anything else.
+fcd_projection parse_fcd_projection(const std::string &name);
+
+// Stream a SUMO floating-car-data file into one binary trace per vehicle (<directory>/<n>.bin, numbered in order of
+// first appearance; <directory>/fcd_ids.csv maps the numbers back to SUMO ids). Samples are linearly resampled to
+// TRACE_TICK_MS. Memory use depends on the number of vehicles and buffer_bytes, not on the size of the input.
+// Prints an IMPORT line with the throughput; exits on malformed input or I/O errors.
+void import_fcd(const fcd_import_options &options);
+
+#endif //CPP_FCD_IMPORT_H
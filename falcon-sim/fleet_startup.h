@@ -0,0 +1,48 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_FLEET_STARTUP_H
+#define CPP_FLEET_STARTUP_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Vehicle.h"
+
+enum class startup_mode {
+    SEQUENTIAL,     // load every vehicle on the main thread before transmitting
+    PARALLEL,       // load on a pool of threads before transmitting
+    LAZY            // load nothing up front; each vehicle loads on its own thread when it starts transmitting
+};
+
+struct startup_options {
+    startup_mode mode = startup_mode::PARALLEL;
+    unsigned threads = 0;           // PARALLEL pool size, 0 = one per online CPU (capped at the fleet size)
+    std::vector<int> cpus;          // pool threads are spread round-robin over this set
+};
+
+struct startup_report {
+    std::chrono::microseconds construct{0};     // creating the Vehicle objects
+    std::chrono::microseconds load{0};          // wall time of the up-front load, zero for LAZY
+    unsigned threads = 0;                       // threads that did the up-front load
+};
+
+// "sequential", "parallel" or "lazy"; exits on anything else.
+startup_mode parse_startup_mode(const std::string &name);
+const char *startup_mode_name(startup_mode mode);
+
+// Create `num_vehicles` transmitters and load them as `options` asks, recording the time taken in `report`.
+std::vector<Vehicle> create_fleet(int num_vehicles,
+                                  const pqc_options &pqc_opts,
+                                  const transmit_options &tx_opts,
+                                  const startup_options &options,
+                                  startup_report &report);
+
+// Print the STARTUP line: wall times from `report` and per-phase times summed over the fleet. For LAZY, call it
+// after the vehicles have transmitted so the phases include the deferred loads.
+void print_startup_report(const std::vector<Vehicle> &vehicles,
+                          const startup_options &options,
+                          const startup_report &report);
+
+#endif //CPP_FLEET_STARTUP_H
@@ -0,0 +1,71 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_HSM_PROTOCOL_H
+#define CPP_HSM_PROTOCOL_H
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+// Wire format between hsm_signing_backend and the HSM emulator: a header followed by `payload_len` bytes (the
+// SHA-256 digest for ECDSA, the message for Falcon); the answer is a header followed by the signature.
+constexpr std::size_t HSM_MAX_PAYLOAD = 4096;
+constexpr std::size_t HSM_MAX_SIGNATURE = 1536;
+constexpr std::size_t HSM_ECDSA_DIGEST_BYTES = 32;
+
+// hsm_response_header::status
+constexpr uint32_t HSM_STATUS_OK = 0;
+constexpr uint32_t HSM_STATUS_BAD_REQUEST = 1;     // e.g. an ECDSA payload that is not a SHA-256 digest
+constexpr uint32_t HSM_STATUS_SIGN_FAILED = 2;     // the signer produced no signature
+
+struct hsm_request_header {
+    uint32_t request_id;
+    uint8_t scheme;
+    uint8_t key_kind;
+    uint8_t key_id;
+    uint8_t reserved;
+    uint32_t payload_len;
+};
+
+struct hsm_response_header {
+    uint32_t request_id;
+    uint32_t status;        // HSM_STATUS_*; no signature follows unless HSM_STATUS_OK
+    uint32_t signature_len;
+};
+
+inline bool hsm_read_full(int fd, void *buffer, std::size_t length) {
+    auto *cursor = static_cast<uint8_t *>(buffer);
+    while (length > 0) {
+        ssize_t n = read(fd, cursor, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        cursor += n;
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+inline bool hsm_write_full(int fd, const void *buffer, std::size_t length) {
+    const auto *cursor = static_cast<const uint8_t *>(buffer);
+    while (length > 0) {
+        ssize_t n = write(fd, cursor, length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        cursor += n;
+        length -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+#endif //CPP_HSM_PROTOCOL_H
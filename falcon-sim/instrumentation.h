@@ -0,0 +1,153 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_INSTRUMENTATION_H
+#define CPP_INSTRUMENTATION_H
+
+// Hot-path probes: scoped timers, counters and gauges.
+//
+//     V2X_PROBE_SCOPE(verify_message);                 // time until the end of the enclosing scope
+//     V2X_PROBE_COUNT(fragments_received, 1);
+//     V2X_PROBE_GAUGE(pending_messages, pending.size());
+//     V2X_PROBE_REPORT();                              // one PROBE line per timer, counter and gauge used
+//
+// Probes are only compiled in when falcon_sim is configured with -DV2X_INSTRUMENTATION=ON. Otherwise every macro
+// expands to an empty statement and its arguments are not evaluated. When enabled, timers read the TSC and every
+// thread records into its own block of histograms, so a probe costs two TSC reads and a few uncontended stores.
+
+#ifdef V2X_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class probe : uint8_t {
+    prepare_signed_batch,   // generating, signing and fragmenting one batch of messages
+    falcon_sign,            // one Falcon signature in the local signing backend
+    ecdsa_sign,             // one ECDSA signature (hash included) in the local signing backend
+    receive_datagram,       // waiting for and receiving one fragment
+    reassembly,             // filing one fragment into its pending message
+    verify_message,         // certificate and message signature checks for one SPDU
+    count
+};
+
+enum class probe_counter : uint8_t {
+    fragments_received,
+    duplicate_fragments,
+    messages_completed,
+    messages_invalid,
+    count
+};
+
+enum class probe_gauge : uint8_t {
+    pending_messages,       // partially reassembled messages, sampled per fragment
+    signature_bytes,        // message signature length, sampled per signature
+    count
+};
+
+namespace instrumentation {
+
+inline uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Log-linear buckets: exact below 8, then 8 buckets per power of two (at most 12.5% error).
+constexpr std::size_t HISTOGRAM_BUCKETS = 496;
+
+inline std::size_t bucket_of(uint64_t value) {
+    if (value < 8) {
+        return static_cast<std::size_t>(value);
+    }
+    const int exponent = 63 - __builtin_clzll(value);
+    return static_cast<std::size_t>((exponent - 2) * 8) + static_cast<std::size_t>((value >> (exponent - 3)) & 7);
+}
+
+// Written only by the owning thread (plain load + store, no locked instructions); atomic so the report may read
+// while other threads are still running.
+struct thread_probes {
+    struct histogram {
+        std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> max;
+    };
+
+    histogram timers[static_cast<std::size_t>(probe::count)];
+    std::atomic<uint64_t> counters[static_cast<std::size_t>(probe_counter::count)];
+    histogram gauges[static_cast<std::size_t>(probe_gauge::count)];
+};
+
+// Allocate and register the calling thread's block. Blocks live until the process exits.
+thread_probes *register_thread();
+
+inline thread_probes &local_probes() {
+    thread_local thread_probes *local = register_thread();
+    return *local;
+}
+
+inline void bump(std::atomic<uint64_t> &slot, uint64_t amount) {
+    slot.store(slot.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline void record(thread_probes::histogram &target, uint64_t value) {
+    bump(target.buckets[bucket_of(value)], 1);
+    bump(target.samples, 1);
+    bump(target.total, value);
+    if (value > target.max.load(std::memory_order_relaxed)) {
+        target.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+class scoped_timer {
+
+public:
+    explicit scoped_timer(probe which) : which(which), start(read_tsc()) {}
+    scoped_timer(const scoped_timer &) = delete;
+    scoped_timer &operator=(const scoped_timer &) = delete;
+    ~scoped_timer() {
+        record(local_probes().timers[static_cast<std::size_t>(which)], read_tsc() - start);
+    }
+
+private:
+    probe which;
+    uint64_t start;
+};
+
+// Print the merged histograms of all threads, converting TSC ticks to microseconds.
+void print_report();
+
+} // namespace instrumentation
+
+#define V2X_PROBE_CONCAT_INNER(a, b) a##b
+#define V2X_PROBE_CONCAT(a, b) V2X_PROBE_CONCAT_INNER(a, b)
+
+#define V2X_PROBE_SCOPE(name) \
+    instrumentation::scoped_timer V2X_PROBE_CONCAT(v2x_probe_scope_, __LINE__)(probe::name)
+#define V2X_PROBE_COUNT(name, amount) \
+    instrumentation::bump(instrumentation::local_probes().counters[static_cast<std::size_t>(probe_counter::name)], \
+                          static_cast<uint64_t>(amount))
+#define V2X_PROBE_GAUGE(name, value) \
+    instrumentation::record(instrumentation::local_probes().gauges[static_cast<std::size_t>(probe_gauge::name)], \
+                            static_cast<uint64_t>(value))
+#define V2X_PROBE_REPORT() instrumentation::print_report()
+
+#else
+
+#define V2X_PROBE_SCOPE(name) do {} while (0)
+#define V2X_PROBE_COUNT(name, amount) do {} while (0)
+#define V2X_PROBE_GAUGE(name, value) do {} while (0)
+#define V2X_PROBE_REPORT() do {} while (0)
+
+#endif // V2X_INSTRUMENTATION
+
+#endif //CPP_INSTRUMENTATION_H
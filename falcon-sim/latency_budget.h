@@ -0,0 +1,69 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_LATENCY_BUDGET_H
+#define CPP_LATENCY_BUDGET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Consecutive intervals in the life of one SPDU; all but `total` add up to `total`.
+enum class latency_stage : uint8_t {
+    queue,          // BSM generated -> signing started (the rest of the signing batch being generated)
+    sign,           // certificate and message signatures
+    send,           // signed -> the fragment that arrived first was sent (pacing, earlier messages, resends)
+    wire,           // that fragment sent -> received
+    reassembly,     // first fragment received -> last fragment received
+    dispatch,       // reassembled -> verification started (waiting for a PSID-dispatch verifier; 0 inline)
+    verify,
+    output,         // verified -> printed and handed to the GUI
+    total,          // BSM generated -> output done
+    count
+};
+
+constexpr std::size_t LATENCY_STAGE_COUNT = static_cast<std::size_t>(latency_stage::count);
+
+const char *latency_stage_name(latency_stage stage);
+
+// When each step happened, in microseconds since the epoch (system clock). The first four come from the
+// transmitter, so across hosts the send and wire stages are only as good as the clock synchronisation.
+struct message_timestamps {
+    int64_t generated_us = 0;
+    int64_t sign_start_us = 0;
+    int64_t sign_end_us = 0;
+    int64_t sent_us = 0;
+    int64_t first_arrival_us = 0;
+    int64_t completed_us = 0;
+    int64_t verify_start_us = 0;
+    int64_t verify_end_us = 0;
+    int64_t output_us = 0;
+};
+
+// Per-message stage durations for one receiver run. Not thread-safe; the receiver records under its output lock.
+class latency_budget {
+
+public:
+    void record(uint8_t vehicle_id, uint32_t sequence_number, uint8_t scheme, const message_timestamps &times);
+
+    // One "LATENCY stage=.. messages=.. avg_us=.. p50_us=.. p90_us=.. p99_us=.. max_us=.." line per stage.
+    void print_report() const;
+
+    // Append one row per message to the CSV at `path` (header first if the file is empty):
+    // run,vehicle,sequence,scheme,generated_us,<stage>_us...,note
+    void write_csv(const char *path, const char *run_id, const char *note) const;
+
+private:
+    struct sample {
+        uint8_t vehicle_id;
+        uint8_t scheme;
+        uint32_t sequence_number;
+        int64_t generated_us;
+        std::array<int64_t, LATENCY_STAGE_COUNT> stages_us;
+    };
+
+    std::vector<sample> samples;
+};
+
+#endif //CPP_LATENCY_BUDGET_H
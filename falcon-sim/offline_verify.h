@@ -0,0 +1,28 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_OFFLINE_VERIFY_H
+#define CPP_OFFLINE_VERIFY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct offline_verify_options {
+    std::string directory = "captures";     // capture log written by the receiver (spdu_capture.h)
+    unsigned threads = 0;                   // 0 = one per CPU the process may run on
+    std::vector<int> cpus;                  // pin worker n to the n-th of these, round-robin; empty = unpinned
+    std::size_t chunk_records = 256;        // records per work item; a segment is split into chunks of this size
+};
+
+// Re-verify every SPDU in the capture log with the same checks as the receiver (certificate signature, message
+// signature, 30 s freshness against the recorded receive time). Segments are mapped read-only and cut into chunks
+// that a pool of worker threads takes in turn. Keys are loaded before the clock starts, so the figures cover
+// verification only. Prints a MISMATCH line for every record whose result differs from the verdict recorded
+// online (records the receiver dropped unverified are verified but not compared) and an OFFLINE line per scheme
+// plus a total. Unreadable segments, truncated segments and malformed records are reported, skipped and counted.
+// Returns the number of problems found: mismatches plus all of those. Exits if the directory holds no segments.
+uint64_t verify_offline(const offline_verify_options &options);
+
+#endif //CPP_OFFLINE_VERIFY_H
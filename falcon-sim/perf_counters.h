@@ -0,0 +1,88 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_PERF_COUNTERS_H
+#define CPP_PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Pipeline stages measured with hardware counters. Stages may nest (hashing happens inside signing and verification).
+enum class perf_stage : uint8_t {
+    sign,           // one signature in the local signing backend
+    hash,           // one SHA-256 digest
+    verify,         // certificate and message signature checks for one SPDU
+    reassembly,     // filing one fragment into its pending message
+    count
+};
+
+enum class perf_state : uint8_t {
+    off,            // not requested
+    on,
+    unavailable     // requested, but perf_event_open failed (no PMU access, perf_event_paranoid, seccomp...)
+};
+
+// User-space cycles, instructions, cache misses and branch misses, read as one perf_event group.
+struct perf_sample {
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+
+    perf_sample &operator+=(const perf_sample &other);
+    double ipc() const { return cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0; }
+};
+
+// A raw read of a thread's counter group: cumulative counts plus the time the group was enabled and actually on the
+// PMU, which differ when the kernel multiplexes it with other events.
+struct perf_reading {
+    perf_sample counts;
+    uint64_t time_enabled = 0;
+    uint64_t time_running = 0;
+};
+
+// " cycles=.. instructions=.. ipc=.. cache_misses=.. branch_misses=.."
+std::ostream &operator<<(std::ostream &out, const perf_sample &sample);
+
+// Turn the counters on for the whole process; call before starting threads. Checks that this thread can open the
+// counter group and returns `unavailable` (after printing why) if it cannot.
+perf_state enable_perf_counters();
+perf_state current_perf_state();
+const char *perf_stage_name(perf_stage stage);
+
+namespace perf_detail {
+extern std::atomic<bool> active;
+}
+
+inline bool perf_counters_active() {
+    return perf_detail::active.load(std::memory_order_relaxed);
+}
+
+// Counts the calling thread's events from construction to destruction (scaled up if the group was multiplexed),
+// adds them to the run total of `stage` and, if given, to `*accumulate`. Costs one branch when the counters are off;
+// two read() syscalls when they are on.
+class perf_scope {
+
+public:
+    explicit perf_scope(perf_stage stage, perf_sample *accumulate = nullptr);
+    perf_scope(const perf_scope &) = delete;
+    perf_scope &operator=(const perf_scope &) = delete;
+    ~perf_scope();
+
+private:
+    perf_stage stage;
+    perf_sample *accumulate;
+    perf_reading start;
+    bool running = false;
+};
+
+// Run totals of one stage over all threads so far.
+uint64_t perf_stage_calls(perf_stage stage);
+perf_sample perf_stage_total(perf_stage stage);
+
+// One "PERF stage=.. calls=.. <totals> cycles_per_call=.. multiplexed=.." line per stage measured in this process.
+void print_perf_totals();
+
+#endif //CPP_PERF_COUNTERS_H
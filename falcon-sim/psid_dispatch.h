@@ -0,0 +1,97 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_PSID_DISPATCH_H
+#define CPP_PSID_DISPATCH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One traffic class: the messages it takes and the verifier threads that serve only it.
+struct dispatch_class_options {
+    std::string name;
+    std::vector<uint8_t> psids;         // PSIDs routed here, empty = any PSID
+    uint8_t min_priority = 0;           // lowest user priority (0-7) routed here
+    std::size_t verifiers = 1;          // verifier threads dedicated to this class
+    std::size_t capacity = 1024;        // queued messages before new ones are dropped
+};
+
+struct dispatch_options {
+    bool enabled = false;                       // receiver: verify on per-class threads instead of inline
+    std::vector<dispatch_class_options> classes;// matched in order, first match wins; the last should take anything
+    std::vector<int> cpus;                      // verifier threads are spread round-robin over this set
+    std::vector<int> fallback_cpus;             // with `cpus` empty, every verifier thread may run on any of these
+};
+
+// Emergency traffic (user priority 6-7), then BSMs (PSID 0x20), then everything else, one verifier each.
+std::vector<dispatch_class_options> default_dispatch_classes();
+
+// Parse a PSID list such as "32,35" or "0x20,0x23"; "" or "any" is the empty list. Exits on malformed lists.
+std::vector<uint8_t> parse_psid_list(const std::string &spec);
+
+// Routes complete SPDUs by PSID and user priority into per-class queues, each served by its own verifier threads,
+// so a flood of low-priority traffic cannot delay safety messages. Within a class, higher priorities go first and
+// equal priorities in arrival order.
+class psid_dispatcher {
+
+public:
+    using job = std::function<void()>;
+
+    explicit psid_dispatcher(const dispatch_options &options);
+    psid_dispatcher(const psid_dispatcher &) = delete;
+    psid_dispatcher &operator=(const psid_dispatcher &) = delete;
+    ~psid_dispatcher();
+
+    // Queue `work` on the class for this PSID and priority. Returns false, without running `work`, if that class's
+    // queue is full.
+    bool submit(uint8_t psid, uint8_t priority, job work);
+
+    // Wait until everything submitted so far has run.
+    void drain();
+
+    // Print one DISPATCH line per class: messages, drops, queue depth and queueing/verification latency.
+    void print_report() const;
+
+private:
+    struct queued_job {
+        uint8_t priority;
+        uint64_t arrival;
+        std::chrono::steady_clock::time_point queued;
+        job work;
+    };
+
+    struct lane {
+        dispatch_class_options options;
+        mutable std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        std::vector<queued_job> heap;   // max-heap on (priority, earliest arrival)
+        std::size_t running = 0;
+        bool stopping = false;
+        std::vector<std::thread> threads;
+
+        uint64_t arrivals = 0;
+        uint64_t completed = 0;
+        uint64_t dropped = 0;
+        std::size_t max_depth = 0;
+        double wait_total_us = 0;       // submit() to a verifier picking the message up
+        double wait_max_us = 0;
+        double service_total_us = 0;    // running the job
+        double service_max_us = 0;
+    };
+
+    std::vector<std::unique_ptr<lane>> lanes;
+
+    lane &route(uint8_t psid, uint8_t priority);
+    static void serve(lane &target);
+};
+
+#endif //CPP_PSID_DISPATCH_H
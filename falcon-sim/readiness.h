@@ -0,0 +1,18 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_READINESS_H
+#define CPP_READINESS_H
+
+#include <cstdint>
+
+// Receiver side: announce that the receive socket is bound and the receiver is about to read from it. Writes
+// "ready <port>\n" to the descriptor in V2X_READY_FD (then closes it) and/or atomically creates the file named by
+// V2X_READY_FILE with the same line. Does nothing when neither is set.
+void signal_ready(uint16_t port);
+
+// Transmitter side: if V2X_READY_FILE is set, block until the receiver has created it. Exits with an error after
+// V2X_READY_TIMEOUT_MS (default 10000) milliseconds.
+void wait_for_ready();
+
+#endif //CPP_READINESS_H
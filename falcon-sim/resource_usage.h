@@ -0,0 +1,52 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_RESOURCE_USAGE_H
+#define CPP_RESOURCE_USAGE_H
+
+#include <chrono>
+#include <string>
+
+// CPU time, memory and scheduling counters of a thread or of the whole process.
+struct resource_usage {
+    long long cpu_us = 0;               // CLOCK_THREAD_CPUTIME_ID / CLOCK_PROCESS_CPUTIME_ID
+    long long user_us = 0;
+    long long system_us = 0;
+    long max_rss_kb = 0;                // peak resident set of the process (not per thread)
+    long voluntary_switches = 0;        // blocked: sleeping, waiting on I/O or a lock
+    long involuntary_switches = 0;      // preempted
+    long minor_faults = 0;
+    long major_faults = 0;
+};
+
+resource_usage thread_resource_usage();
+resource_usage process_resource_usage();
+
+// Usage between two snapshots of the same thread or process; max_rss_kb is taken from `end`.
+resource_usage usage_since(const resource_usage &start, const resource_usage &end);
+
+// Microseconds since the process started.
+long long process_wall_us();
+
+// Measures the calling thread from construction: wall time and resource_usage deltas.
+class thread_usage_meter {
+
+public:
+    thread_usage_meter() : start_time(std::chrono::steady_clock::now()), start(thread_resource_usage()) {}
+
+    long long wall_us() const;
+    resource_usage usage() const { return usage_since(start, thread_resource_usage()); }
+
+private:
+    std::chrono::steady_clock::time_point start_time;
+    resource_usage start;
+};
+
+// Append one row to the CSV named by V2X_RESOURCE_FILE (no-op when unset), writing the header to an empty file.
+// Rows are tagged with V2X_METRICS_RUN and V2X_METRICS_NOTE like falcon_metrics.csv; `role` is transmitter or
+// receiver and `thread` names the measured thread, or is "process" for the whole process. Safe to call from several
+// threads and processes at once.
+void record_resource_usage(const std::string &role, const std::string &thread, int scheme, long long wall_us,
+                           const resource_usage &usage);
+
+#endif //CPP_RESOURCE_USAGE_H
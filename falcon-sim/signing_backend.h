@@ -0,0 +1,100 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_SIGNING_BACKEND_H
+#define CPP_SIGNING_BACKEND_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <openssl/ec.h>
+
+#include "perf_counters.h"
+#include "v2vcrypto.h"
+#include "verification.h"
+
+struct signing_backend_options {
+    std::string backend = "local";              // "local" signs in-process, "hsm" uses the HSM emulator
+    std::string hsm_socket = "/tmp/v2x_hsm.sock";
+    std::size_t pipeline_depth = 1;             // messages signed per batch (requests in flight to the HSM)
+};
+
+struct hsm_emulator_options {
+    std::string socket_path = "/tmp/v2x_hsm.sock";
+    std::chrono::microseconds ecdsa_latency{0}; // modelled device time per ECDSA signature
+    std::chrono::microseconds falcon_latency{0}; // modelled device time per Falcon signature
+    std::size_t concurrency = 1;                // signatures the device computes at once
+    std::vector<int> cpus;                      // CPUs for the engine threads, empty = unpinned
+};
+
+// One signature to produce. ECDSA signs the SHA-256 of `message`, Falcon signs `message` itself.
+struct signing_request {
+    signature_scheme scheme = signature_scheme::ECDSA;
+    verification_key_kind kind = verification_key_kind::MESSAGE;
+    uint8_t key_id = 0;
+    const uint8_t *message = nullptr;
+    std::size_t message_len = 0;
+    std::vector<uint8_t> signature;             // filled in by sign_batch()
+    perf_sample perf{};                         // counters for this signature (local backend, counters on)
+};
+
+class signing_backend {
+
+public:
+    virtual ~signing_backend() = default;
+    virtual const char *name() const = 0;
+
+    // Sign every request; backends may have all of them outstanding at once.
+    virtual void sign_batch(std::vector<signing_request> &requests) = 0;
+};
+
+// Signs with keys held by the caller; `key_id` is ignored. The keys must outlive the backend.
+class local_signing_backend : public signing_backend {
+
+public:
+    local_signing_backend(EC_KEY *message_key, EC_KEY *certificate_key, const std::vector<uint8_t> &falcon_key)
+        : message_key(message_key), certificate_key(certificate_key), falcon_key(falcon_key) {}
+
+    const char *name() const override { return "local"; }
+    void sign_batch(std::vector<signing_request> &requests) override;
+    void sign(signing_request &request);
+
+private:
+    EC_KEY *message_key;
+    EC_KEY *certificate_key;
+    const std::vector<uint8_t> &falcon_key;
+};
+
+// Client of the HSM emulator. Requests in a batch are written back to back and answered out of order.
+class hsm_signing_backend : public signing_backend {
+
+public:
+    explicit hsm_signing_backend(const std::string &socket_path);
+    hsm_signing_backend(const hsm_signing_backend &) = delete;
+    hsm_signing_backend &operator=(const hsm_signing_backend &) = delete;
+    ~hsm_signing_backend() override;
+
+    const char *name() const override { return "hsm"; }
+    void sign_batch(std::vector<signing_request> &requests) override;
+
+private:
+    int sockfd = -1;
+    uint32_t next_request_id = 0;
+};
+
+std::vector<uint8_t> ecdsa_sign_digest(const unsigned char *digest, EC_KEY *key);
+std::vector<uint8_t> falcon_sign_message(const uint8_t *message, std::size_t message_len,
+                                         const std::vector<uint8_t> &private_key);
+
+std::unique_ptr<signing_backend> make_signing_backend(const signing_backend_options &options,
+                                                      EC_KEY *message_key,
+                                                      EC_KEY *certificate_key,
+                                                      const std::vector<uint8_t> &falcon_key);
+
+// Serve signing requests on a Unix socket with the configured latency and concurrency until SIGINT/SIGTERM.
+void run_hsm_emulator(const hsm_emulator_options &options);
+
+#endif //CPP_SIGNING_BACKEND_H
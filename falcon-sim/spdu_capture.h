@@ -0,0 +1,135 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_SPDU_CAPTURE_H
+#define CPP_SPDU_CAPTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Capture log of reassembled SPDUs, append-only and split into segments.
+//
+// <directory>/spdu-NNNNNN.seg starts with a capture_segment_header and holds back-to-back records: a
+// capture_record followed by `data_bytes` of the SPDU (ieee1609dot2data_ecdsa_explicit as received) and
+// `signature_bytes` of the reassembled message signature, padded to 8 bytes. used_bytes and record_count in the
+// header are updated after every record, so a segment that is still being written (or was cut short by a crash)
+// reads back up to its last complete record. <directory>/spdu-NNNNNN.idx holds one capture_index_entry per record
+// of that segment, for scanning by time, sender or result without touching the payloads. A new run continues with
+// the next segment number; receivers sharing a directory each take the next number no one has created yet (their
+// segments interleave, so a directory per receiver keeps runs apart). All integers are native-endian.
+constexpr char CAPTURE_SEGMENT_MAGIC[8] = {'V', '2', 'X', 'C', 'A', 'P', '0', '1'};
+constexpr uint8_t CAPTURE_VALID = 0x01;     // capture_record::flags: the SPDU verified
+constexpr uint8_t CAPTURE_DROPPED = 0x02;   // never verified: the PSID dispatcher's queue for its class was full
+
+struct capture_segment_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t segment;
+    uint64_t used_bytes;        // header included
+    uint64_t record_count;
+    uint64_t created_us;        // system clock, microseconds since the epoch
+    uint8_t reserved[24];
+};
+static_assert(sizeof(capture_segment_header) == 64, "capture_segment_header is part of the file format");
+
+struct capture_record {
+    uint64_t receive_time_us;   // when the last fragment arrived, system clock
+    uint32_t sequence_number;
+    uint32_t payload_bytes;     // data_bytes + signature_bytes, before padding
+    uint16_t data_bytes;
+    uint16_t signature_bytes;
+    uint16_t certificate_signature_bytes;
+    uint8_t vehicle_id;
+    uint8_t signature_scheme;
+    uint8_t psid;
+    uint8_t user_priority;
+    uint8_t flags;
+    uint8_t reserved[5];
+};
+static_assert(sizeof(capture_record) == 32, "capture_record is part of the file format");
+
+struct capture_index_entry {
+    uint64_t offset;            // of the capture_record within the segment
+    uint64_t receive_time_us;
+    uint32_t sequence_number;
+    uint8_t vehicle_id;
+    uint8_t flags;
+    uint8_t signature_scheme;
+    uint8_t psid;
+};
+static_assert(sizeof(capture_index_entry) == 24, "capture_index_entry is part of the file format");
+
+struct capture_options {
+    bool enabled = false;
+    std::string directory = "captures";
+    std::size_t segment_bytes = 64u << 20;      // segment size; a record larger than this gets a segment of its own
+    std::size_t queue_capacity = 4096;          // records waiting for the writer before new ones are dropped
+    std::vector<int> cpus;                      // writer thread's CPU set; empty = whatever the creating thread has
+};
+
+std::string capture_segment_path(const std::string &directory, uint32_t segment);
+std::string capture_index_path(const std::string &directory, uint32_t segment);
+
+// Writes the capture log on a background thread. append() copies the record into a queue and returns; the writer
+// thread copies queued records into the memory-mapped segment and appends their index entries.
+class spdu_capture {
+
+public:
+    // Creates the directory and the first segment; exits on I/O errors.
+    explicit spdu_capture(const capture_options &options);
+    spdu_capture(const spdu_capture &) = delete;
+    spdu_capture &operator=(const spdu_capture &) = delete;
+    // Calls close().
+    ~spdu_capture();
+
+    // Writes everything still queued, trims the last segment to its used size and stops the writer thread. Further
+    // append() calls count as drops.
+    void close();
+
+    // Queue one SPDU. Never waits for I/O; returns false, and counts a drop, if the queue is full. Thread-safe.
+    bool append(const capture_record &record, const void *data, std::size_t data_bytes,
+                const uint8_t *signature, std::size_t signature_bytes);
+
+    uint64_t records() const { return written.load(); }
+    uint64_t dropped() const { return dropped_count.load(); }
+    uint64_t bytes() const { return written_bytes.load(); }
+
+private:
+    struct pending_record {
+        capture_record record;
+        std::vector<uint8_t> payload;
+    };
+
+    void run();
+    void write_record(const pending_record &pending, std::vector<capture_index_entry> &index);
+    void open_segment(std::size_t minimum_bytes);
+    void close_segment(std::vector<capture_index_entry> &index);
+    void flush_index(std::vector<capture_index_entry> &index);
+
+    capture_options options;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<pending_record> queue;
+    bool stopping = false;
+    std::thread writer;
+
+    // writer thread only
+    uint32_t segment = 0;
+    int segment_fd = -1;
+    int index_fd = -1;
+    uint8_t *mapping = nullptr;
+    std::size_t mapping_bytes = 0;
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped_count{0};
+    std::atomic<uint64_t> written_bytes{0};
+};
+
+#endif //CPP_SPDU_CAPTURE_H
@@ -3,6 +3,10 @@
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <algorithm>
@@ -11,23 +15,32 @@
 #include <cstring>
 #include <fstream>
 #include <iostream>
-#include <iterator>
+#include <memory>
+#include <mutex>
 #include <random>
-#include <stdexcept>
 #include <sstream>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
-#include <openssl/err.h>
-#include <openssl/pem.h>
-
 #include "Vehicle.h"
+#include "instrumentation.h"
+#include "latency_budget.h"
+#include "perf_counters.h"
+#include "readiness.h"
+#include "resource_usage.h"
+#include "thread_affinity.h"
+#include "trace_format.h"
 #include <cstdlib>
 
 namespace {
 using timestamp = std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds>;
 
+int64_t epoch_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 uint64_t make_message_key(uint8_t vehicle_id, uint32_t sequence_number) {
     return (static_cast<uint64_t>(vehicle_id) << 32) | static_cast<uint64_t>(sequence_number);
 }
@@ -39,31 +52,66 @@ std::size_t clamp_fragment_size(std::size_t requested, std::size_t maximum) {
     return std::min(requested, maximum);
 }
 
-uint8_t decode_hex_char(char c) {
-    if (c >= '0' && c <= '9') {
-        return static_cast<uint8_t>(c - '0');
-    }
-    if (c >= 'a' && c <= 'f') {
-        return static_cast<uint8_t>(c - 'a' + 10);
-    }
-    if (c >= 'A' && c <= 'F') {
-        return static_cast<uint8_t>(c - 'A' + 10);
-    }
-    throw std::runtime_error("Invalid hex character");
-}
-
-std::vector<uint8_t> hex_to_bytes(const std::string &hex) {
-    if (hex.size() % 2 != 0) {
-        throw std::runtime_error("Hex string length must be even");
-    }
-    std::vector<uint8_t> bytes;
-    bytes.reserve(hex.size() / 2);
-    for (std::size_t i = 0; i < hex.size(); i += 2) {
-        uint8_t msn = decode_hex_char(hex[i]);
-        uint8_t lsn = decode_hex_char(hex[i + 1]);
-        bytes.push_back(static_cast<uint8_t>((msn << 4) | lsn));
+struct receive_stats {
+    uint64_t datagrams = 0;
+    uint64_t spin_hits = 0;     // datagrams picked up while spinning, without sleeping
+    uint64_t parks = 0;         // times the receiver gave up spinning and slept in poll()
+    double wakeup_total_us = 0; // kernel arrival (SO_TIMESTAMPNS) to recvmsg() returning
+    double wakeup_max_us = 0;
+};
+
+// Receive one datagram. In busy-poll mode the socket is non-blocking and we spin for `options.spin` before parking
+// in poll(); otherwise this blocks in the kernel like recvfrom().
+ssize_t receive_datagram(int sockfd, void *buffer, std::size_t length, const receive_options &options,
+                         receive_stats &stats) {
+    iovec iov{buffer, length};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(timespec))];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+
+    auto spin_deadline = std::chrono::steady_clock::now() + options.spin;
+    bool spinning = options.busy_poll;
+    ssize_t received;
+    for (;;) {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        received = recvmsg(sockfd, &message, 0);
+        if (received >= 0 || !options.busy_poll || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            break;
+        }
+        if (spinning && std::chrono::steady_clock::now() < spin_deadline) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+            continue;
+        }
+        spinning = false;
+        stats.parks++;
+        pollfd readable{sockfd, POLLIN, 0};
+        poll(&readable, 1, -1);
+    }
+    if (received < 0) {
+        return received;
+    }
+
+    timespec now{};
+    clock_gettime(CLOCK_REALTIME, &now);
+    stats.datagrams++;
+    if (spinning) {
+        stats.spin_hits++;
+    }
+    for (cmsghdr *header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec arrival{};
+            std::memcpy(&arrival, CMSG_DATA(header), sizeof(arrival));
+            double wakeup_us = static_cast<double>(now.tv_sec - arrival.tv_sec) * 1e6 +
+                               static_cast<double>(now.tv_nsec - arrival.tv_nsec) / 1e3;
+            stats.wakeup_total_us += wakeup_us;
+            stats.wakeup_max_us = std::max(stats.wakeup_max_us, wakeup_us);
+        }
     }
-    return bytes;
+    return received;
 }
 
 uint16_t get_test_port() {
@@ -83,20 +131,110 @@ std::string Vehicle::get_hostname() {
     return hostname;
 }
 
-std::vector<Vehicle::spdu_fragment> Vehicle::prepare_signed_fragments(uint32_t sequence_number, int timestep) {
-    Vehicle::spdu_fragment base{};
-    generate_spdu(base, sequence_number, timestep);
-    base.signature_scheme = static_cast<uint8_t>(pqc.scheme);
+void Vehicle::enable_verify_offload(const verify_offload_options &options) {
+    verify_offload = std::make_shared<verify_offload_client>(options);
+}
+
+std::vector<std::vector<Vehicle::spdu_fragment>> Vehicle::prepare_signed_batch(signing_backend &signer,
+                                                                                uint32_t first_sequence,
+                                                                                int count) {
+    V2X_PROBE_SCOPE(prepare_signed_batch);
+
+    // sized up front: the signing requests point into these fragments
+    std::vector<Vehicle::spdu_fragment> bases(static_cast<std::size_t>(count));
+    std::vector<signing_request> requests;
+    requests.reserve(bases.size() * 2);
+
+    for (int i = 0; i < count; i++) {
+        auto &base = bases[static_cast<std::size_t>(i)];
+        generate_spdu(base, first_sequence + static_cast<uint32_t>(i), static_cast<int>(first_sequence) + i);
+        base.signature_scheme = static_cast<uint8_t>(pqc.scheme);
+
+        signing_request certificate_request;
+        certificate_request.scheme = signature_scheme::ECDSA;
+        certificate_request.kind = verification_key_kind::CERTIFICATE;
+        certificate_request.key_id = number;
+        certificate_request.message = reinterpret_cast<const uint8_t *>(&base.data.signedData.cert);
+        certificate_request.message_len = sizeof(base.data.signedData.cert);
+        requests.push_back(std::move(certificate_request));
+
+        signing_request message_request;
+        message_request.scheme = pqc.scheme;
+        message_request.kind = verification_key_kind::MESSAGE;
+        message_request.key_id = number;
+        message_request.message = reinterpret_cast<const uint8_t *>(&base.data.signedData.tbsData);
+        message_request.message_len = sizeof(base.data.signedData.tbsData);
+        requests.push_back(std::move(message_request));
+    }
+
+    const int64_t sign_start_us = epoch_us();
+    signer.sign_batch(requests);
+    const int64_t sign_end_us = epoch_us();
+
+    std::vector<std::vector<Vehicle::spdu_fragment>> batch;
+    batch.reserve(bases.size());
+    for (std::size_t i = 0; i < bases.size(); i++) {
+        auto &base = bases[i];
+        const auto &certificate_signature = requests[2 * i].signature;
+        if (certificate_signature.size() > sizeof(base.data.certificate_signature)) {
+            std::cerr << "Certificate signature exceeds buffer size" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        base.certificate_signature_buffer_length = static_cast<unsigned int>(certificate_signature.size());
+        base.sign_start_us = sign_start_us;
+        base.sign_end_us = sign_end_us;
+        std::copy(certificate_signature.begin(), certificate_signature.end(), base.data.certificate_signature);
+
+        if (perf_counters_active() && std::strcmp(signer.name(), "local") == 0) {
+            // certificate and message signature together, like the receiver's per-message verify line
+            perf_sample sign_perf = requests[2 * i].perf;
+            sign_perf += requests[2 * i + 1].perf;
+            std::ostringstream line;
+            line << "PERF vehicle=" << static_cast<int>(number)
+                 << " sequence=" << base.sequence_number
+                 << " stage=sign"
+                 << sign_perf
+                 << '\n';
+            std::cout << line.str() << std::flush;
+        }
+
+        V2X_PROBE_GAUGE(signature_bytes, requests[2 * i + 1].signature.size());
+        batch.push_back(fragment_signature(base, requests[2 * i + 1].signature));
+    }
+    return batch;
+}
+
+void Vehicle::load() {
+    if (loaded) {
+        return;
+    }
+
+    auto phase_start = std::chrono::steady_clock::now();
+    auto finish_phase = [&phase_start](std::chrono::microseconds &phase) {
+        const auto now = std::chrono::steady_clock::now();
+        phase = std::chrono::duration_cast<std::chrono::microseconds>(now - phase_start);
+        phase_start = now;
+    };
+
+    private_ec_key = load_ec_key(number, false);
+    cert_private_ec_key = load_ec_key(number, true);
+    finish_phase(load_timing.keys);
+
+    load_trace(number);
+    finish_phase(load_timing.trace);
 
-    if (pqc.scheme == signature_scheme::ECDSA) {
-        sign_message_ecdsa(base);
-        return {base};
+    if (pqc.scheme == signature_scheme::FALCON) {
+        falcon_private_key = load_falcon_key(number, true);
+        finish_phase(load_timing.falcon);
     }
 
-    return sign_message_falcon(base);
+    loaded = true;
 }
 
 void Vehicle::transmit(int num_msgs, bool test) {
+    load();
+    const thread_usage_meter meter;
+
     int sockfd;
     struct sockaddr_in servaddr;
 
@@ -135,48 +273,88 @@ void Vehicle::transmit(int num_msgs, bool test) {
     std::size_t dropped_fragments = 0;
     std::size_t resent_fragments = 0;
 
-    for (int i = 0; i < num_msgs; i++) {
-        auto fragments = prepare_signed_fragments(static_cast<uint32_t>(i), i);
-        std::vector<Vehicle::spdu_fragment> resend_queue;
-        for (auto &fragment : fragments) {
-            if (drop_rate > 0.0 && dist(rng) < drop_rate) {
-                dropped_fragments++;
-                resend_queue.push_back(fragment);
-                continue;
-            }
-            if (sendto(sockfd,
-                       &fragment,
-                       sizeof(fragment),
-                       MSG_CONFIRM,
-                       reinterpret_cast<const struct sockaddr *>(&servaddr),
-                       sizeof(servaddr)) < 0) {
-                perror("sendto failed");
-                close(sockfd);
-                exit(EXIT_FAILURE);
-            }
-        }
-
-        if (!resend_queue.empty()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
-            for (auto &fragment : resend_queue) {
+    auto signer = make_signing_backend(tx.signing, private_ec_key.get(), cert_private_ec_key.get(), falcon_private_key);
+    const int pipeline_depth = static_cast<int>(std::max<std::size_t>(tx.signing.pipeline_depth, 1));
+    std::size_t signatures = 0;
+    std::chrono::steady_clock::duration signing_time{};
+    const auto transmit_start = std::chrono::steady_clock::now();
+
+    for (int first = 0; first < num_msgs; first += pipeline_depth) {
+        const int count = std::min(pipeline_depth, num_msgs - first);
+        const auto signing_start = std::chrono::steady_clock::now();
+        auto batch = prepare_signed_batch(*signer, static_cast<uint32_t>(first), count);
+        signing_time += std::chrono::steady_clock::now() - signing_start;
+        signatures += 2 * static_cast<std::size_t>(count);
+
+        for (auto &fragments : batch) {
+            std::vector<Vehicle::spdu_fragment> resend_queue;
+            for (auto &fragment : fragments) {
+                if (drop_rate > 0.0 && dist(rng) < drop_rate) {
+                    dropped_fragments++;
+                    resend_queue.push_back(fragment);
+                    continue;
+                }
+                fragment.sent_us = epoch_us();
                 if (sendto(sockfd,
                            &fragment,
                            sizeof(fragment),
                            MSG_CONFIRM,
                            reinterpret_cast<const struct sockaddr *>(&servaddr),
                            sizeof(servaddr)) < 0) {
-                    perror("resend sendto failed");
+                    perror("sendto failed");
                     close(sockfd);
                     exit(EXIT_FAILURE);
                 }
-                resent_fragments++;
+            }
+
+            if (!resend_queue.empty()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                for (auto &fragment : resend_queue) {
+                    fragment.sent_us = epoch_us();
+                    if (sendto(sockfd,
+                               &fragment,
+                               sizeof(fragment),
+                               MSG_CONFIRM,
+                               reinterpret_cast<const struct sockaddr *>(&servaddr),
+                               sizeof(servaddr)) < 0) {
+                        perror("resend sendto failed");
+                        close(sockfd);
+                        exit(EXIT_FAILURE);
+                    }
+                    resent_fragments++;
+                }
+            }
+            if (tx.interval.count() > 0) {
+                std::this_thread::sleep_for(tx.interval);
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     close(sockfd);
 
+    const resource_usage usage = meter.usage();
+    record_resource_usage("transmitter", "vehicle" + std::to_string(number), static_cast<int>(pqc.scheme),
+                          meter.wall_us(), usage);
+
+    const double signing_seconds = std::chrono::duration<double>(signing_time).count();
+    const double transmit_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - transmit_start).count();
+    std::cout << "SIGNING vehicle=" << static_cast<int>(number)
+              << " backend=" << signer->name()
+              << " pipeline=" << pipeline_depth
+              << " messages=" << num_msgs
+              << " signatures=" << signatures
+              << " sign_us=" << std::chrono::duration_cast<std::chrono::microseconds>(signing_time).count()
+              << " signatures_per_s=" << (signing_seconds > 0.0 ? signatures / signing_seconds : 0.0)
+              << " messages_per_s=" << (transmit_seconds > 0.0 ? num_msgs / transmit_seconds : 0.0)
+              << " cpus=" << describe_cpu_list(current_thread_cpus())
+              << " trace_stalls=" << trace->stalls()
+              << " cpu_us=" << usage.cpu_us
+              << " user_us=" << usage.user_us
+              << " sys_us=" << usage.system_us
+              << " context_switches=" << usage.voluntary_switches + usage.involuntary_switches
+              << std::endl;
+
     if (drop_rate > 0.0) {
         std::cout << "Transmitter dropped " << dropped_fragments
                   << " fragments at configured rate " << drop_rate
@@ -186,7 +364,7 @@ void Vehicle::transmit(int num_msgs, bool test) {
 
 void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
     int sockfd;
-    struct sockaddr_in servaddr, cliaddr;
+    struct sockaddr_in servaddr;
 
     if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
         perror("socket creation failed");
@@ -200,7 +378,6 @@ void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
     }
 
     std::memset(&servaddr, 0, sizeof(servaddr));
-    std::memset(&cliaddr, 0, sizeof(cliaddr));
 
     servaddr.sin_family = AF_INET;
     servaddr.sin_addr.s_addr = INADDR_ANY;
@@ -212,6 +389,25 @@ void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
         exit(EXIT_FAILURE);
     }
 
+    int timestamps = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps)) < 0) {
+        perror("setsockopt SO_TIMESTAMPNS failed");
+    }
+
+    if (rx.busy_poll) {
+        if (fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+            perror("fcntl O_NONBLOCK failed");
+            exit(EXIT_FAILURE);
+        }
+#ifdef SO_BUSY_POLL
+        if (rx.socket_busy_poll_us > 0 &&
+            setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &rx.socket_busy_poll_us, sizeof(rx.socket_busy_poll_us)) < 0) {
+            // raising the budget above net.core.busy_read needs CAP_NET_ADMIN; spinning in user space still works
+            perror("setsockopt SO_BUSY_POLL failed");
+        }
+#endif
+    }
+
     // GUI socket setup (unchanged from original implementation)
     int sockfd2;
     struct sockaddr_in servaddr2;
@@ -231,13 +427,12 @@ void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
     servaddr2.sin_port = htons(tkgui ? 9999 : 8888);
     servaddr2.sin_addr.s_addr = INADDR_ANY;
 
-    socklen_t len = sizeof(cliaddr);
-
     struct PendingMessage {
         Vehicle::spdu_fragment template_fragment{};
         std::vector<uint8_t> signature_buffer;
         std::vector<bool> fragments_received;
         timestamp first_fragment_time{};
+        perf_sample reassembly_perf{};      // summed over the message's fragments
     };
 
     std::unordered_map<uint64_t, PendingMessage> pending_messages;
@@ -250,20 +445,127 @@ void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
     const char *metrics_run_id = std::getenv("V2X_METRICS_RUN");
     const char *metrics_note = std::getenv("V2X_METRICS_NOTE");
 
+    receive_stats rx_stats;
+    const thread_usage_meter rx_meter;
+
+    // Verify a reassembled SPDU and hand it to the GUI and the log. Runs inline, or on the dispatcher's verifier
+    // threads, in which case the output is serialized here.
+    std::unique_ptr<psid_dispatcher> dispatcher;
+    if (rx.dispatch.enabled) {
+        dispatcher = std::make_unique<psid_dispatcher>(rx.dispatch);
+    }
+    std::unique_ptr<spdu_capture> capture;
+    if (rx.capture.enabled) {
+        capture = std::make_unique<spdu_capture>(rx.capture);
+    }
+    std::mutex output_mutex;
+    uint64_t dispatch_dropped = 0;
+    latency_budget budget;
+    auto capture_message = [&capture](const PendingMessage &message, timestamp receive_time, uint8_t vehicle_id,
+                                      uint8_t flags) {
+        const Vehicle::spdu_fragment &spdu = message.template_fragment;
+        capture_record record{};
+        record.receive_time_us = static_cast<uint64_t>(receive_time.time_since_epoch().count());
+        record.sequence_number = spdu.sequence_number;
+        record.certificate_signature_bytes = static_cast<uint16_t>(spdu.certificate_signature_buffer_length);
+        record.vehicle_id = vehicle_id;
+        record.signature_scheme = spdu.signature_scheme;
+        record.psid = spdu.data.signedData.tbsData.headerInfo.psid;
+        record.user_priority = spdu.user_priority;
+        record.flags = flags;
+        capture->append(record, &spdu.data, sizeof(spdu.data), message.signature_buffer.data(),
+                        std::min<std::size_t>(spdu.signature_buffer_length, message.signature_buffer.size()));
+    };
+    auto finish_message = [&](PendingMessage &message, timestamp receive_time, uint8_t vehicle_id) {
+        perf_sample verify_perf;
+        bool valid_spdu;
+        const int64_t verify_start_us = epoch_us();
+        {
+            perf_scope counters(perf_stage::verify, &verify_perf);
+            valid_spdu = verify_message(message.template_fragment,
+                                        message.signature_buffer,
+                                        receive_time,
+                                        vehicle_id);
+        }
+        const int64_t verify_end_us = epoch_us();
+
+        if (capture) {
+            capture_message(message, receive_time, vehicle_id, valid_spdu ? CAPTURE_VALID : 0);
+        }
+
+        std::lock_guard<std::mutex> guard(output_mutex);
+        if (tkgui || webgui) {
+            packed_bsm_for_gui data_for_gui = {
+                message.template_fragment.data.signedData.tbsData.message.latitude,
+                message.template_fragment.data.signedData.tbsData.message.longitude,
+                message.template_fragment.data.signedData.tbsData.message.elevation,
+                message.template_fragment.data.signedData.tbsData.message.speed,
+                message.template_fragment.data.signedData.tbsData.message.heading,
+                valid_spdu,
+                true,
+                7,
+                static_cast<float>(vehicle_id)
+            };
+            sendto(sockfd2,
+                   &data_for_gui,
+                   sizeof(data_for_gui),
+                   MSG_CONFIRM,
+                   reinterpret_cast<const struct sockaddr *>(&servaddr2),
+                   sizeof(servaddr2));
+        }
+
+        for (int i = 0; i < 80; i++) {
+            std::cout << "-";
+        }
+        std::cout << std::endl;
+        print_spdu(message.template_fragment, valid_spdu);
+        print_bsm(message.template_fragment);
+        if (perf_counters_active()) {
+            for (const auto &stage : {std::make_pair("reassembly", message.reassembly_perf),
+                                      std::make_pair("verify", verify_perf)}) {
+                std::cout << "PERF vehicle=" << static_cast<int>(vehicle_id)
+                          << " sequence=" << message.template_fragment.sequence_number
+                          << " stage=" << stage.first
+                          << stage.second
+                          << std::endl;
+            }
+        }
+
+        const Vehicle::spdu_fragment &spdu = message.template_fragment;
+        message_timestamps times;
+        times.generated_us = spdu.data.signedData.tbsData.headerInfo.timestamp.time_since_epoch().count();
+        times.sign_start_us = spdu.sign_start_us;
+        times.sign_end_us = spdu.sign_end_us;
+        times.sent_us = spdu.sent_us;   // of the fragment that arrived first
+        times.first_arrival_us = message.first_fragment_time.time_since_epoch().count();
+        times.completed_us = receive_time.time_since_epoch().count();
+        times.verify_start_us = verify_start_us;
+        times.verify_end_us = verify_end_us;
+        times.output_us = epoch_us();
+        budget.record(vehicle_id, spdu.sequence_number, spdu.signature_scheme, times);
+
+        // with the dispatcher, a message is done when its verifier finishes rather than when it arrives
+        last_completion_time = rx.dispatch.enabled ? std::chrono::time_point_cast<std::chrono::microseconds>(
+                                                         std::chrono::system_clock::now())
+                                                   : receive_time;
+    };
+
+    // bound and about to read: the launcher can start the transmitters now
+    signal_ready(ntohs(servaddr.sin_port));
+
     int completed_messages = 0;
     while (completed_messages < num_msgs) {
         Vehicle::spdu_fragment incoming{};
-        if (recvfrom(sockfd,
-                     &incoming,
-                     sizeof(incoming),
-                     0,
-                     reinterpret_cast<struct sockaddr *>(&cliaddr),
-                     &len) < 0) {
-            perror("recvfrom failed");
-            close(sockfd2);
-            close(sockfd);
-            exit(EXIT_FAILURE);
+        {
+            V2X_PROBE_SCOPE(receive_datagram);
+            if (receive_datagram(sockfd, &incoming, sizeof(incoming), rx, rx_stats) < 0) {
+                perror("recvmsg failed");
+                close(sockfd2);
+                close(sockfd);
+                exit(EXIT_FAILURE);
+            }
         }
+        V2X_PROBE_COUNT(fragments_received, 1);
 
         timestamp receive_time = std::chrono::time_point_cast<std::chrono::microseconds>(
             std::chrono::system_clock::now());
@@ -274,85 +576,101 @@ void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
         }
 
         const uint64_t key = make_message_key(incoming.vehicle_id, incoming.sequence_number);
-        auto &entry = pending_messages[key];
-
-        if (entry.signature_buffer.empty()) {
-            entry.template_fragment = incoming;
-            entry.template_fragment.fragment_index = 0;
-            entry.template_fragment.fragment_length = 0;
-            entry.template_fragment.signature_fragment.fill(0);
-            entry.signature_buffer.assign(static_cast<std::size_t>(incoming.signature_buffer_length), 0);
-            entry.fragments_received.assign(static_cast<std::size_t>(incoming.fragment_count), false);
-            entry.first_fragment_time = receive_time;
-        }
+        PendingMessage *pending;
+        bool complete;
+        perf_sample fragment_perf;
+        {
+            V2X_PROBE_SCOPE(reassembly);
+            perf_scope counters(perf_stage::reassembly, &fragment_perf);
+            pending = &pending_messages[key];
+            auto &entry = *pending;
+
+            if (entry.signature_buffer.empty()) {
+                entry.template_fragment = incoming;
+                entry.template_fragment.fragment_index = 0;
+                entry.template_fragment.fragment_length = 0;
+                entry.template_fragment.signature_fragment.fill(0);
+                entry.signature_buffer.assign(static_cast<std::size_t>(incoming.signature_buffer_length), 0);
+                entry.fragments_received.assign(static_cast<std::size_t>(incoming.fragment_count), false);
+                entry.first_fragment_time = receive_time;
+            }
 
-        if (incoming.fragment_index < entry.fragments_received.size()) {
-            if (!entry.fragments_received[incoming.fragment_index]) {
-                const std::size_t offset = static_cast<std::size_t>(incoming.signature_offset);
-                const std::size_t length = static_cast<std::size_t>(incoming.fragment_length);
-                if (offset + length <= entry.signature_buffer.size()) {
-                    std::copy_n(incoming.signature_fragment.begin(),
-                                length,
-                                entry.signature_buffer.begin() + static_cast<long>(offset));
-                    entry.fragments_received[incoming.fragment_index] = true;
+            if (incoming.fragment_index < entry.fragments_received.size()) {
+                if (!entry.fragments_received[incoming.fragment_index]) {
+                    const std::size_t offset = static_cast<std::size_t>(incoming.signature_offset);
+                    const std::size_t length = static_cast<std::size_t>(incoming.fragment_length);
+                    if (offset + length <= entry.signature_buffer.size()) {
+                        std::copy_n(incoming.signature_fragment.begin(),
+                                    length,
+                                    entry.signature_buffer.begin() + static_cast<long>(offset));
+                        entry.fragments_received[incoming.fragment_index] = true;
+                    }
+                } else {
+                    V2X_PROBE_COUNT(duplicate_fragments, 1);
                 }
             }
-        }
 
-        entry.template_fragment.data = incoming.data;
-        entry.template_fragment.signature_buffer_length = incoming.signature_buffer_length;
-        entry.template_fragment.certificate_signature_buffer_length = incoming.certificate_signature_buffer_length;
-        entry.template_fragment.signature_scheme = incoming.signature_scheme;
-        entry.template_fragment.fragment_count = incoming.fragment_count;
+            entry.template_fragment.data = incoming.data;
+            entry.template_fragment.signature_buffer_length = incoming.signature_buffer_length;
+            entry.template_fragment.certificate_signature_buffer_length = incoming.certificate_signature_buffer_length;
+            entry.template_fragment.signature_scheme = incoming.signature_scheme;
+            entry.template_fragment.fragment_count = incoming.fragment_count;
 
-        const bool complete = std::all_of(entry.fragments_received.begin(),
-                                          entry.fragments_received.end(),
-                                          [](bool received) { return received; });
+            complete = std::all_of(entry.fragments_received.begin(),
+                                   entry.fragments_received.end(),
+                                   [](bool received) { return received; });
+            V2X_PROBE_GAUGE(pending_messages, pending_messages.size());
+        }
+        pending->reassembly_perf += fragment_perf;
 
         if (!complete) {
             continue;
         }
 
-        bool valid_spdu = verify_message(entry.template_fragment,
-                                         entry.signature_buffer,
-                                         receive_time,
-                                         incoming.vehicle_id);
-
-        if (tkgui || webgui) {
-            packed_bsm_for_gui data_for_gui = {
-                entry.template_fragment.data.signedData.tbsData.message.latitude,
-                entry.template_fragment.data.signedData.tbsData.message.longitude,
-                entry.template_fragment.data.signedData.tbsData.message.elevation,
-                entry.template_fragment.data.signedData.tbsData.message.speed,
-                entry.template_fragment.data.signedData.tbsData.message.heading,
-                valid_spdu,
-                true,
-                7,
-                static_cast<float>(incoming.vehicle_id)
-            };
-            sendto(sockfd2,
-                   &data_for_gui,
-                   sizeof(data_for_gui),
-                   MSG_CONFIRM,
-                   reinterpret_cast<const struct sockaddr *>(&servaddr2),
-                   sizeof(servaddr2));
-        }
-
-        for (int i = 0; i < 80; i++) {
-            std::cout << "-";
-        }
-        std::cout << std::endl;
-        print_spdu(entry.template_fragment, valid_spdu);
-        print_bsm(entry.template_fragment);
-
         completed_messages++;
-        last_completion_time = receive_time;
+        V2X_PROBE_COUNT(messages_completed, 1);
+        if (dispatcher) {
+            auto message = std::make_shared<PendingMessage>(std::move(*pending));
+            const uint8_t psid = message->template_fragment.data.signedData.tbsData.headerInfo.psid;
+            const uint8_t priority = message->template_fragment.user_priority;
+            const uint8_t vehicle_id = incoming.vehicle_id;
+            if (!dispatcher->submit(psid, priority, [&finish_message, message, receive_time, vehicle_id]() {
+                    finish_message(*message, receive_time, vehicle_id);
+                })) {
+                dispatch_dropped++;
+                if (capture) {
+                    capture_message(*message, receive_time, vehicle_id, CAPTURE_DROPPED);
+                }
+            }
+        } else {
+            finish_message(*pending, receive_time, incoming.vehicle_id);
+        }
         pending_messages.erase(key);
     }
 
+    if (dispatcher) {
+        dispatcher->drain();
+        dispatcher->print_report();
+        dispatcher.reset();
+    }
+    if (capture) {
+        capture->close();
+    }
+    V2X_PROBE_REPORT();
+    budget.print_report();
+    if (const char *latency_path = std::getenv("V2X_LATENCY_FILE")) {
+        budget.write_csv(latency_path, metrics_run_id, metrics_note);
+    }
+
     close(sockfd2);
     close(sockfd);
 
+    // the receive loop itself, then the whole process (dispatcher, verifier and GUI work included)
+    const resource_usage rx_usage = rx_meter.usage();
+    const resource_usage process_usage = process_resource_usage();
+    record_resource_usage("receiver", "receiver", static_cast<int>(pqc.scheme), rx_meter.wall_us(), rx_usage);
+    record_resource_usage("receiver", "process", static_cast<int>(pqc.scheme), process_wall_us(), process_usage);
+
     if (first_fragment_seen) {
         auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(
             last_completion_time - first_fragment_time).count();
@@ -379,7 +697,45 @@ void Vehicle::receive(int num_msgs, bool test, bool tkgui, bool webgui) {
                   << " total_us=" << total_duration
                   << " first_us=" << first_timestamp
                   << " last_us=" << last_timestamp
-                  << std::endl;
+                  << " falcon_kernel=" << active_crypto_kernels().falcon_name
+                  << " hash_kernel=" << active_crypto_kernels().hash_name
+                  << " verify=" << (verify_offload ? "offload" : "local")
+                  << " verify_fallbacks=" << (verify_offload ? verify_offload->local_fallbacks() : 0)
+                  << " dispatch=" << (rx.dispatch.enabled ? "psid" : "inline")
+                  << " dispatch_dropped=" << dispatch_dropped
+                  << " capture_records=" << (capture ? capture->records() : 0)
+                  << " capture_dropped=" << (capture ? capture->dropped() : 0)
+                  << " rx_cpus=" << describe_cpu_list(current_thread_cpus())
+                  << " rx_cpu=" << sched_getcpu()
+                  << " rx_mode=" << (rx.busy_poll ? "busy_poll" : "blocking")
+                  << " rx_cpu_us=" << rx_usage.cpu_us
+                  << " rx_user_us=" << rx_usage.user_us
+                  << " rx_sys_us=" << rx_usage.system_us
+                  << " rx_voluntary_switches=" << rx_usage.voluntary_switches
+                  << " rx_involuntary_switches=" << rx_usage.involuntary_switches
+                  << " rx_minor_faults=" << rx_usage.minor_faults
+                  << " rx_major_faults=" << rx_usage.major_faults
+                  << " process_cpu_us=" << process_usage.cpu_us
+                  << " max_rss_kb=" << process_usage.max_rss_kb
+                  << " rx_spin_hits=" << rx_stats.spin_hits
+                  << " rx_parks=" << rx_stats.parks
+                  << " rx_wakeup_avg_us=" << (rx_stats.datagrams > 0 ? rx_stats.wakeup_total_us / rx_stats.datagrams : 0.0)
+                  << " rx_wakeup_max_us=" << rx_stats.wakeup_max_us
+                  << " perf=" << (current_perf_state() == perf_state::on ? "on" :
+                                  current_perf_state() == perf_state::unavailable ? "unavailable" : "off");
+        if (current_perf_state() == perf_state::on) {
+            // run totals over every message, inline or on the dispatcher's threads
+            for (perf_stage stage : {perf_stage::reassembly, perf_stage::verify, perf_stage::hash}) {
+                const perf_sample total = perf_stage_total(stage);
+                const std::string prefix = std::string(" ") + perf_stage_name(stage) + "_";
+                std::cout << prefix << "cycles=" << total.cycles
+                          << prefix << "instructions=" << total.instructions
+                          << prefix << "ipc=" << total.ipc()
+                          << prefix << "cache_misses=" << total.cache_misses
+                          << prefix << "branch_misses=" << total.branch_misses;
+            }
+        }
+        std::cout << std::endl;
     }
 
     exit(0);
@@ -396,34 +752,35 @@ void Vehicle::generate_spdu(Vehicle::spdu_fragment &spdu, uint32_t sequence_numb
     timestamp ts = std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now());
     spdu.data.signedData.tbsData.headerInfo.timestamp = ts;
 
-    spdu.data.signedData.cert = vehicle_certificate_ecdsa;
-
-    unsigned char certificate_digest[SHA256_DIGEST_LENGTH];
-    sha256sum(&spdu.data.signedData.cert, sizeof(spdu.data.signedData.cert), certificate_digest);
-    ecdsa_sign(certificate_digest, cert_private_ec_key, &certificate_buffer_length, certificate_signature);
+    if (!tx.psids.empty()) {
+        spdu.data.signedData.tbsData.headerInfo.psid = tx.psids[number % tx.psids.size()];
+        spdu.wsmp_t_header_length_and_psid = spdu.data.signedData.tbsData.headerInfo.psid;
+    }
+    if (!tx.priorities.empty()) {
+        spdu.user_priority = tx.priorities[number % tx.priorities.size()];
+    }
 
-    spdu.certificate_signature_buffer_length = certificate_buffer_length;
-    std::copy_n(certificate_signature,
-                certificate_buffer_length,
-                spdu.data.certificate_signature);
+    spdu.data.signedData.cert = vehicle_certificate_ecdsa;
 }
 
 bsm Vehicle::generate_bsm(int timestep) {
-    float latitude = this->timestep[timestep][0];
-    float longitude = this->timestep[timestep][1];
-    float elevation = this->timestep[timestep][2];
+    const trace_row current = trace->row(static_cast<std::size_t>(timestep));
+    float latitude = current.x;
+    float longitude = current.y;
+    float elevation = current.z;
     float speed = 0;
     float heading = 0;
     if (timestep != 0) {
-        speed = calculate_speed_kph(this->timestep[timestep - 1][0],
+        const trace_row previous = trace->row(static_cast<std::size_t>(timestep) - 1);
+        speed = calculate_speed_kph(previous.x,
                                     latitude,
-                                    this->timestep[timestep - 1][1],
+                                    previous.y,
                                     longitude,
                                     100);
 
-        heading = calculate_heading(this->timestep[timestep - 1][0],
+        heading = calculate_heading(previous.x,
                                     latitude,
-                                    this->timestep[timestep - 1][1],
+                                    previous.y,
                                     longitude);
     }
     std::cout << "Calculated heading:\t" << heading << std::endl;
@@ -454,61 +811,32 @@ void Vehicle::print_spdu(Vehicle::spdu_fragment &spdu, bool valid) {
     std::cout << "\tSent:\t" << std::chrono::system_clock::to_time_t(spdu.data.signedData.tbsData.headerInfo.timestamp) << std::endl;
 }
 
-void Vehicle::sign_message_ecdsa(Vehicle::spdu_fragment &spdu) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    sha256sum(&spdu.data.signedData.tbsData, sizeof(spdu.data.signedData.tbsData), hash);
-
-    unsigned int signature_length = ECDSA_size(private_ec_key);
-    if (signature_length > MAX_SIGNATURE_FRAGMENT_SIZE) {
-        std::cerr << "ECDSA signature exceeds maximum fragment size" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    auto signature = std::vector<unsigned char>(signature_length, 0);
-    ecdsa_sign(hash, private_ec_key, &signature_length, signature.data());
-
-    spdu.signature_buffer_length = signature_length;
-    spdu.fragment_count = 1;
-    spdu.fragment_index = 0;
-    spdu.fragment_length = signature_length;
-    spdu.signature_offset = 0;
-    spdu.signature_fragment.fill(0);
-    std::copy(signature.begin(), signature.end(), spdu.signature_fragment.begin());
-}
-
-std::vector<Vehicle::spdu_fragment> Vehicle::sign_message_falcon(const Vehicle::spdu_fragment &spdu) {
-    if (falcon_private_key.empty()) {
-        std::cerr << "Falcon private key not loaded" << std::endl;
+std::vector<Vehicle::spdu_fragment> Vehicle::fragment_signature(const Vehicle::spdu_fragment &spdu,
+                                                                const std::vector<uint8_t> &signature) {
+    if (signature.size() > MAX_SIGNATURE_TOTAL_SIZE) {
+        std::cerr << "Signature exceeds maximum total size" << std::endl;
         exit(EXIT_FAILURE);
     }
 
-    std::vector<uint8_t> message(sizeof(spdu.data.signedData.tbsData), 0);
-    std::memcpy(message.data(), &spdu.data.signedData.tbsData, message.size());
-
-    std::vector<uint8_t> signature(MAX_SIGNATURE_TOTAL_SIZE, 0);
-    size_t signature_len = signature.size();
-    falcon_sign(signature.data(),
-                signature_len,
-                message.data(),
-                message.size(),
-                falcon_private_key.data());
-    signature.resize(signature_len);
-
-    const std::size_t fragment_size = clamp_fragment_size(pqc.falcon_fragment_size, MAX_SIGNATURE_FRAGMENT_SIZE);
-    const std::size_t fragment_count = (signature_len + fragment_size - 1) / fragment_size;
+    // ECDSA signatures always travel in a single fragment; Falcon signatures are split at the configured size
+    const std::size_t signature_len = signature.size();
+    const std::size_t fragment_size = spdu.signature_scheme == static_cast<uint8_t>(signature_scheme::FALCON)
+                                      ? clamp_fragment_size(pqc.falcon_fragment_size, MAX_SIGNATURE_FRAGMENT_SIZE)
+                                      : MAX_SIGNATURE_FRAGMENT_SIZE;
+    const std::size_t fragment_count = std::max<std::size_t>((signature_len + fragment_size - 1) / fragment_size, 1);
 
     std::vector<Vehicle::spdu_fragment> fragments;
     fragments.reserve(fragment_count);
 
     for (std::size_t idx = 0; idx < fragment_count; ++idx) {
         Vehicle::spdu_fragment fragment = spdu;
-        fragment.signature_scheme = static_cast<uint8_t>(signature_scheme::FALCON);
         fragment.fragment_count = static_cast<uint16_t>(fragment_count);
         fragment.fragment_index = static_cast<uint16_t>(idx);
         fragment.signature_buffer_length = static_cast<unsigned int>(signature_len);
         fragment.signature_offset = static_cast<unsigned int>(idx * fragment_size);
 
-        const std::size_t remaining = signature_len - static_cast<std::size_t>(fragment.signature_offset);
+        const std::size_t remaining = signature_len - std::min(signature_len,
+                                                               static_cast<std::size_t>(fragment.signature_offset));
         const std::size_t bytes_this_fragment = std::min(fragment_size, remaining);
         fragment.fragment_length = static_cast<unsigned int>(bytes_this_fragment);
         fragment.signature_fragment.fill(0);
@@ -526,157 +854,45 @@ bool Vehicle::verify_message(Vehicle::spdu_fragment &spdu,
                              const std::vector<uint8_t> &assembled_signature,
                              timestamp received_time,
                              int vehicle_id) {
-    EC_KEY *verification_private_ec_key = nullptr;
-    EC_KEY *verification_cert_private_ec_key = nullptr;
-
-    load_key(vehicle_id, false, verification_private_ec_key);
-    load_key(vehicle_id, true, verification_cert_private_ec_key);
-
-    unsigned char certificate_hash[SHA256_DIGEST_LENGTH];
-    sha256sum(&spdu.data.signedData.cert,
-              sizeof(spdu.data.signedData.cert),
-              certificate_hash);
-    bool cert_result = ecdsa_verify(certificate_hash,
-                                    spdu.data.certificate_signature,
-                                    &spdu.certificate_signature_buffer_length,
-                                    verification_cert_private_ec_key);
-
-    bool sig_result = false;
-    auto scheme = static_cast<signature_scheme>(spdu.signature_scheme);
-
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    sha256sum(&spdu.data.signedData.tbsData,
-              sizeof(spdu.data.signedData.tbsData),
-              hash);
-
-    if (scheme == signature_scheme::ECDSA) {
-        sig_result = ecdsa_verify(hash,
-                                  const_cast<unsigned char *>(assembled_signature.data()),
-                                  &spdu.signature_buffer_length,
-                                  verification_private_ec_key);
-    } else {
-        std::vector<uint8_t> public_key;
-        load_falcon_public_key(vehicle_id, public_key);
-        std::vector<uint8_t> message(sizeof(spdu.data.signedData.tbsData), 0);
-        std::memcpy(message.data(), &spdu.data.signedData.tbsData, message.size());
-        sig_result = falcon_verify(message.data(),
-                                   message.size(),
-                                   const_cast<uint8_t *>(assembled_signature.data()),
-                                   assembled_signature.size(),
-                                   public_key.data());
-    }
-
-    if (verification_private_ec_key != nullptr) {
-        EC_KEY_free(verification_private_ec_key);
-    }
-    if (verification_cert_private_ec_key != nullptr) {
-        EC_KEY_free(verification_cert_private_ec_key);
-    }
+    V2X_PROBE_SCOPE(verify_message);
+
+    auto check = [&](signature_scheme scheme, verification_key_kind kind, const void *message,
+                     std::size_t message_len, const uint8_t *signature, std::size_t signature_len) {
+        if (verify_offload) {
+            return verify_offload->verify(scheme, kind, static_cast<uint8_t>(vehicle_id),
+                                          static_cast<const uint8_t *>(message), message_len,
+                                          signature, signature_len);
+        }
+        return verify_signature(shared_verification_keys(), scheme, kind, vehicle_id,
+                                static_cast<const uint8_t *>(message), message_len,
+                                signature, signature_len);
+    };
+
+    bool cert_result = check(signature_scheme::ECDSA,
+                             verification_key_kind::CERTIFICATE,
+                             &spdu.data.signedData.cert,
+                             sizeof(spdu.data.signedData.cert),
+                             spdu.data.certificate_signature,
+                             spdu.certificate_signature_buffer_length);
+
+    // ECDSA signatures travel in a single fragment, so the assembled buffer holds exactly signature_buffer_length bytes
+    bool sig_result = check(static_cast<signature_scheme>(spdu.signature_scheme),
+                            verification_key_kind::MESSAGE,
+                            &spdu.data.signedData.tbsData,
+                            sizeof(spdu.data.signedData.tbsData),
+                            assembled_signature.data(),
+                            assembled_signature.size());
 
     std::chrono::duration<double, std::milli> elapsed_time =
         received_time - spdu.data.signedData.tbsData.headerInfo.timestamp;
     bool recent = elapsed_time.count() < 30000;
 
-    return cert_result && sig_result && recent;
-}
-
-void Vehicle::load_key(int number, bool certificate, EC_KEY *&key_to_store) {
-    std::string temp = certificate ? "cert_keys/" + std::to_string(number) + "/p256.key" :
-                                     "keys/" + std::to_string(number) + "/p256.key";
-
-    const char *filepath = temp.c_str();
-
-    FILE *fp = fopen(filepath, "r");
-    if (fp != nullptr) {
-        EVP_PKEY *key = nullptr;
-        PEM_read_PrivateKey(fp, &key, nullptr, nullptr);
-        key_to_store = nullptr;
-        if (!key) {
-            perror("Error while loading the key from file\n");
-            exit(EXIT_FAILURE);
-        }
-        if (!(key_to_store = EVP_PKEY_get1_EC_KEY(key))) {
-            perror("Error while getting EC key from loaded key\n");
-            exit(EXIT_FAILURE);
-        }
-        EVP_PKEY_free(key);
-        fclose(fp);
-    } else {
-        std::cout << filepath << std::endl;
-        std::cout << "Error while opening file from path. Error number : " << errno << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
-void Vehicle::load_falcon_private_key(int number) {
-    std::string path = "falcon_keys/" + std::to_string(number) + "/falcon.key";
-    std::ifstream key_file(path, std::ios::binary);
-    if (!key_file.is_open()) {
-        std::cerr << "Unable to open Falcon private key: " << path << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    std::string hex_key{std::istreambuf_iterator<char>(key_file), std::istreambuf_iterator<char>()};
-    try {
-        falcon_private_key = hex_to_bytes(hex_key);
-        if (falcon_private_key.size() != OQS_SIG_falcon_512_length_secret_key) {
-            std::cerr << "Unexpected Falcon private key length: " << falcon_private_key.size()
-                      << " (expected " << OQS_SIG_falcon_512_length_secret_key << ")" << std::endl;
-            exit(EXIT_FAILURE);
-        }
-    } catch (const std::exception &ex) {
-        std::cerr << "Failed to decode Falcon private key: " << ex.what() << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
-void Vehicle::load_falcon_public_key(int number, std::vector<uint8_t> &dest) {
-    static std::unordered_map<int, std::vector<uint8_t>> cache;
-    auto it = cache.find(number);
-    if (it != cache.end()) {
-        dest = it->second;
-        return;
-    }
-
-    std::string path = "falcon_keys/" + std::to_string(number) + "/falcon.pub";
-    std::ifstream key_file(path, std::ios::binary);
-    if (!key_file.is_open()) {
-        std::cerr << "Unable to open Falcon public key: " << path << std::endl;
-        exit(EXIT_FAILURE);
-    }
-
-    std::string hex_key{std::istreambuf_iterator<char>(key_file), std::istreambuf_iterator<char>()};
-    try {
-        auto buffer = hex_to_bytes(hex_key);
-        if (buffer.size() != OQS_SIG_falcon_512_length_public_key) {
-            std::cerr << "Unexpected Falcon public key length: " << buffer.size()
-                      << " (expected " << OQS_SIG_falcon_512_length_public_key << ")" << std::endl;
-            exit(EXIT_FAILURE);
-        }
-        cache[number] = buffer;
-        dest = std::move(buffer);
-    } catch (const std::exception &ex) {
-        std::cerr << "Failed to decode Falcon public key: " << ex.what() << std::endl;
-        exit(EXIT_FAILURE);
+    if (!(cert_result && sig_result && recent)) {
+        V2X_PROBE_COUNT(messages_invalid, 1);
     }
+    return cert_result && sig_result && recent;
 }
 
 void Vehicle::load_trace(int number) {
-    std::string line;
-    std::string word;
-
-    std::fstream file("trace_files/" + std::to_string(number) + ".csv", std::ios::in);
-    if (file.is_open()) {
-        while (getline(file, line)) {
-            timestep_data.clear();
-            std::stringstream str(line);
-            while (getline(str, word, ',')) {
-                timestep_data.push_back(std::stof(word));
-            }
-            timestep.push_back(timestep_data);
-        }
-    } else {
-        perror(("Error opening trace file for vehicle " + std::to_string(number)).c_str());
-        exit(EXIT_FAILURE);
-    }
+    trace = std::make_unique<trace_reader>("trace_files", number, tx.trace_window_rows);
 }
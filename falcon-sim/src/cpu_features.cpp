@@ -0,0 +1,50 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include "cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+cpu_features detect_cpu_features() {
+    cpu_features features;
+
+#if defined(__x86_64__) || defined(__i386__)
+    // __builtin_cpu_supports also checks that the OS saves the extended register state (XGETBV)
+    __builtin_cpu_init();
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.bmi2 = __builtin_cpu_supports("bmi2");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+    features.aes_ni = __builtin_cpu_supports("aes");
+
+    // SHA extensions are not exposed by __builtin_cpu_supports on older compilers: CPUID.(EAX=7,ECX=0):EBX[29]
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        features.sha_ni = (ebx & (1u << 29)) != 0;
+    }
+#endif
+
+    return features;
+}
+
+std::string describe_cpu_features(const cpu_features &features) {
+    std::string description;
+    auto append = [&description](bool present, const char *name) {
+        if (!present) {
+            return;
+        }
+        if (!description.empty()) {
+            description += ',';
+        }
+        description += name;
+    };
+
+    append(features.avx2, "avx2");
+    append(features.bmi2, "bmi2");
+    append(features.avx512f, "avx512f");
+    append(features.aes_ni, "aes");
+    append(features.sha_ni, "sha");
+
+    return description.empty() ? "none" : description;
+}
@@ -0,0 +1,407 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "fcd_import.h"
+#include "trace_format.h"
+#include "trace_generator.h"
+
+namespace {
+
+constexpr double EARTH_RADIUS_M = 6371000;
+constexpr double DEGREES = M_PI / 180;
+
+struct xml_attribute {
+    std::string_view name;
+    std::string_view value;
+};
+
+// Just enough of a streaming XML reader for FCD output: reports the name and attributes of every start (or empty)
+// element and skips everything else. Only the current tag is held in memory.
+class xml_tag_scanner {
+public:
+    explicit xml_tag_scanner(FILE *input) : input(input), buffer(1u << 20) {}
+
+    uint64_t bytes_read() const {
+        return consumed;
+    }
+
+    template <typename Handler>
+    void run(Handler &&on_element) {
+        std::size_t filled = 0;
+        bool eof = false;
+        while (!eof || filled > 0) {
+            if (!eof) {
+                if (filled == buffer.size()) {
+                    buffer.resize(buffer.size() * 2);       // a single tag larger than the buffer
+                }
+                const std::size_t count = std::fread(buffer.data() + filled, 1, buffer.size() - filled, input);
+                if (count == 0) {
+                    if (std::ferror(input)) {
+                        perror("Error reading FCD input");
+                        exit(EXIT_FAILURE);
+                    }
+                    eof = true;
+                }
+                filled += count;
+                consumed += count;
+            }
+
+            std::size_t position = 0;
+            for (;;) {
+                const char *open = static_cast<const char *>(std::memchr(buffer.data() + position, '<',
+                                                                         filled - position));
+                if (open == nullptr) {
+                    position = filled;                       // character data between tags
+                    break;
+                }
+                const std::size_t start = static_cast<std::size_t>(open - buffer.data());
+                const std::string_view rest(open, filled - start);
+                std::size_t end;
+                std::size_t terminator = 1;
+                if (rest.size() < 4 && !eof) {
+                    end = std::string_view::npos;           // too short to tell a comment from a tag yet
+                } else if (rest.compare(0, 4, "<!--") == 0) {
+                    end = rest.find("-->", 4);
+                    terminator = 3;
+                } else {
+                    end = rest.find('>');
+                }
+                if (end == std::string_view::npos) {
+                    if (eof) {
+                        std::cerr << "FCD input ends inside a tag at byte " << consumed - (filled - start) << std::endl;
+                        exit(EXIT_FAILURE);
+                    }
+                    position = start;                        // incomplete tag: keep it for the next read
+                    break;
+                }
+                handle_tag(rest.substr(1, end - 1), on_element);
+                position = start + end + terminator;
+            }
+
+            std::memmove(buffer.data(), buffer.data() + position, filled - position);
+            filled -= position;
+        }
+    }
+
+private:
+    template <typename Handler>
+    void handle_tag(std::string_view tag, Handler &on_element) {
+        if (tag.empty() || tag[0] == '/' || tag[0] == '?' || tag[0] == '!') {
+            return;
+        }
+        std::size_t i = 0;
+        while (i < tag.size() && !is_space(tag[i]) && tag[i] != '/') {
+            i++;
+        }
+        const std::string_view name = tag.substr(0, i);
+
+        attributes.clear();
+        for (;;) {
+            while (i < tag.size() && is_space(tag[i])) {
+                i++;
+            }
+            if (i >= tag.size() || tag[i] == '/') {
+                break;
+            }
+            const std::size_t name_start = i;
+            while (i < tag.size() && tag[i] != '=' && !is_space(tag[i])) {
+                i++;
+            }
+            const std::string_view attribute = tag.substr(name_start, i - name_start);
+            while (i < tag.size() && is_space(tag[i])) {
+                i++;
+            }
+            if (i + 1 >= tag.size() || tag[i] != '=') {
+                malformed(tag);
+            }
+            i++;
+            while (i < tag.size() && is_space(tag[i])) {
+                i++;
+            }
+            if (i >= tag.size() || (tag[i] != '"' && tag[i] != '\'')) {
+                malformed(tag);
+            }
+            const char quote = tag[i++];
+            const std::size_t value_end = tag.find(quote, i);
+            if (value_end == std::string_view::npos) {
+                malformed(tag);
+            }
+            attributes.push_back({attribute, tag.substr(i, value_end - i)});
+            i = value_end + 1;
+        }
+        on_element(name, attributes);
+    }
+
+    static bool is_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    [[noreturn]] void malformed(std::string_view tag) const {
+        std::cerr << "Malformed FCD tag near byte " << consumed << ": <"
+                  << tag.substr(0, std::min<std::size_t>(tag.size(), 80)) << ">" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *input;
+    std::vector<char> buffer;
+    std::vector<xml_attribute> attributes;
+    uint64_t consumed = 0;
+};
+
+std::string_view find_attribute(const std::vector<xml_attribute> &attributes, std::string_view name) {
+    for (const auto &attribute : attributes) {
+        if (attribute.name == name) {
+            return attribute.value;
+        }
+    }
+    return {};
+}
+
+bool parse_number(std::string_view text, double &value) {
+    if (text.empty()) {
+        return false;
+    }
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Replace the predefined XML entities (SUMO escapes ids that contain &, <, >, " or ').
+void decode_entities(std::string_view text, std::string &out) {
+    out.clear();
+    for (std::size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '&') {
+            static constexpr std::pair<std::string_view, char> entities[] = {
+                {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}};
+            bool replaced = false;
+            for (const auto &entity : entities) {
+                if (text.compare(i, entity.first.size(), entity.first) == 0) {
+                    out.push_back(entity.second);
+                    i += entity.first.size() - 1;
+                    replaced = true;
+                    break;
+                }
+            }
+            if (replaced) {
+                continue;
+            }
+        }
+        out.push_back(text[i]);
+    }
+}
+
+struct fcd_vehicle {
+    std::string id;
+    bool created = false;               // trace file written (with its header) at least once
+    double first_time = 0;
+    double last_time = 0;
+    uint64_t rows = 0;                  // rows emitted; row k is at first_time + k * tick
+    trace_row last{};
+    std::vector<trace_row> pending;
+};
+
+class fcd_importer {
+public:
+    explicit fcd_importer(const fcd_import_options &options) : options(options) {}
+
+    void on_element(std::string_view name, const std::vector<xml_attribute> &attributes) {
+        if (name == "timestep") {
+            if (!parse_number(find_attribute(attributes, "time"), time)) {
+                std::cerr << "FCD timestep without a valid time attribute" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            timesteps++;
+        } else if (name == "vehicle") {
+            on_vehicle(attributes);
+        }
+    }
+
+    void finish() {
+        flush();
+
+        const std::string index_path = options.directory + "/fcd_ids.csv";
+        std::ofstream index(index_path);
+        for (std::size_t i = 0; i < vehicles.size(); i++) {
+            index << i << "," << vehicles[i].id << "\n";
+        }
+        if (!index.good()) {
+            perror(("Error writing " + index_path).c_str());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint64_t timesteps = 0;
+    uint64_t samples = 0;
+    uint64_t rows = 0;
+    std::size_t vehicle_count() const {
+        return vehicles.size();
+    }
+
+private:
+    void on_vehicle(const std::vector<xml_attribute> &attributes) {
+        double x, y, speed, angle;
+        double z = 0;
+        if (!parse_number(find_attribute(attributes, "x"), x) || !parse_number(find_attribute(attributes, "y"), y) ||
+            !parse_number(find_attribute(attributes, "speed"), speed) ||
+            !parse_number(find_attribute(attributes, "angle"), angle)) {
+            std::cerr << "FCD vehicle without valid x, y, speed and angle attributes at time " << time << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        const std::string_view z_text = find_attribute(attributes, "z");
+        if (!z_text.empty() && !parse_number(z_text, z)) {
+            std::cerr << "FCD vehicle with an invalid z attribute at time " << time << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        samples++;
+
+        if (options.projection == fcd_projection::GEO) {
+            if (!origin_known) {
+                origin_latitude = y;
+                origin_longitude = x;
+                origin_known = true;
+            }
+            const double longitude = x, latitude = y;
+            x = EARTH_RADIUS_M * (longitude - origin_longitude) * DEGREES * std::cos(origin_latitude * DEGREES);
+            y = EARTH_RADIUS_M * (latitude - origin_latitude) * DEGREES;
+        }
+
+        // SUMO angles are compass bearings (0 = north, clockwise); trace headings follow calculate_heading
+        double heading = 90 - angle;
+        heading = std::remainder(heading, 360.0);
+        const trace_row sample = {static_cast<float>(x), static_cast<float>(y), static_cast<float>(z),
+                                  static_cast<float>(speed * 3.6), static_cast<float>(heading)};
+
+        decode_entities(find_attribute(attributes, "id"), id);
+        auto found = numbers.find(id);
+        if (found == numbers.end()) {
+            found = numbers.emplace(id, vehicles.size()).first;
+            vehicles.emplace_back();
+            vehicles.back().id = id;
+            vehicles.back().first_time = time;
+            vehicles.back().last_time = time;
+            vehicles.back().last = sample;
+            emit(vehicles.back(), sample);
+            return;
+        }
+
+        fcd_vehicle &vehicle = vehicles[found->second];
+        if (time <= vehicle.last_time) {
+            vehicle.last = sample;
+            return;
+        }
+        const double tick = TRACE_TICK_MS / 1000;
+        for (double row_time = vehicle.first_time + static_cast<double>(vehicle.rows) * tick;
+             row_time <= time + 1e-9;
+             row_time = vehicle.first_time + static_cast<double>(vehicle.rows) * tick) {
+            const auto f = static_cast<float>((row_time - vehicle.last_time) / (time - vehicle.last_time));
+            const trace_row &from = vehicle.last;
+            emit(vehicle, {from.x + (sample.x - from.x) * f,
+                           from.y + (sample.y - from.y) * f,
+                           from.z + (sample.z - from.z) * f,
+                           from.speed_kph + (sample.speed_kph - from.speed_kph) * f,
+                           f < 0.5f ? from.heading : sample.heading});
+        }
+        vehicle.last_time = time;
+        vehicle.last = sample;
+    }
+
+    void emit(fcd_vehicle &vehicle, const trace_row &row) {
+        vehicle.pending.push_back(row);
+        vehicle.rows++;
+        rows++;
+        buffered += sizeof(trace_row);
+        if (buffered >= options.buffer_bytes) {
+            flush();
+        }
+    }
+
+    void flush() {
+        for (std::size_t i = 0; i < vehicles.size(); i++) {
+            fcd_vehicle &vehicle = vehicles[i];
+            if (vehicle.pending.empty()) {
+                continue;
+            }
+            write_binary_trace(options.directory + "/" + std::to_string(i) + ".bin", vehicle.pending,
+                               !vehicle.created);
+            vehicle.created = true;
+            std::vector<trace_row>().swap(vehicle.pending);
+        }
+        buffered = 0;
+    }
+
+    const fcd_import_options &options;
+    double time = 0;
+    bool origin_known = options.origin_set;
+    double origin_latitude = options.origin_latitude;
+    double origin_longitude = options.origin_longitude;
+    std::string id;
+    std::unordered_map<std::string, std::size_t> numbers;
+    std::vector<fcd_vehicle> vehicles;
+    std::size_t buffered = 0;
+};
+
+} // namespace
+
+fcd_projection parse_fcd_projection(const std::string &name) {
+    if (name == "none") {
+        return fcd_projection::NONE;
+    }
+    if (name == "geo") {
+        return fcd_projection::GEO;
+    }
+    std::cerr << "Unknown FCD projection '" << name << R"(' (expected "none" or "geo"))" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+void import_fcd(const fcd_import_options &options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    FILE *input = options.input == "-" ? stdin : std::fopen(options.input.c_str(), "rb");
+    if (input == nullptr) {
+        perror(("Error opening FCD file " + options.input).c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if (error) {
+        std::cerr << "Error creating trace directory " << options.directory << ": " << error.message() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    fcd_importer importer(options);
+    xml_tag_scanner scanner(input);
+    scanner.run([&importer](std::string_view name, const std::vector<xml_attribute> &attributes) {
+        importer.on_element(name, attributes);
+    });
+    if (input != stdin) {
+        std::fclose(input);
+    }
+    importer.finish();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const auto bytes = static_cast<double>(scanner.bytes_read());
+    std::cout << "IMPORT format=fcd input=" << options.input
+              << " projection=" << (options.projection == fcd_projection::GEO ? "geo" : "none")
+              << " bytes=" << scanner.bytes_read()
+              << " seconds=" << seconds
+              << " mb_per_s=" << (seconds > 0 ? bytes / 1e6 / seconds : 0.0)
+              << " timesteps=" << importer.timesteps
+              << " samples=" << importer.samples
+              << " vehicles=" << importer.vehicle_count()
+              << " rows=" << importer.rows
+              << " directory=" << options.directory
+              << std::endl;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "fleet_startup.h"
+#include "thread_affinity.h"
+
+namespace {
+std::chrono::microseconds elapsed_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+} // namespace
+
+startup_mode parse_startup_mode(const std::string &name) {
+    if (name == "sequential") {
+        return startup_mode::SEQUENTIAL;
+    }
+    if (name == "parallel") {
+        return startup_mode::PARALLEL;
+    }
+    if (name == "lazy") {
+        return startup_mode::LAZY;
+    }
+    std::cerr << "Unknown startup mode '" << name << R"(' (expected "sequential", "parallel" or "lazy"))" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+const char *startup_mode_name(startup_mode mode) {
+    switch (mode) {
+        case startup_mode::SEQUENTIAL:
+            return "sequential";
+        case startup_mode::PARALLEL:
+            return "parallel";
+        case startup_mode::LAZY:
+            return "lazy";
+    }
+    return "unknown";
+}
+
+std::vector<Vehicle> create_fleet(int num_vehicles,
+                                  const pqc_options &pqc_opts,
+                                  const transmit_options &tx_opts,
+                                  const startup_options &options,
+                                  startup_report &report) {
+    const auto construct_start = std::chrono::steady_clock::now();
+    std::vector<Vehicle> vehicles;
+    vehicles.reserve(static_cast<std::size_t>(std::max(num_vehicles, 0)));
+    for (int i = 0; i < num_vehicles; i++) {
+        vehicles.emplace_back(i, pqc_opts);
+        vehicles.back().configure_transmit(tx_opts);
+    }
+    report.construct = elapsed_since(construct_start);
+
+    const auto load_start = std::chrono::steady_clock::now();
+    if (options.mode == startup_mode::SEQUENTIAL) {
+        for (auto &vehicle : vehicles) {
+            vehicle.load();
+        }
+        report.threads = 1;
+    } else if (options.mode == startup_mode::PARALLEL && !vehicles.empty()) {
+        unsigned threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min<unsigned>(threads, static_cast<unsigned>(vehicles.size()));
+
+        // vehicles are handed out one at a time, so a slow trace file does not hold up a whole slice of the fleet
+        std::atomic<std::size_t> next{0};
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads; t++) {
+            pool.emplace_back([&vehicles, &next, &options, t]() {
+                pin_current_thread_round_robin(options.cpus, t);
+                for (std::size_t i = next++; i < vehicles.size(); i = next++) {
+                    vehicles[i].load();
+                }
+            });
+        }
+        for (auto &worker : pool) {
+            worker.join();
+        }
+        report.threads = threads;
+    } else if (options.mode == startup_mode::LAZY) {
+        report.threads = static_cast<unsigned>(vehicles.size());     // each transmitter thread loads its own vehicle
+    }
+    report.load = options.mode == startup_mode::LAZY ? std::chrono::microseconds{0} : elapsed_since(load_start);
+
+    return vehicles;
+}
+
+void print_startup_report(const std::vector<Vehicle> &vehicles,
+                          const startup_options &options,
+                          const startup_report &report) {
+    startup_timing total{};
+    for (const auto &vehicle : vehicles) {
+        total.keys += vehicle.startup().keys;
+        total.trace += vehicle.startup().trace;
+        total.falcon += vehicle.startup().falcon;
+    }
+
+    std::cout << "STARTUP mode=" << startup_mode_name(options.mode)
+              << " vehicles=" << vehicles.size()
+              << " threads=" << report.threads
+              << " construct_us=" << report.construct.count()
+              << " load_us=" << report.load.count()
+              << " keys_us=" << total.keys.count()
+              << " trace_us=" << total.trace.count()
+              << " falcon_us=" << total.falcon.count()
+              << std::endl;
+}
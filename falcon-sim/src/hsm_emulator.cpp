@@ -0,0 +1,292 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "hsm_protocol.h"
+#include "signing_backend.h"
+#include "thread_affinity.h"
+
+namespace {
+// Shared by the connection's reader and every job it has queued, so the descriptor stays valid until the last
+// signature for it has been written, and is closed then.
+struct hsm_connection {
+    int fd;
+    std::mutex write_mutex;     // engines answering this connection's jobs write one response at a time
+
+    explicit hsm_connection(int fd) : fd(fd) {}
+    hsm_connection(const hsm_connection &) = delete;
+    hsm_connection &operator=(const hsm_connection &) = delete;
+    ~hsm_connection() { close(fd); }
+};
+
+struct hsm_job {
+    std::shared_ptr<hsm_connection> connection;
+    hsm_request_header header{};
+    std::vector<uint8_t> payload;
+    std::chrono::steady_clock::time_point received;
+};
+
+// The emulated device: a queue of pending requests served by `concurrency` engines, each of which holds a request
+// for at least the configured latency.
+class hsm_device {
+
+public:
+    explicit hsm_device(const hsm_emulator_options &options) : options(options) {}
+
+    void submit(hsm_job job) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            jobs.push_back(std::move(job));
+            requests++;
+            max_queue_depth = std::max(max_queue_depth, jobs.size());
+        }
+        ready.notify_one();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+    }
+
+    void run_engine() {
+        for (;;) {
+            hsm_job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            const auto started = std::chrono::steady_clock::now();
+            auto scheme = static_cast<signature_scheme>(job.header.scheme);
+            auto kind = static_cast<verification_key_kind>(job.header.key_kind);
+            std::vector<uint8_t> signature;
+            uint32_t status = HSM_STATUS_OK;
+            std::chrono::microseconds latency{0};
+            if (scheme == signature_scheme::FALCON && kind == verification_key_kind::MESSAGE) {
+                signature = falcon_sign_message(job.payload.data(), job.payload.size(), falcon_key(job.header.key_id));
+                latency = options.falcon_latency;
+            } else if (job.payload.size() != HSM_ECDSA_DIGEST_BYTES) {
+                status = HSM_STATUS_BAD_REQUEST;
+            } else {
+                // the cache loads the vehicles' private PEM keys, which is what the device signs with
+                signature = ecdsa_sign_digest(job.payload.data(), ecdsa_keys.ecdsa_key(job.header.key_id, kind));
+                latency = options.ecdsa_latency;
+            }
+            if (status == HSM_STATUS_OK && (signature.empty() || signature.size() > HSM_MAX_SIGNATURE)) {
+                status = HSM_STATUS_SIGN_FAILED;
+            }
+            if (status != HSM_STATUS_OK) {
+                signature.clear();
+                failed_count++;
+            }
+            std::this_thread::sleep_until(started + latency);
+            const auto finished = std::chrono::steady_clock::now();
+
+            hsm_response_header response{};
+            response.request_id = job.header.request_id;
+            response.status = status;
+            response.signature_len = static_cast<uint32_t>(signature.size());
+            {
+                std::lock_guard<std::mutex> guard(job.connection->write_mutex);
+                if (hsm_write_full(job.connection->fd, &response, sizeof(response))) {
+                    hsm_write_full(job.connection->fd, signature.data(), signature.size());
+                }
+            }
+
+            signed_count++;
+            busy_us += std::chrono::duration_cast<std::chrono::microseconds>(finished - started).count();
+            queued_us += std::chrono::duration_cast<std::chrono::microseconds>(started - job.received).count();
+        }
+    }
+
+    void print_summary(std::chrono::steady_clock::duration uptime) const {
+        const auto uptime_us = std::max<long long>(
+            1, std::chrono::duration_cast<std::chrono::microseconds>(uptime).count());
+        const uint64_t completed = signed_count.load();
+        std::cout << "HSM requests=" << requests
+                  << " signed=" << completed - failed_count.load()
+                  << " failed=" << failed_count.load()
+                  << " max_queue=" << max_queue_depth
+                  << " avg_queue_us=" << (completed > 0 ? queued_us.load() / completed : 0)
+                  << " utilization=" << static_cast<double>(busy_us.load()) /
+                                        (static_cast<double>(uptime_us) * static_cast<double>(options.concurrency))
+                  << std::endl;
+    }
+
+private:
+    const std::vector<uint8_t> &falcon_key(int number) {
+        std::lock_guard<std::mutex> guard(key_mutex);
+        auto it = falcon_keys.find(number);
+        if (it != falcon_keys.end()) {
+            return it->second;
+        }
+        return falcon_keys.emplace(number, load_falcon_key(number, true)).first->second;
+    }
+
+    hsm_emulator_options options;
+    verification_key_cache ecdsa_keys;
+    std::mutex key_mutex;
+    std::unordered_map<int, std::vector<uint8_t>> falcon_keys;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<hsm_job> jobs;
+    bool stopping = false;
+    uint64_t requests = 0;
+    std::size_t max_queue_depth = 0;
+    std::atomic<uint64_t> signed_count{0};       // answered, including failures
+    std::atomic<uint64_t> failed_count{0};
+    std::atomic<uint64_t> busy_us{0};
+    std::atomic<uint64_t> queued_us{0};
+};
+
+void serve_connection(const std::shared_ptr<hsm_connection> &connection, hsm_device &device) {
+    for (;;) {
+        hsm_job job;
+        if (!hsm_read_full(connection->fd, &job.header, sizeof(job.header)) ||
+            job.header.payload_len > HSM_MAX_PAYLOAD) {
+            return;
+        }
+        job.payload.assign(job.header.payload_len, 0);
+        if (!hsm_read_full(connection->fd, job.payload.data(), job.payload.size())) {
+            return;
+        }
+        job.connection = connection;
+        job.received = std::chrono::steady_clock::now();
+        device.submit(std::move(job));
+    }
+}
+} // namespace
+
+void run_hsm_emulator(const hsm_emulator_options &options) {
+    int listen_fd;
+    if ((listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        perror("HSM socket creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, options.socket_path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(options.socket_path.c_str()); // stale socket from an emulator that did not shut down cleanly
+    if (bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        perror("HSM socket bind failed");
+        exit(EXIT_FAILURE);
+    }
+    if (listen(listen_fd, 64) < 0) {
+        perror("HSM socket listen failed");
+        exit(EXIT_FAILURE);
+    }
+
+    signal(SIGPIPE, SIG_IGN); // a transmitter may hang up while its signatures are still being computed
+
+    sigset_t shutdown_signals;
+    sigemptyset(&shutdown_signals);
+    sigaddset(&shutdown_signals, SIGINT);
+    sigaddset(&shutdown_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdown_signals, nullptr);
+
+    hsm_device device(options);
+    const std::size_t engine_count = std::max<std::size_t>(options.concurrency, 1);
+    std::vector<std::thread> engines;
+    for (std::size_t i = 0; i < engine_count; i++) {
+        engines.emplace_back([&device, &options, i]() {
+            pin_current_thread_round_robin(options.cpus, i);
+            device.run_engine();
+        });
+    }
+
+    // Open connections, each served by a detached reader that removes its entry when the transmitter hangs up.
+    std::mutex connections_mutex;
+    std::condition_variable readers_done;
+    std::list<std::shared_ptr<hsm_connection>> connections;
+    std::atomic<bool> shutting_down{false};
+    std::thread acceptor([&]() {
+        for (;;) {
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                if (shutting_down) {
+                    return; // listening socket shut down
+                }
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    // out of descriptors or memory: wait for connections to close rather than stop serving
+                    perror("HSM accept failed, retrying");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    continue;
+                }
+                perror("HSM accept failed");
+                return;
+            }
+            auto connection = std::make_shared<hsm_connection>(fd);
+            std::list<std::shared_ptr<hsm_connection>>::iterator entry;
+            {
+                std::lock_guard<std::mutex> guard(connections_mutex);
+                entry = connections.insert(connections.end(), connection);
+            }
+            std::thread([&, connection, entry]() {
+                serve_connection(connection, device);
+                std::lock_guard<std::mutex> guard(connections_mutex);
+                connections.erase(entry);
+                readers_done.notify_all();
+            }).detach();
+        }
+    });
+
+    const auto started = std::chrono::steady_clock::now();
+    std::cout << "HSM emulator ready on " << options.socket_path
+              << " (concurrency=" << engine_count
+              << ", ecdsa_latency_us=" << options.ecdsa_latency.count()
+              << ", falcon_latency_us=" << options.falcon_latency.count()
+              << ", cpus=" << describe_cpu_list(options.cpus) << ")" << std::endl;
+
+    int received_signal = 0;
+    sigwait(&shutdown_signals, &received_signal);
+    const auto uptime = std::chrono::steady_clock::now() - started;
+
+    shutting_down = true;
+    shutdown(listen_fd, SHUT_RDWR);
+    acceptor.join();
+    {
+        std::unique_lock<std::mutex> lock(connections_mutex);
+        for (auto &connection : connections) {
+            shutdown(connection->fd, SHUT_RDWR);
+        }
+        readers_done.wait(lock, [&]() { return connections.empty(); });
+    }
+    device.stop();
+    for (auto &engine : engines) {
+        engine.join();
+    }
+    close(listen_fd);
+    unlink(options.socket_path.c_str());
+
+    device.print_summary(uptime);
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include "instrumentation.h"
+
+#ifdef V2X_INSTRUMENTATION
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char *const TIMER_NAMES[] = {"prepare_signed_batch", "falcon_sign", "ecdsa_sign", "receive_datagram",
+                                   "reassembly", "verify_message"};
+const char *const COUNTER_NAMES[] = {"fragments_received", "duplicate_fragments", "messages_completed",
+                                     "messages_invalid"};
+const char *const GAUGE_NAMES[] = {"pending_messages", "signature_bytes"};
+
+static_assert(sizeof(TIMER_NAMES) / sizeof(TIMER_NAMES[0]) == static_cast<std::size_t>(probe::count));
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<std::size_t>(probe_counter::count));
+static_assert(sizeof(GAUGE_NAMES) / sizeof(GAUGE_NAMES[0]) == static_cast<std::size_t>(probe_gauge::count));
+
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<instrumentation::thread_probes>> registry;
+
+// TSC reading at startup, to convert ticks to time over the whole run at report time
+const uint64_t start_ticks = instrumentation::read_tsc();
+const auto start_time = std::chrono::steady_clock::now();
+
+struct merged_histogram {
+    uint64_t buckets[instrumentation::HISTOGRAM_BUCKETS] = {};
+    uint64_t samples = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+
+    void add(const instrumentation::thread_probes::histogram &source) {
+        for (std::size_t i = 0; i < instrumentation::HISTOGRAM_BUCKETS; i++) {
+            buckets[i] += source.buckets[i].load(std::memory_order_relaxed);
+        }
+        samples += source.samples.load(std::memory_order_relaxed);
+        total += source.total.load(std::memory_order_relaxed);
+        max = std::max(max, source.max.load(std::memory_order_relaxed));
+    }
+
+    // Upper edge of the bucket holding the given quantile, capped at the largest value seen.
+    uint64_t quantile(double q) const {
+        const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(q * static_cast<double>(samples)), 1);
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < instrumentation::HISTOGRAM_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min(upper_edge(i), max);
+            }
+        }
+        return max;
+    }
+
+    static uint64_t upper_edge(std::size_t bucket) {
+        if (bucket < 8) {
+            return bucket;
+        }
+        const std::size_t exponent = bucket / 8 + 2;
+        const uint64_t lower = (8 + bucket % 8) << (exponent - 3);
+        return lower + (uint64_t{1} << (exponent - 3)) - 1;
+    }
+};
+
+} // namespace
+
+namespace instrumentation {
+
+thread_probes *register_thread() {
+    auto block = std::make_unique<thread_probes>();
+    thread_probes *raw = block.get();
+    std::lock_guard<std::mutex> guard(registry_mutex);
+    registry.push_back(std::move(block));
+    return raw;
+}
+
+void print_report() {
+    const double elapsed_us = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start_time).count();
+    const uint64_t elapsed_ticks = read_tsc() - start_ticks;
+    const double ticks_per_us = elapsed_us > 0 && elapsed_ticks > 0 ? elapsed_ticks / elapsed_us : 1.0;
+
+    std::vector<merged_histogram> timers(static_cast<std::size_t>(probe::count));
+    std::vector<uint64_t> counters(static_cast<std::size_t>(probe_counter::count), 0);
+    std::vector<merged_histogram> gauges(static_cast<std::size_t>(probe_gauge::count));
+    std::size_t threads;
+    {
+        std::lock_guard<std::mutex> guard(registry_mutex);
+        threads = registry.size();
+        for (const auto &block : registry) {
+            for (std::size_t i = 0; i < timers.size(); i++) {
+                timers[i].add(block->timers[i]);
+            }
+            for (std::size_t i = 0; i < counters.size(); i++) {
+                counters[i] += block->counters[i].load(std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < gauges.size(); i++) {
+                gauges[i].add(block->gauges[i]);
+            }
+        }
+    }
+
+    auto us = [ticks_per_us](double ticks) { return ticks / ticks_per_us; };
+    for (std::size_t i = 0; i < timers.size(); i++) {
+        const merged_histogram &timer = timers[i];
+        if (timer.samples == 0) {
+            continue;
+        }
+        std::cout << "PROBE timer=" << TIMER_NAMES[i]
+                  << " calls=" << timer.samples
+                  << " avg_us=" << us(static_cast<double>(timer.total) / timer.samples)
+                  << " p50_us=" << us(timer.quantile(0.50))
+                  << " p90_us=" << us(timer.quantile(0.90))
+                  << " p99_us=" << us(timer.quantile(0.99))
+                  << " max_us=" << us(timer.max)
+                  << " threads=" << threads
+                  << " ticks_per_us=" << ticks_per_us
+                  << std::endl;
+    }
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        if (counters[i] != 0) {
+            std::cout << "PROBE counter=" << COUNTER_NAMES[i] << " value=" << counters[i] << std::endl;
+        }
+    }
+    for (std::size_t i = 0; i < gauges.size(); i++) {
+        const merged_histogram &gauge = gauges[i];
+        if (gauge.samples == 0) {
+            continue;
+        }
+        std::cout << "PROBE gauge=" << GAUGE_NAMES[i]
+                  << " samples=" << gauge.samples
+                  << " avg=" << static_cast<double>(gauge.total) / gauge.samples
+                  << " p99=" << gauge.quantile(0.99)
+                  << " max=" << gauge.max
+                  << std::endl;
+    }
+}
+
+} // namespace instrumentation
+
+#endif // V2X_INSTRUMENTATION
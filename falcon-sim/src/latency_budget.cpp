@@ -0,0 +1,112 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "latency_budget.h"
+
+namespace {
+
+const char *const STAGE_NAMES[LATENCY_STAGE_COUNT] = {
+    "queue", "sign", "send", "wire", "reassembly", "dispatch", "verify", "output", "total"
+};
+
+// Nearest-rank quantile of sorted values.
+int64_t quantile(const std::vector<int64_t> &sorted, double q) {
+    const auto rank = static_cast<std::size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+const char *latency_stage_name(latency_stage stage) {
+    return STAGE_NAMES[static_cast<std::size_t>(stage)];
+}
+
+void latency_budget::record(uint8_t vehicle_id, uint32_t sequence_number, uint8_t scheme,
+                            const message_timestamps &times) {
+    sample entry{};
+    entry.vehicle_id = vehicle_id;
+    entry.scheme = scheme;
+    entry.sequence_number = sequence_number;
+    entry.generated_us = times.generated_us;
+
+    const int64_t boundaries[] = {times.generated_us, times.sign_start_us, times.sign_end_us, times.sent_us,
+                                  times.first_arrival_us, times.completed_us, times.verify_start_us,
+                                  times.verify_end_us, times.output_us};
+    for (std::size_t i = 0; i + 1 < std::size(boundaries); i++) {
+        entry.stages_us[i] = boundaries[i + 1] - boundaries[i];
+    }
+    entry.stages_us[static_cast<std::size_t>(latency_stage::total)] = times.output_us - times.generated_us;
+    samples.push_back(entry);
+}
+
+void latency_budget::print_report() const {
+    if (samples.empty()) {
+        return;
+    }
+    std::vector<int64_t> values(samples.size());
+    for (std::size_t stage = 0; stage < LATENCY_STAGE_COUNT; stage++) {
+        double sum = 0;
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            values[i] = samples[i].stages_us[stage];
+            sum += static_cast<double>(values[i]);
+        }
+        std::sort(values.begin(), values.end());
+        std::cout << "LATENCY stage=" << STAGE_NAMES[stage]
+                  << " messages=" << values.size()
+                  << " avg_us=" << sum / static_cast<double>(values.size())
+                  << " p50_us=" << quantile(values, 0.50)
+                  << " p90_us=" << quantile(values, 0.90)
+                  << " p99_us=" << quantile(values, 0.99)
+                  << " max_us=" << values.back()
+                  << std::endl;
+    }
+}
+
+void latency_budget::write_csv(const char *path, const char *run_id, const char *note) const {
+    std::ostringstream rows;
+    for (const auto &entry : samples) {
+        rows << (run_id != nullptr ? run_id : "0") << ','
+             << static_cast<int>(entry.vehicle_id) << ','
+             << entry.sequence_number << ','
+             << static_cast<int>(entry.scheme) << ','
+             << entry.generated_us;
+        for (int64_t value : entry.stages_us) {
+            rows << ',' << value;
+        }
+        rows << ',' << (note != nullptr ? note : "") << '\n';
+    }
+
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("open V2X_LATENCY_FILE failed");
+        return;
+    }
+    // concurrent sweep runs may share the file; the lock also covers the header check
+    flock(fd, LOCK_EX);
+    struct stat info{};
+    std::string out;
+    if (fstat(fd, &info) == 0 && info.st_size == 0) {
+        out = "run,vehicle,sequence,scheme,generated_us";
+        for (const char *name : STAGE_NAMES) {
+            out += std::string(",") + name + "_us";
+        }
+        out += ",note\n";
+    }
+    out += rows.str();
+    if (write(fd, out.data(), out.size()) != static_cast<ssize_t>(out.size())) {
+        perror("write V2X_LATENCY_FILE failed");
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+}
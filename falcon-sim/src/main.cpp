@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <thread>
 #include <boost/property_tree/ptree.hpp>
@@ -11,14 +12,159 @@
 
 #include "Vehicle.h"
 #include "arguments.h"
+#include "cpu_features.h"
+#include "fcd_import.h"
+#include "fleet_startup.h"
+#include "instrumentation.h"
+#include "offline_verify.h"
+#include "perf_counters.h"
+#include "psid_dispatch.h"
+#include "readiness.h"
+#include "resource_usage.h"
+#include "signing_backend.h"
+#include "thread_affinity.h"
+#include "trace_generator.h"
+#include "v2vcrypto.h"
+#include "verify_offload.h"
 
 
 void print_usage() {
-    std::cout << "Usage: v2verifer {dsrc | cv2x} {transmitter | receiver} {tkgui | webgui | nogui} [--test]" << std::endl;
+    std::cout << "Usage: v2verifer {dsrc | cv2x} {transmitter | receiver | verifier | hsm} {tkgui | webgui | nogui} [--test]" << std::endl;
+    std::cout << "       v2verifer generate-traces {grid | polyline FILE} VEHICLES STEPS" << std::endl;
+    std::cout << "       v2verifer import-fcd {FILE | -}" << std::endl;
+    std::cout << "       v2verifer verify-offline [DIRECTORY]" << std::endl;
+}
+
+// The config file for the offline subcommands, which also run without one.
+boost::property_tree::ptree read_optional_config() {
+    const char *config_override = std::getenv("V2X_CONFIG_PATH");
+    std::string config_path = config_override != nullptr ? std::string(config_override) : "config.json";
+    boost::property_tree::ptree tree;
+    if (std::filesystem::exists(config_path)) {
+        boost::property_tree::json_parser::read_json(config_path, tree);
+    }
+    return tree;
+}
+
+// generate-traces {grid | polyline FILE} VEHICLES STEPS: the remaining knobs come from scenario.traces.* in the
+// config file (if there is one) and the V2X_TRACE_* environment variables.
+int generate_traces_command(int argc, char *argv[]) {
+    trace_options options;
+    int next_arg = 2;
+    if (argc > next_arg) {
+        options.model = parse_trace_model(argv[next_arg++]);
+    }
+    if (options.model == trace_model::POLYLINE && argc > next_arg) {
+        options.polyline_file = argv[next_arg++];
+    }
+    if (argc != next_arg + 2) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+    options.vehicles = std::atoi(argv[next_arg]);
+    options.steps = std::atoi(argv[next_arg + 1]);
+    if (options.vehicles <= 0 || options.steps <= 0) {
+        std::cerr << "Error: VEHICLES and STEPS must be positive" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const boost::property_tree::ptree tree = read_optional_config();
+    options.seed = tree.get<uint64_t>("scenario.traces.seed", options.seed);
+    options.grid_blocks = tree.get<int>("scenario.traces.gridBlocks", options.grid_blocks);
+    options.grid_spacing_m = tree.get<double>("scenario.traces.gridSpacingM", options.grid_spacing_m);
+    options.max_speed_mps = tree.get<double>("scenario.traces.maxSpeedMps", options.max_speed_mps);
+    options.accel_mps2 = tree.get<double>("scenario.traces.accelMps2", options.accel_mps2);
+    options.decel_mps2 = tree.get<double>("scenario.traces.decelMps2", options.decel_mps2);
+    options.stop_probability = tree.get<double>("scenario.traces.stopProbability", options.stop_probability);
+    options.max_stop_s = tree.get<double>("scenario.traces.maxStopS", options.max_stop_s);
+    options.threads = tree.get<unsigned>("scenario.traces.threads", options.threads);
+    options.directory = tree.get<std::string>("scenario.traces.directory", options.directory);
+    if (const char *seed_env = std::getenv("V2X_TRACE_SEED")) {
+        options.seed = std::strtoull(seed_env, nullptr, 10);
+    }
+    if (const char *threads_env = std::getenv("V2X_TRACE_THREADS")) {
+        options.threads = static_cast<unsigned>(std::strtoul(threads_env, nullptr, 10));
+    }
+    if (const char *directory_env = std::getenv("V2X_TRACE_DIR")) {
+        options.directory = directory_env;
+    }
+
+    generate_traces(options);
+    return EXIT_SUCCESS;
+}
+
+// import-fcd {FILE | -}: options from scenario.import.* and scenario.traces.directory, then V2X_FCD_PROJECTION and
+// V2X_TRACE_DIR.
+int import_fcd_command(int argc, char *argv[]) {
+    if (argc != 3) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    fcd_import_options options;
+    options.input = argv[2];
+
+    const boost::property_tree::ptree tree = read_optional_config();
+    options.projection = parse_fcd_projection(tree.get<std::string>("scenario.import.projection", "none"));
+    auto origin_latitude = tree.get_optional<double>("scenario.import.originLat");
+    auto origin_longitude = tree.get_optional<double>("scenario.import.originLon");
+    if (origin_latitude && origin_longitude) {
+        options.origin_set = true;
+        options.origin_latitude = *origin_latitude;
+        options.origin_longitude = *origin_longitude;
+    }
+    options.buffer_bytes = tree.get<std::size_t>("scenario.import.bufferMb", options.buffer_bytes >> 20) << 20;
+    options.directory = tree.get<std::string>("scenario.traces.directory", options.directory);
+    if (const char *projection_env = std::getenv("V2X_FCD_PROJECTION")) {
+        options.projection = parse_fcd_projection(projection_env);
+    }
+    if (const char *directory_env = std::getenv("V2X_TRACE_DIR")) {
+        options.directory = directory_env;
+    }
+
+    import_fcd(options);
+    return EXIT_SUCCESS;
+}
+
+// verify-offline [DIRECTORY]: the capture directory defaults to scenario.capture.directory; worker threads and their
+// CPUs come from scenario.verifyOffline.* and V2X_VERIFY_THREADS / V2X_VERIFY_CPUS. Exits non-zero on mismatches.
+int verify_offline_command(int argc, char *argv[]) {
+    if (argc > 3) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    offline_verify_options options;
+    const boost::property_tree::ptree tree = read_optional_config();
+    options.directory = tree.get<std::string>("scenario.capture.directory", options.directory);
+    options.threads = tree.get<unsigned>("scenario.verifyOffline.threads", options.threads);
+    options.cpus = parse_cpu_spec(tree.get<std::string>("scenario.verifyOffline.cpus", ""));
+    options.chunk_records = tree.get<std::size_t>("scenario.verifyOffline.chunkRecords", options.chunk_records);
+    if (const char *threads_env = std::getenv("V2X_VERIFY_THREADS")) {
+        options.threads = static_cast<unsigned>(std::strtoul(threads_env, nullptr, 10));
+    }
+    if (const char *cpus_env = std::getenv("V2X_VERIFY_CPUS")) {
+        options.cpus = parse_cpu_spec(cpus_env);
+    }
+    if (argc == 3) {
+        options.directory = argv[2];
+    }
+
+    return verify_offline(options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 int main(int argc, char *argv[]) {
 
+    if(argc >= 2 && std::string(argv[1]) == "generate-traces") {
+        return generate_traces_command(argc, argv);
+    }
+    if(argc >= 2 && std::string(argv[1]) == "import-fcd") {
+        return import_fcd_command(argc, argv);
+    }
+    if(argc >= 2 && std::string(argv[1]) == "verify-offline") {
+        return verify_offline_command(argc, argv);
+    }
+
     if(argc < 3 || argc > 5) {
         print_usage();
         exit(EXIT_FAILURE);
@@ -41,8 +187,12 @@ int main(int argc, char *argv[]) {
     }
     else if(std::string(argv[2]) == "receiver")
         args.sim_mode = RECEIVER;
+    else if(std::string(argv[2]) == "verifier")
+        args.sim_mode = VERIFIER;
+    else if(std::string(argv[2]) == "hsm")
+        args.sim_mode = HSM;
     else {
-        std::cout << R"(Error: second argument must be "transmitter" or "receiver")" << std::endl;
+        std::cout << R"(Error: second argument must be "transmitter", "receiver", "verifier" or "hsm")" << std::endl;
         print_usage();
         exit(EXIT_FAILURE);
     }
@@ -108,28 +258,223 @@ int main(int argc, char *argv[]) {
         pqc_opts.compression = tree.get<std::string>("scenario.falcon.compression", pqc_opts.compression);
     }
 
-    if(args.sim_mode == TRANSMITTER) {
-        std::vector<Vehicle> vehicles;
-        std::vector<std::thread> workers;
+    std::string kernel_str;
+    if (const char *kernel_env = std::getenv("V2X_CRYPTO_KERNEL")) {
+        kernel_str = kernel_env;
+    } else {
+        kernel_str = tree.get<std::string>("scenario.crypto.kernel", "auto");
+    }
+    const cpu_features features = detect_cpu_features();
+    const crypto_kernels &kernels = select_crypto_kernels(parse_crypto_kernel_preference(kernel_str), features);
+    std::cout << "CPU features: " << describe_cpu_features(features)
+              << "; crypto kernels: falcon=" << kernels.falcon_name
+              << " hash=" << kernels.hash_name << std::endl;
 
-        // initialize vehicles - has to be in a separate loop to prevent vector issues
-        for(int i = 0; i < num_vehicles; i++) {
-            vehicles.emplace_back(Vehicle(i, pqc_opts));
+    // hardware counters around signing, hashing, verification and reassembly; opened per thread on first use
+    bool perf_enabled = tree.get<bool>("scenario.perf.enabled", false);
+    if (const char *perf_env = std::getenv("V2X_PERF_COUNTERS")) {
+        perf_enabled = std::string(perf_env) == "1";
+    }
+    if (perf_enabled) {
+        enable_perf_counters();
+    }
+
+    verify_offload_options offload_opts;
+    offload_opts.enabled = tree.get<bool>("scenario.verifier.offload", offload_opts.enabled);
+    offload_opts.shm_name = tree.get<std::string>("scenario.verifier.shmName", offload_opts.shm_name);
+    offload_opts.threads = tree.get<std::size_t>("scenario.verifier.threads", offload_opts.threads);
+    offload_opts.slots = tree.get<std::size_t>("scenario.verifier.slots", offload_opts.slots);
+    offload_opts.cache_entries = tree.get<std::size_t>("scenario.verifier.cacheEntries", offload_opts.cache_entries);
+    offload_opts.timeout = std::chrono::milliseconds(
+        tree.get<long>("scenario.verifier.timeoutMs", static_cast<long>(offload_opts.timeout.count())));
+    if (const char *offload_env = std::getenv("V2X_VERIFY_OFFLOAD")) {
+        offload_opts.enabled = std::string(offload_env) == "1";
+    }
+    if (const char *shm_env = std::getenv("V2X_VERIFIER_SHM")) {
+        offload_opts.shm_name = shm_env;
+    }
+    if (const char *threads_env = std::getenv("V2X_VERIFIER_THREADS")) {
+        offload_opts.threads = std::strtoul(threads_env, nullptr, 10);
+    }
+
+    transmit_options tx_opts;
+    tx_opts.signing.backend = tree.get<std::string>("scenario.signing.backend", tx_opts.signing.backend);
+    tx_opts.signing.hsm_socket = tree.get<std::string>("scenario.signing.hsmSocket", tx_opts.signing.hsm_socket);
+    tx_opts.signing.pipeline_depth = tree.get<std::size_t>("scenario.signing.pipelineDepth",
+                                                           tx_opts.signing.pipeline_depth);
+    tx_opts.interval = std::chrono::microseconds(
+        tree.get<long>("scenario.transmitter.intervalUs", static_cast<long>(tx_opts.interval.count())));
+    if (const char *backend_env = std::getenv("V2X_SIGNING_BACKEND")) {
+        tx_opts.signing.backend = backend_env;
+    }
+    if (const char *socket_env = std::getenv("V2X_HSM_SOCKET")) {
+        tx_opts.signing.hsm_socket = socket_env;
+    }
+    if (const char *pipeline_env = std::getenv("V2X_SIGNING_PIPELINE")) {
+        tx_opts.signing.pipeline_depth = std::strtoul(pipeline_env, nullptr, 10);
+    }
+    if (const char *interval_env = std::getenv("V2X_TX_INTERVAL_US")) {
+        tx_opts.interval = std::chrono::microseconds(std::strtol(interval_env, nullptr, 10));
+    }
+    tx_opts.trace_window_rows = tree.get<std::size_t>("scenario.traces.windowRows", tx_opts.trace_window_rows);
+    if (const char *window_env = std::getenv("V2X_TRACE_WINDOW_ROWS")) {
+        tx_opts.trace_window_rows = std::strtoul(window_env, nullptr, 10);
+    }
+    auto priority_list = [](const std::string &spec) {
+        std::vector<uint8_t> priorities = parse_psid_list(spec);
+        if (std::any_of(priorities.begin(), priorities.end(), [](uint8_t priority) { return priority > 7; })) {
+            std::cerr << "Error: user priorities must be 0-7, got \"" << spec << "\"" << std::endl;
+            exit(EXIT_FAILURE);
         }
+        return priorities;
+    };
+    if (auto psids = tree.get_optional<std::string>("scenario.transmitter.psids")) {
+        tx_opts.psids = parse_psid_list(*psids);
+    }
+    if (auto priorities = tree.get_optional<std::string>("scenario.transmitter.priorities")) {
+        tx_opts.priorities = priority_list(*priorities);
+    }
+    if (const char *psids_env = std::getenv("V2X_TX_PSIDS")) {
+        tx_opts.psids = parse_psid_list(psids_env);
+    }
+    if (const char *priorities_env = std::getenv("V2X_TX_PRIORITIES")) {
+        tx_opts.priorities = priority_list(priorities_env);
+    }
+
+    startup_options startup_opts;
+    startup_opts.mode = parse_startup_mode(tree.get<std::string>("scenario.startup.mode", "parallel"));
+    startup_opts.threads = tree.get<unsigned>("scenario.startup.threads", startup_opts.threads);
+    if (const char *startup_env = std::getenv("V2X_STARTUP_MODE")) {
+        startup_opts.mode = parse_startup_mode(startup_env);
+    }
+    if (const char *startup_threads_env = std::getenv("V2X_STARTUP_THREADS")) {
+        startup_opts.threads = static_cast<unsigned>(std::strtoul(startup_threads_env, nullptr, 10));
+    }
+
+    receive_options rx_opts;
+    rx_opts.busy_poll = tree.get<bool>("scenario.receiver.busyPoll", rx_opts.busy_poll);
+    rx_opts.spin = std::chrono::microseconds(
+        tree.get<long>("scenario.receiver.spinUs", static_cast<long>(rx_opts.spin.count())));
+    rx_opts.socket_busy_poll_us = tree.get<int>("scenario.receiver.socketBusyPollUs", rx_opts.socket_busy_poll_us);
+    if (const char *busy_poll_env = std::getenv("V2X_RX_BUSY_POLL")) {
+        rx_opts.busy_poll = std::string(busy_poll_env) == "1";
+    }
+    if (const char *spin_env = std::getenv("V2X_RX_SPIN_US")) {
+        rx_opts.spin = std::chrono::microseconds(std::strtol(spin_env, nullptr, 10));
+    }
+    rx_opts.dispatch.enabled = tree.get<bool>("scenario.dispatch.enabled", rx_opts.dispatch.enabled);
+    if (auto classes = tree.get_child_optional("scenario.dispatch.classes")) {
+        for (const auto &entry : *classes) {
+            dispatch_class_options class_opts;
+            class_opts.name = entry.second.get<std::string>(
+                "name", "class" + std::to_string(rx_opts.dispatch.classes.size()));
+            class_opts.psids = parse_psid_list(entry.second.get<std::string>("psids", "any"));
+            class_opts.min_priority = static_cast<uint8_t>(
+                std::min(entry.second.get<unsigned>("minPriority", class_opts.min_priority), 7u));
+            class_opts.verifiers = entry.second.get<std::size_t>("verifiers", class_opts.verifiers);
+            class_opts.capacity = entry.second.get<std::size_t>("capacity", class_opts.capacity);
+            rx_opts.dispatch.classes.push_back(class_opts);
+        }
+    }
+    if (const char *dispatch_env = std::getenv("V2X_DISPATCH")) {
+        rx_opts.dispatch.enabled = std::string(dispatch_env) == "1";
+    }
+    rx_opts.capture.enabled = tree.get<bool>("scenario.capture.enabled", rx_opts.capture.enabled);
+    rx_opts.capture.directory = tree.get<std::string>("scenario.capture.directory", rx_opts.capture.directory);
+    rx_opts.capture.segment_bytes = tree.get<std::size_t>("scenario.capture.segmentMb",
+                                                          rx_opts.capture.segment_bytes >> 20) << 20;
+    rx_opts.capture.queue_capacity = tree.get<std::size_t>("scenario.capture.queueCapacity",
+                                                           rx_opts.capture.queue_capacity);
+    if (const char *capture_env = std::getenv("V2X_CAPTURE_DIR")) {
+        rx_opts.capture.enabled = true;
+        rx_opts.capture.directory = capture_env;
+    }
+
+    hsm_emulator_options hsm_opts;
+    hsm_opts.socket_path = tx_opts.signing.hsm_socket;
+    hsm_opts.ecdsa_latency = std::chrono::microseconds(tree.get<long>("scenario.hsm.ecdsaLatencyUs", 0));
+    hsm_opts.falcon_latency = std::chrono::microseconds(tree.get<long>("scenario.hsm.falconLatencyUs", 0));
+    hsm_opts.concurrency = tree.get<std::size_t>("scenario.hsm.concurrency", hsm_opts.concurrency);
+    if (const char *latency_env = std::getenv("V2X_HSM_LATENCY_US")) {
+        hsm_opts.ecdsa_latency = hsm_opts.falcon_latency = std::chrono::microseconds(std::strtol(latency_env, nullptr, 10));
+    }
+    if (const char *concurrency_env = std::getenv("V2X_HSM_CONCURRENCY")) {
+        hsm_opts.concurrency = std::strtoul(concurrency_env, nullptr, 10);
+    }
+
+    // thread placement: isolation-friendly defaults, then config, then environment
+    thread_placement placement = default_thread_placement();
+    auto placement_option = [&tree](const char *key, const char *env_name, std::vector<int> &cpus) {
+        if (const char *env = std::getenv(env_name)) {
+            cpus = parse_cpu_spec(env);
+        } else if (auto spec = tree.get_optional<std::string>(std::string("scenario.affinity.") + key)) {
+            if (*spec != "auto") {
+                cpus = parse_cpu_spec(*spec);
+            }
+        }
+    };
+    placement_option("receiver", "V2X_AFFINITY_RECEIVER", placement.receiver);
+    placement_option("transmitter", "V2X_AFFINITY_TRANSMITTER", placement.transmitter);
+    placement_option("verifier", "V2X_AFFINITY_VERIFIER", placement.verifier);
+    placement_option("hsm", "V2X_AFFINITY_HSM", placement.hsm);
+    offload_opts.cpus = placement.verifier;
+    rx_opts.dispatch.cpus = placement.verifier;
+    hsm_opts.cpus = placement.hsm;
+    // the loaders run before any vehicle thread, so spread them over every CPU rather than the transmitters' few
+    startup_opts.cpus = current_thread_cpus();
+
+    if(args.sim_mode == VERIFIER) {
+        run_verifier_service(offload_opts);
+    }
+    else if(args.sim_mode == HSM) {
+        run_hsm_emulator(hsm_opts);
+    }
+    else if(args.sim_mode == TRANSMITTER) {
+        startup_report startup;
+        std::vector<Vehicle> vehicles = create_fleet(num_vehicles, pqc_opts, tx_opts, startup_opts, startup);
+        if (startup_opts.mode != startup_mode::LAZY) {
+            print_startup_report(vehicles, startup_opts, startup);
+        }
+        std::vector<std::thread> workers;
+
+        // keys and traces are loaded, so only the receiver's startup is left to wait for
+        wait_for_ready();
 
         // start a thread for each vehicle
         for(int i = 0; i < num_vehicles; i++) {
             workers.emplace_back(std::thread(vehicles.at(i).transmit_static, &vehicles.at(i), num_msgs, args.test));
+            if (!placement.transmitter.empty()) {
+                pin_thread(workers.back().native_handle(),
+                           {placement.transmitter[static_cast<std::size_t>(i) % placement.transmitter.size()]});
+            }
         }
 
         // wait for each vehicle thread to finish
         for(int i = 0; i < num_vehicles; i++) {
             workers.at(i).join();
         }
+        V2X_PROBE_REPORT();
+        print_perf_totals();
+        record_resource_usage("transmitter", "process", static_cast<int>(pqc_opts.scheme), process_wall_us(),
+                              process_resource_usage());
+
+        if (startup_opts.mode == startup_mode::LAZY) {
+            print_startup_report(vehicles, startup_opts, startup);
+        }
 
     }
     else if (args.sim_mode == RECEIVER) {
         Vehicle v1(0, pqc_opts);
+        // dispatcher verifiers and the capture writer would otherwise inherit the receiver's CPU; keep them with the
+        // verifiers, or on whatever the process may use apart from the receiver's CPUs (read before it is pinned)
+        const std::vector<int> spare_cpus = cpus_excluding(current_thread_cpus(), placement.receiver);
+        rx_opts.dispatch.fallback_cpus = spare_cpus;
+        rx_opts.capture.cpus = placement.verifier.empty() ? spare_cpus : placement.verifier;
+        pin_thread(pthread_self(), placement.receiver);
+        v1.configure_receive(rx_opts);
+        if (offload_opts.enabled) {
+            v1.enable_verify_offload(offload_opts);
+        }
         v1.receive(num_msgs * num_vehicles, args.test, args.tkgui, args.webgui);
     }
 
@@ -0,0 +1,392 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include <oqs/oqs.h>
+
+#include "ieee16092.h"
+#include "offline_verify.h"
+#include "spdu_capture.h"
+#include "thread_affinity.h"
+#include "verification.h"
+
+namespace {
+
+constexpr std::size_t SCHEME_COUNT = 2;
+
+struct mapped_segment {
+    uint32_t number = 0;
+    const uint8_t *base = nullptr;
+    std::size_t mapped_bytes = 0;
+    std::size_t used_bytes = 0;
+    std::vector<capture_index_entry> entries;
+};
+
+struct work_item {
+    std::size_t segment;
+    std::size_t begin;
+    std::size_t end;
+};
+
+struct scheme_totals {
+    uint64_t messages = 0;
+    uint64_t valid = 0;
+    uint64_t mismatches = 0;
+    uint64_t dropped = 0;       // dropped online, so there is no verdict to compare with
+    uint64_t busy_ns = 0;
+};
+
+const char *scheme_label(std::size_t scheme) {
+    return scheme == static_cast<std::size_t>(signature_scheme::FALCON) ? "falcon" : "ecdsa";
+}
+
+std::size_t record_span(const capture_record &record) {
+    return sizeof(capture_record) + (record.payload_bytes + 7u) / 8u * 8u;
+}
+
+// Largest message signature each scheme produces: DER-encoded ECDSA P-256, Falcon-512.
+std::size_t max_signature_bytes(uint8_t scheme) {
+    if (scheme == static_cast<uint8_t>(signature_scheme::FALCON)) {
+        return OQS_SIG_falcon_512_length_signature;
+    }
+    return sizeof(ieee1609dot2data_ecdsa_explicit::certificate_signature);
+}
+
+// Whether the record at `offset` can be verified without reading outside the segment or the SPDU's buffers.
+bool well_formed(const mapped_segment &segment, std::size_t offset) {
+    capture_record record{};
+    std::memcpy(&record, segment.base + offset, sizeof(record));
+    return record.data_bytes == sizeof(ieee1609dot2data_ecdsa_explicit) &&
+           record.payload_bytes == static_cast<uint32_t>(record.data_bytes) + record.signature_bytes &&
+           offset + sizeof(capture_record) + record.payload_bytes <= segment.used_bytes &&
+           record.signature_scheme < SCHEME_COUNT &&
+           record.signature_bytes <= max_signature_bytes(record.signature_scheme) &&
+           record.certificate_signature_bytes <= sizeof(ieee1609dot2data_ecdsa_explicit::certificate_signature);
+}
+
+// Index entries for every complete record: from the .idx file when it matches the segment header, otherwise (the
+// index is missing or was cut short) by walking the records.
+std::vector<capture_index_entry> load_entries(const std::string &directory, const mapped_segment &segment,
+                                              uint64_t record_count) {
+    std::vector<capture_index_entry> entries;
+    std::ifstream index(capture_index_path(directory, segment.number), std::ios::binary);
+    if (index.is_open()) {
+        entries.resize(record_count);
+        index.read(reinterpret_cast<char *>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(capture_index_entry)));
+        const bool complete = static_cast<std::size_t>(index.gcount()) == entries.size() * sizeof(capture_index_entry);
+        if (complete && std::all_of(entries.begin(), entries.end(), [&](const capture_index_entry &entry) {
+                return entry.offset + sizeof(capture_record) <= segment.used_bytes;
+            })) {
+            return entries;
+        }
+        entries.clear();
+    }
+
+    std::size_t offset = sizeof(capture_segment_header);
+    while (offset + sizeof(capture_record) <= segment.used_bytes) {
+        capture_record record{};
+        std::memcpy(&record, segment.base + offset, sizeof(record));
+        if (offset + record_span(record) > segment.used_bytes) {
+            break;
+        }
+        capture_index_entry entry{};
+        entry.offset = offset;
+        entry.receive_time_us = record.receive_time_us;
+        entry.sequence_number = record.sequence_number;
+        entry.vehicle_id = record.vehicle_id;
+        entry.flags = record.flags;
+        entry.signature_scheme = record.signature_scheme;
+        entry.psid = record.psid;
+        entries.push_back(entry);
+        offset += record_span(record);
+    }
+    return entries;
+}
+
+// Maps every readable segment. Segments that cannot be read or are not capture segments are reported and counted in
+// `bad_segments`; records the header counts but that cannot be found are counted in `truncated`.
+std::vector<mapped_segment> map_segments(const std::string &directory, uint64_t &bad_segments, uint64_t &truncated) {
+    std::vector<uint32_t> numbers;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        unsigned number = 0;
+        char extension[4] = {};
+        const std::string name = entry.path().filename().string();
+        if (std::sscanf(name.c_str(), "spdu-%6u.%3s", &number, extension) == 2 && std::strcmp(extension, "seg") == 0) {
+            numbers.push_back(number);
+        }
+    }
+    if (error || numbers.empty()) {
+        std::cerr << "No capture segments in " << directory << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::sort(numbers.begin(), numbers.end());
+
+    std::vector<mapped_segment> segments;
+    for (uint32_t number : numbers) {
+        const std::string path = capture_segment_path(directory, number);
+        const int fd = open(path.c_str(), O_RDONLY);
+        struct stat info{};
+        if (fd < 0 || fstat(fd, &info) < 0) {
+            perror(("Error opening capture segment " + path).c_str());
+            if (fd >= 0) {
+                close(fd);
+            }
+            bad_segments++;
+            continue;
+        }
+        if (static_cast<std::size_t>(info.st_size) < sizeof(capture_segment_header)) {
+            std::cerr << "Capture segment " << path << " is too short" << std::endl;
+            close(fd);
+            bad_segments++;
+            continue;
+        }
+        void *address = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED) {
+            perror(("Error mapping capture segment " + path).c_str());
+            bad_segments++;
+            continue;
+        }
+
+        mapped_segment segment;
+        segment.number = number;
+        segment.base = static_cast<const uint8_t *>(address);
+        segment.mapped_bytes = static_cast<std::size_t>(info.st_size);
+        capture_segment_header header{};
+        std::memcpy(&header, segment.base, sizeof(header));
+        if (std::memcmp(header.magic, CAPTURE_SEGMENT_MAGIC, sizeof(header.magic)) != 0 || header.version != 1) {
+            std::cerr << path << " is not a capture segment" << std::endl;
+            munmap(address, segment.mapped_bytes);
+            bad_segments++;
+            continue;
+        }
+        // a segment the receiver is still writing is sized ahead of its used part
+        segment.used_bytes = std::min<std::size_t>(header.used_bytes, segment.mapped_bytes);
+        segment.entries = load_entries(directory, segment, header.record_count);
+        if (segment.entries.size() < header.record_count) {
+            std::cerr << "Capture segment " << path << " is truncated: " << segment.entries.size() << " of "
+                      << header.record_count << " records" << std::endl;
+            truncated += header.record_count - segment.entries.size();
+        }
+        segments.push_back(std::move(segment));
+    }
+    return segments;
+}
+
+// The receiver's checks (Vehicle::verify_message), with the recorded receive time standing in for "now".
+bool verify_record(const capture_record &record, const ieee1609dot2data_ecdsa_explicit &data,
+                   const uint8_t *signature) {
+    verification_key_cache &keys = shared_verification_keys();
+    const bool cert_result = verify_signature(keys,
+                                              signature_scheme::ECDSA,
+                                              verification_key_kind::CERTIFICATE,
+                                              record.vehicle_id,
+                                              reinterpret_cast<const uint8_t *>(&data.signedData.cert),
+                                              sizeof(data.signedData.cert),
+                                              data.certificate_signature,
+                                              record.certificate_signature_bytes);
+    const bool sig_result = verify_signature(keys,
+                                             static_cast<signature_scheme>(record.signature_scheme),
+                                             verification_key_kind::MESSAGE,
+                                             record.vehicle_id,
+                                             reinterpret_cast<const uint8_t *>(&data.signedData.tbsData),
+                                             sizeof(data.signedData.tbsData),
+                                             signature,
+                                             record.signature_bytes);
+
+    const std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds> received_time{
+        std::chrono::microseconds(record.receive_time_us)};
+    std::chrono::duration<double, std::milli> elapsed_time =
+        received_time - data.signedData.tbsData.headerInfo.timestamp;
+    const bool recent = elapsed_time.count() < 30000;
+    return cert_result && sig_result && recent;
+}
+
+} // namespace
+
+uint64_t verify_offline(const offline_verify_options &options) {
+    uint64_t bad_segments = 0;
+    uint64_t truncated = 0;
+    std::vector<mapped_segment> segments = map_segments(options.directory, bad_segments, truncated);
+
+    const std::size_t chunk = std::max<std::size_t>(options.chunk_records, 1);
+    std::vector<work_item> items;
+    std::set<std::pair<int, uint8_t>> signers;
+    uint64_t records = 0;
+    for (std::size_t s = 0; s < segments.size(); s++) {
+        const auto &entries = segments[s].entries;
+        for (std::size_t begin = 0; begin < entries.size(); begin += chunk) {
+            items.push_back({s, begin, std::min(entries.size(), begin + chunk)});
+        }
+        for (const auto &entry : entries) {
+            // a corrupt record must not send the key loader after a vehicle that does not exist
+            if (well_formed(segments[s], entry.offset)) {
+                signers.emplace(entry.vehicle_id, entry.signature_scheme);
+            }
+        }
+        records += entries.size();
+    }
+
+    // key loading is not what we are measuring
+    verification_key_cache &keys = shared_verification_keys();
+    for (const auto &signer : signers) {
+        keys.ecdsa_key(signer.first, verification_key_kind::CERTIFICATE);
+        if (signer.second == static_cast<uint8_t>(signature_scheme::FALCON)) {
+            keys.falcon_public_key(signer.first);
+        } else {
+            keys.ecdsa_key(signer.first, verification_key_kind::MESSAGE);
+        }
+    }
+
+    unsigned threads = options.threads;
+    if (threads == 0) {
+        threads = static_cast<unsigned>(current_thread_cpus().size());
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(std::max<std::size_t>(items.size(), 1))));
+
+    std::atomic<std::size_t> next{0};
+    std::atomic<uint64_t> malformed{0};
+    std::mutex totals_mutex;
+    std::array<scheme_totals, SCHEME_COUNT> totals{};
+
+    auto worker = [&](unsigned index) {
+        pin_current_thread_round_robin(options.cpus, index);
+        std::array<scheme_totals, SCHEME_COUNT> local{};
+        for (std::size_t item = next++; item < items.size(); item = next++) {
+            const mapped_segment &segment = segments[items[item].segment];
+            for (std::size_t i = items[item].begin; i < items[item].end; i++) {
+                const std::size_t offset = segment.entries[i].offset;
+                if (!well_formed(segment, offset)) {
+                    malformed++;
+                    continue;
+                }
+                capture_record record{};
+                std::memcpy(&record, segment.base + offset, sizeof(record));
+                ieee1609dot2data_ecdsa_explicit data;
+                const uint8_t *payload = segment.base + offset + sizeof(capture_record);
+                std::memcpy(&data, payload, sizeof(data));
+
+                const auto start = std::chrono::steady_clock::now();
+                const bool valid = verify_record(record, data, payload + record.data_bytes);
+                const auto end = std::chrono::steady_clock::now();
+
+                scheme_totals &scheme = local[record.signature_scheme];
+                scheme.messages++;
+                scheme.valid += valid ? 1 : 0;
+                scheme.busy_ns += static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                if ((record.flags & CAPTURE_DROPPED) != 0) {
+                    scheme.dropped++;
+                    continue;
+                }
+                const bool recorded_valid = (record.flags & CAPTURE_VALID) != 0;
+                if (valid != recorded_valid) {
+                    scheme.mismatches++;
+                    std::lock_guard<std::mutex> guard(totals_mutex);
+                    std::cout << "MISMATCH segment=" << segment.number
+                              << " offset=" << offset
+                              << " vehicle=" << static_cast<int>(record.vehicle_id)
+                              << " sequence=" << record.sequence_number
+                              << " scheme=" << scheme_label(record.signature_scheme)
+                              << " recorded=" << (recorded_valid ? "valid" : "invalid")
+                              << " offline=" << (valid ? "valid" : "invalid")
+                              << std::endl;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(totals_mutex);
+        for (std::size_t s = 0; s < SCHEME_COUNT; s++) {
+            totals[s].messages += local[s].messages;
+            totals[s].valid += local[s].valid;
+            totals[s].mismatches += local[s].mismatches;
+            totals[s].dropped += local[s].dropped;
+            totals[s].busy_ns += local[s].busy_ns;
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t verified = 0;
+    uint64_t mismatches = 0;
+    uint64_t dropped = 0;
+    uint64_t busy_ns = 0;
+    for (const auto &scheme : totals) {
+        verified += scheme.messages;
+        mismatches += scheme.mismatches;
+        dropped += scheme.dropped;
+        busy_ns += scheme.busy_ns;
+    }
+    for (std::size_t s = 0; s < SCHEME_COUNT; s++) {
+        const scheme_totals &scheme = totals[s];
+        if (scheme.messages == 0) {
+            continue;
+        }
+        // the pool's throughput for this scheme: its messages over its share of the wall time, where the share is
+        // its part of the time all workers spent verifying
+        const double share = busy_ns > 0 ? static_cast<double>(scheme.busy_ns) / static_cast<double>(busy_ns) : 0.0;
+        std::cout << "OFFLINE scheme=" << scheme_label(s)
+                  << " messages=" << scheme.messages
+                  << " valid=" << scheme.valid
+                  << " invalid=" << scheme.messages - scheme.valid
+                  << " mismatches=" << scheme.mismatches
+                  << " dropped_online=" << scheme.dropped
+                  << " busy_us=" << scheme.busy_ns / 1000
+                  << " per_thread_per_s=" << (scheme.busy_ns > 0 ? scheme.messages * 1e9 / scheme.busy_ns : 0.0)
+                  << " verifications_per_s=" << (share * seconds > 0 ? scheme.messages / (share * seconds) : 0.0)
+                  << std::endl;
+    }
+    std::cout << "OFFLINE scheme=all"
+              << " segments=" << segments.size()
+              << " bad_segments=" << bad_segments
+              << " records=" << records
+              << " truncated=" << truncated
+              << " messages=" << verified
+              << " malformed=" << malformed.load()
+              << " mismatches=" << mismatches
+              << " dropped_online=" << dropped
+              << " threads=" << threads
+              << " cpus=" << describe_cpu_list(options.cpus)
+              << " seconds=" << seconds
+              << " verifications_per_s=" << (seconds > 0 ? verified / seconds : 0.0)
+              << " directory=" << options.directory
+              << std::endl;
+
+    for (const auto &segment : segments) {
+        munmap(const_cast<uint8_t *>(segment.base), segment.mapped_bytes);
+    }
+    return mismatches + malformed.load() + bad_segments + truncated;
+}
@@ -0,0 +1,243 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "perf_counters.h"
+
+namespace perf_detail {
+std::atomic<bool> active{false};
+}
+
+namespace {
+
+constexpr std::size_t STAGES = static_cast<std::size_t>(perf_stage::count);
+constexpr std::array<uint64_t, 4> EVENTS = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+std::atomic<perf_state> state{perf_state::off};
+
+struct stage_totals {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> instructions{0};
+    std::atomic<uint64_t> cache_misses{0};
+    std::atomic<uint64_t> branch_misses{0};
+    std::atomic<uint64_t> multiplexed{0};   // calls whose counts were scaled up from a partial PMU share
+};
+std::array<stage_totals, STAGES> totals;
+
+int open_event(uint64_t config, int group_fd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;    // allowed at perf_event_paranoid 2, and keeps our own read() calls out of the counts
+    attr.exclude_hv = 1;
+    // the enabled/running times let us scale counts when the PMU is shared and the group was multiplexed
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // this thread only, on whichever CPU it runs
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+// The calling thread's counter group, opened on first use.
+class counter_group {
+
+public:
+    counter_group() {
+        for (std::size_t i = 0; i < EVENTS.size(); i++) {
+            fds[i] = open_event(EVENTS[i], i == 0 ? -1 : fds[0]);
+            if (fds[i] < 0) {
+                error = errno;
+                close_all();
+                return;
+            }
+        }
+        if (ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) < 0 ||
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0) {
+            error = errno;
+            close_all();
+        }
+    }
+    counter_group(const counter_group &) = delete;
+    counter_group &operator=(const counter_group &) = delete;
+    ~counter_group() { close_all(); }
+
+    bool usable() const { return fds[0] >= 0; }
+    int open_error() const { return error; }
+
+    bool read_sample(perf_reading &reading) const {
+        // the number of events, time enabled, time running, then one value per event in creation order
+        uint64_t values[3 + EVENTS.size()];
+        if (read(fds[0], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) ||
+            values[0] != EVENTS.size()) {
+            return false;
+        }
+        reading.time_enabled = values[1];
+        reading.time_running = values[2];
+        reading.counts.cycles = values[3];
+        reading.counts.instructions = values[4];
+        reading.counts.cache_misses = values[5];
+        reading.counts.branch_misses = values[6];
+        return true;
+    }
+
+private:
+    std::array<int, EVENTS.size()> fds{-1, -1, -1, -1};
+    int error = 0;
+
+    void close_all() {
+        for (int &fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+};
+
+counter_group &thread_group() {
+    thread_local counter_group group;
+    return group;
+}
+
+// Counts between two readings. If the group was only on the PMU for part of the interval (other events competing
+// for the counters), extrapolate to the whole interval as perf(1) does; `scaled` reports whether that happened.
+perf_sample difference(const perf_reading &end, const perf_reading &start, bool &scaled) {
+    const uint64_t enabled = end.time_enabled - start.time_enabled;
+    const uint64_t running = end.time_running - start.time_running;
+    scaled = running < enabled;
+    auto count = [&](uint64_t end_value, uint64_t start_value) -> uint64_t {
+        const uint64_t delta = end_value - start_value;
+        if (!scaled) {
+            return delta;
+        }
+        if (running == 0) {
+            return 0;       // never scheduled in this interval: nothing to extrapolate from
+        }
+        return static_cast<uint64_t>(static_cast<double>(delta) * static_cast<double>(enabled) / running);
+    };
+
+    perf_sample result;
+    result.cycles = count(end.counts.cycles, start.counts.cycles);
+    result.instructions = count(end.counts.instructions, start.counts.instructions);
+    result.cache_misses = count(end.counts.cache_misses, start.counts.cache_misses);
+    result.branch_misses = count(end.counts.branch_misses, start.counts.branch_misses);
+    return result;
+}
+
+} // namespace
+
+perf_sample &perf_sample::operator+=(const perf_sample &other) {
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cache_misses += other.cache_misses;
+    branch_misses += other.branch_misses;
+    return *this;
+}
+
+std::ostream &operator<<(std::ostream &out, const perf_sample &sample) {
+    return out << " cycles=" << sample.cycles
+               << " instructions=" << sample.instructions
+               << " ipc=" << sample.ipc()
+               << " cache_misses=" << sample.cache_misses
+               << " branch_misses=" << sample.branch_misses;
+}
+
+perf_state enable_perf_counters() {
+    const counter_group &group = thread_group();
+    if (!group.usable()) {
+        std::cerr << "Hardware performance counters unavailable: perf_event_open: "
+                  << std::strerror(group.open_error()) << std::endl;
+        state = perf_state::unavailable;
+        return state;
+    }
+    state = perf_state::on;
+    perf_detail::active = true;
+    return state;
+}
+
+perf_state current_perf_state() {
+    return state;
+}
+
+const char *perf_stage_name(perf_stage stage) {
+    switch (stage) {
+        case perf_stage::sign: return "sign";
+        case perf_stage::hash: return "hash";
+        case perf_stage::verify: return "verify";
+        case perf_stage::reassembly: return "reassembly";
+        default: return "unknown";
+    }
+}
+
+perf_scope::perf_scope(perf_stage stage, perf_sample *accumulate) : stage(stage), accumulate(accumulate) {
+    if (perf_counters_active()) {
+        const counter_group &group = thread_group();
+        running = group.usable() && group.read_sample(start);
+    }
+}
+
+perf_scope::~perf_scope() {
+    if (!running) {
+        return;
+    }
+    perf_reading end;
+    if (!thread_group().read_sample(end)) {
+        return;
+    }
+    bool scaled = false;
+    const perf_sample delta = difference(end, start, scaled);
+    if (accumulate != nullptr) {
+        *accumulate += delta;
+    }
+    auto &target = totals[static_cast<std::size_t>(stage)];
+    target.calls.fetch_add(1, std::memory_order_relaxed);
+    target.cycles.fetch_add(delta.cycles, std::memory_order_relaxed);
+    target.instructions.fetch_add(delta.instructions, std::memory_order_relaxed);
+    target.cache_misses.fetch_add(delta.cache_misses, std::memory_order_relaxed);
+    target.branch_misses.fetch_add(delta.branch_misses, std::memory_order_relaxed);
+    if (scaled) {
+        target.multiplexed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t perf_stage_calls(perf_stage stage) {
+    return totals[static_cast<std::size_t>(stage)].calls.load(std::memory_order_relaxed);
+}
+
+perf_sample perf_stage_total(perf_stage stage) {
+    const auto &source = totals[static_cast<std::size_t>(stage)];
+    perf_sample sample;
+    sample.cycles = source.cycles.load(std::memory_order_relaxed);
+    sample.instructions = source.instructions.load(std::memory_order_relaxed);
+    sample.cache_misses = source.cache_misses.load(std::memory_order_relaxed);
+    sample.branch_misses = source.branch_misses.load(std::memory_order_relaxed);
+    return sample;
+}
+
+void print_perf_totals() {
+    for (std::size_t i = 0; i < STAGES; i++) {
+        const auto stage = static_cast<perf_stage>(i);
+        const uint64_t calls = perf_stage_calls(stage);
+        if (calls == 0) {
+            continue;
+        }
+        const perf_sample total = perf_stage_total(stage);
+        std::cout << "PERF stage=" << perf_stage_name(stage)
+                  << " calls=" << calls
+                  << total
+                  << " cycles_per_call=" << static_cast<double>(total.cycles) / calls
+                  << " multiplexed=" << totals[i].multiplexed.load(std::memory_order_relaxed)
+                  << std::endl;
+    }
+}
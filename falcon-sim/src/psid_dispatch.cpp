@@ -0,0 +1,186 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "psid_dispatch.h"
+#include "thread_affinity.h"
+
+namespace {
+// Max-heap order: higher priority first, then earlier arrival.
+bool runs_later(uint8_t priority_a, uint64_t arrival_a, uint8_t priority_b, uint64_t arrival_b) {
+    if (priority_a != priority_b) {
+        return priority_a < priority_b;
+    }
+    return arrival_a > arrival_b;
+}
+} // namespace
+
+std::vector<dispatch_class_options> default_dispatch_classes() {
+    dispatch_class_options emergency;
+    emergency.name = "emergency";
+    emergency.min_priority = 6;
+
+    dispatch_class_options safety;
+    safety.name = "safety";
+    safety.psids = {0x20};
+
+    dispatch_class_options other;
+    other.name = "other";
+
+    return {emergency, safety, other};
+}
+
+std::vector<uint8_t> parse_psid_list(const std::string &spec) {
+    std::vector<uint8_t> psids;
+    if (spec.empty() || spec == "any") {
+        return psids;
+    }
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char *end = nullptr;
+        const unsigned long value = std::strtoul(item.c_str(), &end, 0);
+        if (item.empty() || *end != '\0' || value > 0xff) {
+            std::cerr << "Invalid PSID \"" << item << "\" in \"" << spec << "\" (expected values 0-255)" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        psids.push_back(static_cast<uint8_t>(value));
+    }
+    return psids;
+}
+
+psid_dispatcher::psid_dispatcher(const dispatch_options &options) {
+    const std::vector<dispatch_class_options> classes =
+        options.classes.empty() ? default_dispatch_classes() : options.classes;
+
+    std::size_t next_cpu = 0;
+    for (const auto &class_options : classes) {
+        auto target = std::make_unique<lane>();
+        target->options = class_options;
+        target->options.verifiers = std::max<std::size_t>(class_options.verifiers, 1);
+        target->options.capacity = std::max<std::size_t>(class_options.capacity, 1);
+        for (std::size_t i = 0; i < target->options.verifiers; i++) {
+            target->threads.emplace_back(&psid_dispatcher::serve, std::ref(*target));
+            if (!options.cpus.empty()) {
+                pin_thread(target->threads.back().native_handle(), {options.cpus[next_cpu++ % options.cpus.size()]});
+            } else {
+                pin_thread(target->threads.back().native_handle(), options.fallback_cpus);
+            }
+        }
+        lanes.push_back(std::move(target));
+    }
+}
+
+psid_dispatcher::~psid_dispatcher() {
+    for (auto &target : lanes) {
+        {
+            std::lock_guard<std::mutex> guard(target->mutex);
+            target->stopping = true;
+        }
+        target->wake.notify_all();
+    }
+    for (auto &target : lanes) {
+        for (auto &thread : target->threads) {
+            thread.join();
+        }
+    }
+}
+
+psid_dispatcher::lane &psid_dispatcher::route(uint8_t psid, uint8_t priority) {
+    for (auto &target : lanes) {
+        const auto &psids = target->options.psids;
+        if (priority >= target->options.min_priority &&
+            (psids.empty() || std::find(psids.begin(), psids.end(), psid) != psids.end())) {
+            return *target;
+        }
+    }
+    // nothing matched: the last class is the catch-all
+    return *lanes.back();
+}
+
+bool psid_dispatcher::submit(uint8_t psid, uint8_t priority, job work) {
+    lane &target = route(psid, priority);
+    {
+        std::lock_guard<std::mutex> guard(target.mutex);
+        if (target.heap.size() >= target.options.capacity) {
+            target.dropped++;
+            return false;
+        }
+        target.heap.push_back({priority, target.arrivals++, std::chrono::steady_clock::now(), std::move(work)});
+        std::push_heap(target.heap.begin(), target.heap.end(), [](const queued_job &a, const queued_job &b) {
+            return runs_later(a.priority, a.arrival, b.priority, b.arrival);
+        });
+        target.max_depth = std::max(target.max_depth, target.heap.size());
+    }
+    target.wake.notify_one();
+    return true;
+}
+
+void psid_dispatcher::serve(lane &target) {
+    std::unique_lock<std::mutex> lock(target.mutex);
+    for (;;) {
+        target.wake.wait(lock, [&target]() { return target.stopping || !target.heap.empty(); });
+        if (target.heap.empty()) {
+            return;     // stopping, and nothing left to verify
+        }
+
+        std::pop_heap(target.heap.begin(), target.heap.end(), [](const queued_job &a, const queued_job &b) {
+            return runs_later(a.priority, a.arrival, b.priority, b.arrival);
+        });
+        queued_job next = std::move(target.heap.back());
+        target.heap.pop_back();
+        target.running++;
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        next.work();
+        const auto end = std::chrono::steady_clock::now();
+
+        lock.lock();
+        const double wait_us = std::chrono::duration<double, std::micro>(start - next.queued).count();
+        const double service_us = std::chrono::duration<double, std::micro>(end - start).count();
+        target.wait_total_us += wait_us;
+        target.wait_max_us = std::max(target.wait_max_us, wait_us);
+        target.service_total_us += service_us;
+        target.service_max_us = std::max(target.service_max_us, service_us);
+        target.completed++;
+        target.running--;
+        if (target.heap.empty() && target.running == 0) {
+            target.idle.notify_all();
+        }
+    }
+}
+
+void psid_dispatcher::drain() {
+    for (auto &target : lanes) {
+        std::unique_lock<std::mutex> lock(target->mutex);
+        target->idle.wait(lock, [&target]() { return target->heap.empty() && target->running == 0; });
+    }
+}
+
+void psid_dispatcher::print_report() const {
+    for (const auto &target : lanes) {
+        std::lock_guard<std::mutex> guard(target->mutex);
+        std::string psids;
+        for (uint8_t psid : target->options.psids) {
+            psids += (psids.empty() ? "" : ",") + std::to_string(psid);
+        }
+        const double completed = static_cast<double>(target->completed);
+        std::cout << "DISPATCH class=" << target->options.name
+                  << " psids=" << (psids.empty() ? "any" : psids)
+                  << " min_priority=" << static_cast<int>(target->options.min_priority)
+                  << " verifiers=" << target->options.verifiers
+                  << " messages=" << target->completed
+                  << " dropped=" << target->dropped
+                  << " max_depth=" << target->max_depth
+                  << " wait_avg_us=" << (completed > 0 ? target->wait_total_us / completed : 0.0)
+                  << " wait_max_us=" << target->wait_max_us
+                  << " verify_avg_us=" << (completed > 0 ? target->service_total_us / completed : 0.0)
+                  << " verify_max_us=" << target->service_max_us
+                  << std::endl;
+    }
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "readiness.h"
+
+namespace {
+
+bool write_all(int fd, const std::string &text) {
+    std::size_t written = 0;
+    while (written < text.size()) {
+        const ssize_t result = write(fd, text.data() + written, text.size() - written);
+        if (result < 0) {
+            return false;
+        }
+        written += static_cast<std::size_t>(result);
+    }
+    return true;
+}
+
+} // namespace
+
+void signal_ready(uint16_t port) {
+    const std::string line = "ready " + std::to_string(port) + "\n";
+
+    if (const char *fd_env = std::getenv("V2X_READY_FD")) {
+        const int fd = static_cast<int>(std::strtol(fd_env, nullptr, 10));
+        if (!write_all(fd, line)) {
+            perror("write V2X_READY_FD failed");
+        }
+        close(fd);
+    }
+
+    if (const char *path = std::getenv("V2X_READY_FILE")) {
+        // write then rename, so a waiter never sees a half-written file
+        const std::string temporary = std::string(path) + ".tmp";
+        const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || !write_all(fd, line) || close(fd) < 0 || rename(temporary.c_str(), path) < 0) {
+            perror("creating V2X_READY_FILE failed");
+        }
+    }
+}
+
+void wait_for_ready() {
+    const char *path = std::getenv("V2X_READY_FILE");
+    if (path == nullptr) {
+        return;
+    }
+    long timeout_ms = 10000;
+    if (const char *timeout_env = std::getenv("V2X_READY_TIMEOUT_MS")) {
+        timeout_ms = std::strtol(timeout_env, nullptr, 10);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (access(path, F_OK) != 0) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            std::cerr << "Receiver did not signal readiness in " << path << " within " << timeout_ms << " ms"
+                      << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#include "resource_usage.h"
+
+namespace {
+
+const auto process_start = std::chrono::steady_clock::now();
+
+long long timeval_us(const timeval &value) {
+    return static_cast<long long>(value.tv_sec) * 1000000LL + value.tv_usec;
+}
+
+long long clock_us(clockid_t clock) {
+    timespec now{};
+    clock_gettime(clock, &now);
+    return static_cast<long long>(now.tv_sec) * 1000000LL + now.tv_nsec / 1000;
+}
+
+resource_usage from_rusage(int who, clockid_t clock) {
+    rusage usage{};
+    getrusage(who, &usage);
+
+    resource_usage result;
+    result.cpu_us = clock_us(clock);
+    result.user_us = timeval_us(usage.ru_utime);
+    result.system_us = timeval_us(usage.ru_stime);
+    result.voluntary_switches = usage.ru_nvcsw;
+    result.involuntary_switches = usage.ru_nivcsw;
+    result.minor_faults = usage.ru_minflt;
+    result.major_faults = usage.ru_majflt;
+
+    // RUSAGE_THREAD leaves ru_maxrss at zero; the peak is a process property anyway
+    rusage self{};
+    getrusage(RUSAGE_SELF, &self);
+    result.max_rss_kb = self.ru_maxrss;
+    return result;
+}
+
+} // namespace
+
+resource_usage thread_resource_usage() {
+    return from_rusage(RUSAGE_THREAD, CLOCK_THREAD_CPUTIME_ID);
+}
+
+resource_usage process_resource_usage() {
+    return from_rusage(RUSAGE_SELF, CLOCK_PROCESS_CPUTIME_ID);
+}
+
+resource_usage usage_since(const resource_usage &start, const resource_usage &end) {
+    resource_usage result;
+    result.cpu_us = end.cpu_us - start.cpu_us;
+    result.user_us = end.user_us - start.user_us;
+    result.system_us = end.system_us - start.system_us;
+    result.max_rss_kb = end.max_rss_kb;
+    result.voluntary_switches = end.voluntary_switches - start.voluntary_switches;
+    result.involuntary_switches = end.involuntary_switches - start.involuntary_switches;
+    result.minor_faults = end.minor_faults - start.minor_faults;
+    result.major_faults = end.major_faults - start.major_faults;
+    return result;
+}
+
+long long process_wall_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - process_start).count();
+}
+
+long long thread_usage_meter::wall_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+}
+
+void record_resource_usage(const std::string &role, const std::string &thread, int scheme, long long wall_us,
+                           const resource_usage &usage) {
+    const char *path = std::getenv("V2X_RESOURCE_FILE");
+    if (path == nullptr) {
+        return;
+    }
+    const char *run_id = std::getenv("V2X_METRICS_RUN");
+    const char *note = std::getenv("V2X_METRICS_NOTE");
+
+    std::ostringstream row;
+    row << (run_id != nullptr ? run_id : "0") << ','
+        << role << ','
+        << thread << ','
+        << scheme << ','
+        << wall_us << ','
+        << usage.cpu_us << ','
+        << usage.user_us << ','
+        << usage.system_us << ','
+        << usage.max_rss_kb << ','
+        << usage.voluntary_switches << ','
+        << usage.involuntary_switches << ','
+        << usage.minor_faults << ','
+        << usage.major_faults << ','
+        << (note != nullptr ? note : "") << '\n';
+    const std::string line = row.str();
+
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("open V2X_RESOURCE_FILE failed");
+        return;
+    }
+    // the transmitter's vehicles and the receiver may all append at once; the lock also covers the header check
+    flock(fd, LOCK_EX);
+    struct stat info{};
+    std::string out;
+    if (fstat(fd, &info) == 0 && info.st_size == 0) {
+        out = "run,role,thread,scheme,wall_us,cpu_us,user_us,system_us,max_rss_kb,"
+              "voluntary_switches,involuntary_switches,minor_faults,major_faults,note\n";
+    }
+    out += line;
+    if (write(fd, out.data(), out.size()) != static_cast<ssize_t>(out.size())) {
+        perror("write V2X_RESOURCE_FILE failed");
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include <openssl/sha.h>
+#include <oqs/oqs.h>
+
+#include "hsm_protocol.h"
+#include "instrumentation.h"
+#include "perf_counters.h"
+#include "signing_backend.h"
+
+std::vector<uint8_t> ecdsa_sign_digest(const unsigned char *digest, EC_KEY *key) {
+    unsigned int signature_length = ECDSA_size(key);
+    std::vector<uint8_t> signature(signature_length, 0);
+    ecdsa_sign(const_cast<unsigned char *>(digest), key, &signature_length, signature.data());
+    signature.resize(signature_length);
+    return signature;
+}
+
+std::vector<uint8_t> falcon_sign_message(const uint8_t *message, std::size_t message_len,
+                                         const std::vector<uint8_t> &private_key) {
+    if (private_key.empty()) {
+        std::cerr << "Falcon private key not loaded" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<uint8_t> signature(OQS_SIG_falcon_512_length_signature, 0);
+    size_t signature_len = signature.size();
+    falcon_sign(signature.data(),
+                signature_len,
+                const_cast<uint8_t *>(message),
+                message_len,
+                const_cast<uint8_t *>(private_key.data()));
+    signature.resize(signature_len);
+    return signature;
+}
+
+void local_signing_backend::sign(signing_request &request) {
+    perf_scope counters(perf_stage::sign, &request.perf);
+    if (request.scheme == signature_scheme::FALCON && request.kind == verification_key_kind::MESSAGE) {
+        V2X_PROBE_SCOPE(falcon_sign);
+        request.signature = falcon_sign_message(request.message, request.message_len, falcon_key);
+        return;
+    }
+
+    V2X_PROBE_SCOPE(ecdsa_sign);
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    sha256sum(const_cast<uint8_t *>(request.message), request.message_len, digest);
+    request.signature = ecdsa_sign_digest(digest, request.kind == verification_key_kind::CERTIFICATE
+                                                  ? certificate_key : message_key);
+}
+
+void local_signing_backend::sign_batch(std::vector<signing_request> &requests) {
+    for (auto &request : requests) {
+        sign(request);
+    }
+}
+
+hsm_signing_backend::hsm_signing_backend(const std::string &socket_path) {
+    if ((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        perror("HSM socket creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(sockfd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        std::cerr << "HSM emulator is not running (cannot connect to " << socket_path << ": "
+                  << std::strerror(errno) << ")" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+hsm_signing_backend::~hsm_signing_backend() {
+    if (sockfd >= 0) {
+        close(sockfd);
+    }
+}
+
+void hsm_signing_backend::sign_batch(std::vector<signing_request> &requests) {
+    // Write the whole batch before reading anything back so the device always has work queued.
+    std::unordered_map<uint32_t, std::size_t> outstanding;
+    std::vector<uint8_t> frame;
+    for (std::size_t i = 0; i < requests.size(); i++) {
+        auto &request = requests[i];
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        const uint8_t *payload = request.message;
+        std::size_t payload_len = request.message_len;
+        if (request.scheme == signature_scheme::ECDSA || request.kind == verification_key_kind::CERTIFICATE) {
+            sha256sum(const_cast<uint8_t *>(request.message), request.message_len, digest);
+            payload = digest;
+            payload_len = sizeof(digest);
+        }
+        if (payload_len > HSM_MAX_PAYLOAD) {
+            std::cerr << "Message too large for the HSM: " << payload_len << " bytes" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        hsm_request_header header{};
+        header.request_id = next_request_id++;
+        header.scheme = static_cast<uint8_t>(request.scheme);
+        header.key_kind = static_cast<uint8_t>(request.kind);
+        header.key_id = request.key_id;
+        header.payload_len = static_cast<uint32_t>(payload_len);
+        outstanding[header.request_id] = i;
+
+        const auto *header_bytes = reinterpret_cast<const uint8_t *>(&header);
+        frame.insert(frame.end(), header_bytes, header_bytes + sizeof(header));
+        frame.insert(frame.end(), payload, payload + payload_len);
+    }
+
+    if (!hsm_write_full(sockfd, frame.data(), frame.size())) {
+        perror("HSM request write failed");
+        exit(EXIT_FAILURE);
+    }
+
+    while (!outstanding.empty()) {
+        hsm_response_header response{};
+        if (!hsm_read_full(sockfd, &response, sizeof(response)) || response.signature_len > HSM_MAX_SIGNATURE) {
+            std::cerr << "HSM connection lost" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        auto it = outstanding.find(response.request_id);
+        if (it == outstanding.end()) {
+            std::cerr << "Unexpected HSM response " << response.request_id << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        auto &signature = requests[it->second].signature;
+        signature.assign(response.signature_len, 0);
+        if (!hsm_read_full(sockfd, signature.data(), signature.size())) {
+            std::cerr << "HSM connection lost" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (response.status != HSM_STATUS_OK || signature.empty()) {
+            std::cerr << "HSM failed to sign request " << response.request_id << " (status " << response.status
+                      << ")" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        outstanding.erase(it);
+    }
+}
+
+std::unique_ptr<signing_backend> make_signing_backend(const signing_backend_options &options,
+                                                      EC_KEY *message_key,
+                                                      EC_KEY *certificate_key,
+                                                      const std::vector<uint8_t> &falcon_key) {
+    if (options.backend == "hsm") {
+        return std::unique_ptr<signing_backend>(new hsm_signing_backend(options.hsm_socket));
+    }
+    if (options.backend != "local") {
+        std::cerr << "Unknown signing backend: " << options.backend << " (expected local or hsm)" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return std::unique_ptr<signing_backend>(new local_signing_backend(message_key, certificate_key, falcon_key));
+}
@@ -0,0 +1,242 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "spdu_capture.h"
+#include "thread_affinity.h"
+
+namespace {
+
+constexpr std::size_t RECORD_ALIGNMENT = 8;
+
+std::size_t padded(std::size_t bytes) {
+    return (bytes + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+}
+
+std::string numbered_path(const std::string &directory, uint32_t segment, const char *extension) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "spdu-%06u.%s", segment, extension);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+// One past the highest segment number already in `directory`, so a new run never touches old segments.
+uint32_t next_segment_number(const std::string &directory) {
+    uint32_t next = 0;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        unsigned number = 0;
+        char extension[4] = {};
+        const std::string name = entry.path().filename().string();
+        if (std::sscanf(name.c_str(), "spdu-%6u.%3s", &number, extension) == 2 && std::strcmp(extension, "seg") == 0) {
+            next = std::max(next, static_cast<uint32_t>(number) + 1);
+        }
+    }
+    return next;
+}
+
+void write_all(int fd, const void *data, std::size_t bytes, const std::string &what) {
+    const auto *cursor = static_cast<const uint8_t *>(data);
+    while (bytes > 0) {
+        const ssize_t result = write(fd, cursor, bytes);
+        if (result < 0) {
+            perror(("Error writing " + what).c_str());
+            exit(EXIT_FAILURE);
+        }
+        cursor += result;
+        bytes -= static_cast<std::size_t>(result);
+    }
+}
+
+} // namespace
+
+std::string capture_segment_path(const std::string &directory, uint32_t segment) {
+    return numbered_path(directory, segment, "seg");
+}
+
+std::string capture_index_path(const std::string &directory, uint32_t segment) {
+    return numbered_path(directory, segment, "idx");
+}
+
+spdu_capture::spdu_capture(const capture_options &options) : options(options) {
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if (error) {
+        std::cerr << "Error creating capture directory " << options.directory << ": " << error.message() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    this->options.segment_bytes = std::max<std::size_t>(options.segment_bytes, 1u << 20);
+    this->options.queue_capacity = std::max<std::size_t>(options.queue_capacity, 1);
+    segment = next_segment_number(options.directory);
+    open_segment(0);
+    writer = std::thread(&spdu_capture::run, this);
+    pin_thread(writer.native_handle(), this->options.cpus);
+}
+
+spdu_capture::~spdu_capture() {
+    close();
+}
+
+void spdu_capture::close() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+bool spdu_capture::append(const capture_record &record, const void *data, std::size_t data_bytes,
+                          const uint8_t *signature, std::size_t signature_bytes) {
+    pending_record pending;
+    pending.record = record;
+    pending.record.data_bytes = static_cast<uint16_t>(data_bytes);
+    pending.record.signature_bytes = static_cast<uint16_t>(signature_bytes);
+    pending.record.payload_bytes = static_cast<uint32_t>(data_bytes + signature_bytes);
+    // copied outside the lock; the writer only ever sees complete records
+    pending.payload.resize(data_bytes + signature_bytes);
+    std::memcpy(pending.payload.data(), data, data_bytes);
+    if (signature_bytes > 0) {
+        std::memcpy(pending.payload.data() + data_bytes, signature, signature_bytes);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (stopping || queue.size() >= options.queue_capacity) {
+            dropped_count++;
+            return false;
+        }
+        queue.push_back(std::move(pending));
+    }
+    wake.notify_one();
+    return true;
+}
+
+void spdu_capture::run() {
+    std::vector<pending_record> batch;
+    std::vector<capture_index_entry> index;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            break;      // stopping, and everything has been written
+        }
+        batch.swap(queue);
+        lock.unlock();
+
+        for (const auto &pending : batch) {
+            write_record(pending, index);
+        }
+        flush_index(index);
+        batch.clear();
+
+        lock.lock();
+    }
+    lock.unlock();
+    close_segment(index);
+}
+
+void spdu_capture::write_record(const pending_record &pending, std::vector<capture_index_entry> &index) {
+    const std::size_t record_bytes = sizeof(capture_record) + padded(pending.payload.size());
+    auto *header = reinterpret_cast<capture_segment_header *>(mapping);
+    if (header->used_bytes + record_bytes > mapping_bytes) {
+        close_segment(index);
+        segment++;
+        open_segment(sizeof(capture_segment_header) + record_bytes);
+        header = reinterpret_cast<capture_segment_header *>(mapping);
+    }
+
+    const uint64_t offset = header->used_bytes;
+    std::memcpy(mapping + offset, &pending.record, sizeof(capture_record));
+    std::memcpy(mapping + offset + sizeof(capture_record), pending.payload.data(), pending.payload.size());
+    // publish the record only once it is complete
+    header->used_bytes = offset + record_bytes;
+    header->record_count++;
+
+    capture_index_entry entry{};
+    entry.offset = offset;
+    entry.receive_time_us = pending.record.receive_time_us;
+    entry.sequence_number = pending.record.sequence_number;
+    entry.vehicle_id = pending.record.vehicle_id;
+    entry.flags = pending.record.flags;
+    entry.signature_scheme = pending.record.signature_scheme;
+    entry.psid = pending.record.psid;
+    index.push_back(entry);
+
+    written++;
+    written_bytes += record_bytes;
+}
+
+void spdu_capture::open_segment(std::size_t minimum_bytes) {
+    // another receiver logging to the same directory may have taken this number; move on to the next free one
+    std::string path = capture_segment_path(options.directory, segment);
+    while ((segment_fd = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644)) < 0 && errno == EEXIST) {
+        path = capture_segment_path(options.directory, ++segment);
+    }
+    if (segment_fd < 0) {
+        perror(("Error creating capture segment " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+    mapping_bytes = std::max(options.segment_bytes, minimum_bytes);
+    // sparse until written; trimmed to the used size when the segment is closed
+    if (ftruncate(segment_fd, static_cast<off_t>(mapping_bytes)) < 0) {
+        perror(("Error sizing capture segment " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+    void *address = mmap(nullptr, mapping_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, segment_fd, 0);
+    if (address == MAP_FAILED) {
+        perror(("Error mapping capture segment " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+    mapping = static_cast<uint8_t *>(address);
+
+    capture_segment_header header{};
+    std::memcpy(header.magic, CAPTURE_SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = 1;
+    header.segment = segment;
+    header.used_bytes = sizeof(capture_segment_header);
+    header.created_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::memcpy(mapping, &header, sizeof(header));
+
+    const std::string index_path = capture_index_path(options.directory, segment);
+    index_fd = open(index_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (index_fd < 0) {
+        perror(("Error creating capture index " + index_path).c_str());
+        exit(EXIT_FAILURE);
+    }
+}
+
+void spdu_capture::close_segment(std::vector<capture_index_entry> &index) {
+    flush_index(index);
+    const auto used = reinterpret_cast<const capture_segment_header *>(mapping)->used_bytes;
+    munmap(mapping, mapping_bytes);
+    mapping = nullptr;
+    if (ftruncate(segment_fd, static_cast<off_t>(used)) < 0) {
+        perror("Error trimming capture segment");
+    }
+    ::close(segment_fd);
+    ::close(index_fd);
+    segment_fd = -1;
+    index_fd = -1;
+}
+
+void spdu_capture::flush_index(std::vector<capture_index_entry> &index) {
+    if (!index.empty()) {
+        write_all(index_fd, index.data(), index.size() * sizeof(capture_index_entry), "capture index");
+        index.clear();
+    }
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <sched.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "thread_affinity.h"
+
+namespace {
+std::vector<int> parse_cpu_list(const std::string &list, const std::string &spec) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(),
+                                   [](unsigned char c) { return std::isspace(c) != 0; }),
+                    range.end());
+        if (range.empty()) {
+            continue;
+        }
+        try {
+            std::size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                throw std::out_of_range(range);
+            }
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception &) {
+            std::cerr << "Invalid CPU list \"" << spec << "\"" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string read_sysfs_list(const std::string &path) {
+    std::ifstream file(path);
+    std::string contents;
+    std::getline(file, contents);
+    return contents;
+}
+} // namespace
+
+std::vector<int> parse_cpu_spec(const std::string &spec) {
+    if (spec.empty() || spec == "none") {
+        return {};
+    }
+    if (spec == "isolated") {
+        return parse_cpu_list(read_sysfs_list("/sys/devices/system/cpu/isolated"), spec);
+    }
+    if (spec.rfind("node:", 0) == 0) {
+        std::string path = "/sys/devices/system/node/node" + spec.substr(5) + "/cpulist";
+        std::ifstream node(path);
+        if (!node.is_open()) {
+            std::cerr << "Unknown NUMA node in \"" << spec << "\" (" << path << " not found)" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return parse_cpu_list(read_sysfs_list(path), spec);
+    }
+    return parse_cpu_list(spec, spec);
+}
+
+thread_placement default_thread_placement() {
+    thread_placement placement;
+    auto isolated = parse_cpu_spec("isolated");
+    if (isolated.empty()) {
+        return placement;
+    }
+
+    placement.receiver = {isolated[0]};
+    placement.transmitter = {isolated[1 % isolated.size()]};
+    if (isolated.size() > 2) {
+        placement.verifier.assign(isolated.begin() + 2, isolated.end());
+    } else {
+        placement.verifier = isolated;
+    }
+    placement.hsm = placement.verifier;
+    return placement;
+}
+
+std::string describe_cpu_list(const std::vector<int> &cpus) {
+    if (cpus.empty()) {
+        return "any";
+    }
+
+    std::string description;
+    for (std::size_t i = 0; i < cpus.size(); i++) {
+        std::size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+        if (!description.empty()) {
+            description += ',';
+        }
+        description += std::to_string(cpus[i]);
+        if (j > i) {
+            description += '-' + std::to_string(cpus[j]);
+        }
+        i = j;
+    }
+    return description;
+}
+
+std::vector<int> cpus_excluding(const std::vector<int> &cpus, const std::vector<int> &excluded) {
+    std::vector<int> remaining;
+    for (int cpu : cpus) {
+        if (std::find(excluded.begin(), excluded.end(), cpu) == excluded.end()) {
+            remaining.push_back(cpu);
+        }
+    }
+    return remaining;
+}
+
+void pin_thread(pthread_t thread, const std::vector<int> &cpus) {
+    if (cpus.empty()) {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int result = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (result != 0) {
+        std::cerr << "Unable to pin thread to CPUs " << describe_cpu_list(cpus) << ": "
+                  << std::strerror(result) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+void pin_current_thread_round_robin(const std::vector<int> &cpus, std::size_t index) {
+    if (cpus.empty()) {
+        return;
+    }
+    pin_thread(pthread_self(), {cpus[index % cpus.size()]});
+}
+
+std::vector<int> current_thread_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "trace_format.h"
+#include "trace_generator.h"
+
+void write_binary_trace(const std::string &path, const std::vector<trace_row> &rows, bool create) {
+    FILE *file = std::fopen(path.c_str(), create ? "wb" : "ab");
+    if (file == nullptr) {
+        perror(("Error opening trace file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    bool ok = true;
+    if (create) {
+        unsigned char header[BINARY_TRACE_HEADER_BYTES];
+        const uint32_t fields = TRACE_ROW_FIELDS;
+        const auto tick_ms = static_cast<uint32_t>(TRACE_TICK_MS);
+        std::memcpy(header, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+        std::memcpy(header + 8, &fields, sizeof(fields));
+        std::memcpy(header + 12, &tick_ms, sizeof(tick_ms));
+        ok = std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    }
+    if (ok && !rows.empty()) {
+        ok = std::fwrite(rows.data(), sizeof(trace_row), rows.size(), file) == rows.size();
+    }
+    if (std::fclose(file) != 0 || !ok) {
+        perror(("Error writing trace file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+}
+
+FILE *open_binary_trace(const std::string &path) {
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        if (errno == ENOENT) {
+            return nullptr;
+        }
+        perror(("Error opening trace file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned char header[BINARY_TRACE_HEADER_BYTES] = {};
+    uint32_t fields = 0;
+    if (std::fread(header, 1, sizeof(header), file) == sizeof(header)) {
+        std::memcpy(&fields, header + 8, sizeof(fields));
+    }
+    if (std::memcmp(header, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) != 0 || fields != TRACE_ROW_FIELDS) {
+        std::cerr << path << " is not a binary trace" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return file;
+}
@@ -0,0 +1,379 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "bsm.h"
+#include "trace_generator.h"
+
+namespace {
+
+constexpr double TICK_S = TRACE_TICK_MS / 1000;
+constexpr double MIN_TURN_SPEED_MPS = 2.0;
+constexpr double ARRIVED_M = 0.05;          // closer than this to a stop counts as stopped there
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+double distance(const trace_point &a, const trace_point &b) {
+    return std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y) + (b.z - a.z) * (b.z - a.z));
+}
+
+// Speed at which a vehicle can take the corner a -> b -> c: full speed when going straight, down to a crawl for a
+// U-turn.
+double corner_speed(const trace_point &a, const trace_point &b, const trace_point &c, double cruise) {
+    const double in_x = b.x - a.x, in_y = b.y - a.y;
+    const double out_x = c.x - b.x, out_y = c.y - b.y;
+    const double norms = std::hypot(in_x, in_y) * std::hypot(out_x, out_y);
+    if (norms == 0) {
+        return cruise;
+    }
+    const double turn = std::acos(std::clamp((in_x * out_x + in_y * out_y) / norms, -1.0, 1.0));
+    return std::max(MIN_TURN_SPEED_MPS, cruise * (1 - turn / M_PI));
+}
+
+// Random walk over grid intersections, never turning back unless at a dead end.
+class grid_route {
+public:
+    grid_route(const trace_options &options, std::mt19937_64 &rng) : options(options), rng(rng) {
+        std::uniform_int_distribution<int> node(0, options.grid_blocks);
+        from_i = node(rng);
+        from_j = node(rng);
+        pick_next(from_i, from_j, -1, -1, to_i, to_j);
+        pick_next(to_i, to_j, from_i, from_j, after_i, after_j);
+    }
+
+    trace_point from() const { return point(from_i, from_j); }
+    trace_point to() const { return point(to_i, to_j); }
+    trace_point after() const { return point(after_i, after_j); }
+
+    bool stops_at_to() {
+        return std::uniform_real_distribution<double>(0, 1)(rng) < options.stop_probability;
+    }
+
+    void advance() {
+        from_i = to_i;
+        from_j = to_j;
+        to_i = after_i;
+        to_j = after_j;
+        pick_next(to_i, to_j, from_i, from_j, after_i, after_j);
+    }
+
+private:
+    trace_point point(int i, int j) const {
+        return {i * options.grid_spacing_m, j * options.grid_spacing_m, 0};
+    }
+
+    void pick_next(int i, int j, int back_i, int back_j, int &next_i, int &next_j) {
+        static constexpr int moves[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        int candidates[4][2];
+        int count = 0;
+        for (const auto &move : moves) {
+            const int ni = i + move[0], nj = j + move[1];
+            if (ni < 0 || nj < 0 || ni > options.grid_blocks || nj > options.grid_blocks ||
+                (ni == back_i && nj == back_j)) {
+                continue;
+            }
+            candidates[count][0] = ni;
+            candidates[count][1] = nj;
+            count++;
+        }
+        if (count == 0) {
+            next_i = back_i;
+            next_j = back_j;
+            return;
+        }
+        const int choice = std::uniform_int_distribution<int>(0, count - 1)(rng);
+        next_i = candidates[choice][0];
+        next_j = candidates[choice][1];
+    }
+
+    const trace_options &options;
+    std::mt19937_64 &rng;
+    int from_i = 0, from_j = 0, to_i = 0, to_j = 0, after_i = 0, after_j = 0;
+};
+
+// Along one polyline from a random vertex, turning round (after a stop) at either end.
+class polyline_route {
+public:
+    polyline_route(const std::vector<trace_point> &line, std::mt19937_64 &rng) : line(line) {
+        from_index = std::uniform_int_distribution<long>(0, static_cast<long>(line.size()) - 1)(rng);
+        direction = std::uniform_int_distribution<int>(0, 1)(rng) == 0 ? 1 : -1;
+        to_index = step(from_index, direction);
+        after_index = step(to_index, direction);
+    }
+
+    trace_point from() const { return line[from_index]; }
+    trace_point to() const { return line[to_index]; }
+    trace_point after() const { return line[after_index]; }
+
+    bool stops_at_to() const {
+        return after_index == from_index;
+    }
+
+    void advance() {
+        direction = after_index > to_index ? 1 : -1;
+        from_index = to_index;
+        to_index = after_index;
+        after_index = step(to_index, direction);
+    }
+
+private:
+    // The vertex after `index` going in `dir`, or the one behind it at the ends.
+    long step(long index, int &dir) const {
+        if (index + dir < 0 || index + dir >= static_cast<long>(line.size())) {
+            dir = -dir;
+        }
+        return index + dir;
+    }
+
+    const std::vector<trace_point> &line;
+    long from_index = 0, to_index = 0, after_index = 0;
+    int direction = 1;
+};
+
+void append_value(std::string &out, double value, char separator) {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, 2);
+    out.append(text, result.ptr);
+    out.push_back(separator);
+}
+
+// Drive one vehicle along `route` for options.steps ticks and return its trace file contents.
+template <typename Route>
+std::string drive(Route &route, const trace_options &options, std::mt19937_64 &rng) {
+    std::uniform_real_distribution<double> cruise_draw(0.7 * options.max_speed_mps, options.max_speed_mps);
+    std::uniform_real_distribution<double> stop_draw(1, std::max(1.0, options.max_stop_s));
+
+    double cruise = cruise_draw(rng);
+    bool stop_ahead = route.stops_at_to();
+    double along = 0;           // metres travelled from route.from()
+    double speed = 0;
+    double dwell = 0;           // seconds left standing at the current stop
+    trace_point previous = route.from();
+
+    std::string out;
+    out.reserve(static_cast<std::size_t>(options.steps) * 40);
+
+    for (int step = 0; step < options.steps; step++) {
+        if (dwell > 0) {
+            dwell -= TICK_S;
+            speed = 0;
+        } else {
+            double remaining = distance(route.from(), route.to()) - along;
+            const double exit_speed = stop_ahead ? 0 : corner_speed(route.from(), route.to(), route.after(), cruise);
+            // fastest speed from which the vehicle can still slow to exit_speed by the end of the segment
+            const double target = std::min(cruise, std::sqrt(exit_speed * exit_speed +
+                                                             2 * options.decel_mps2 * std::max(remaining, 0.0)));
+            speed = speed < target ? std::min(speed + options.accel_mps2 * TICK_S, target) : target;
+
+            double travel = speed * TICK_S;
+            if (stop_ahead && remaining - travel < ARRIVED_M) {
+                travel = remaining + ARRIVED_M;
+            }
+            while (travel >= remaining) {
+                travel -= remaining;
+                const bool stopping = stop_ahead;
+                route.advance();
+                along = 0;
+                cruise = cruise_draw(rng);
+                stop_ahead = route.stops_at_to();
+                if (stopping) {
+                    dwell = stop_draw(rng);
+                    travel = 0;
+                    speed = 0;
+                    break;
+                }
+                remaining = distance(route.from(), route.to());
+            }
+            along += travel;
+        }
+
+        const trace_point from = route.from(), to = route.to();
+        const double length = distance(from, to);
+        const double fraction = length > 0 ? std::min(along / length, 1.0) : 0;
+        const trace_point here = {from.x + (to.x - from.x) * fraction,
+                                  from.y + (to.y - from.y) * fraction,
+                                  from.z + (to.z - from.z) * fraction};
+        const bool moved = here.x != previous.x || here.y != previous.y;
+
+        append_value(out, here.x, ',');
+        append_value(out, here.y, ',');
+        append_value(out, here.z, ',');
+        append_value(out, step == 0 ? 0 : calculate_speed_kph(static_cast<float>(previous.x),
+                                                              static_cast<float>(here.x),
+                                                              static_cast<float>(previous.y),
+                                                              static_cast<float>(here.y),
+                                                              static_cast<float>(TRACE_TICK_MS)), ',');
+        append_value(out, calculate_heading(static_cast<float>(moved ? previous.x : from.x),
+                                            static_cast<float>(moved ? here.x : to.x),
+                                            static_cast<float>(moved ? previous.y : from.y),
+                                            static_cast<float>(moved ? here.y : to.y)), '\n');
+        previous = here;
+    }
+    return out;
+}
+
+void write_file(const std::string &path, const std::string &contents) {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr || std::fwrite(contents.data(), 1, contents.size(), file) != contents.size()) {
+        perror(("Error writing trace file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+    if (std::fclose(file) != 0) {
+        perror(("Error writing trace file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+}
+
+} // namespace
+
+trace_model parse_trace_model(const std::string &name) {
+    if (name == "grid") {
+        return trace_model::GRID;
+    }
+    if (name == "polyline") {
+        return trace_model::POLYLINE;
+    }
+    std::cerr << "Unknown trace model '" << name << R"(' (expected "grid" or "polyline"))" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+const char *trace_model_name(trace_model model) {
+    switch (model) {
+        case trace_model::GRID:
+            return "grid";
+        case trace_model::POLYLINE:
+            return "polyline";
+    }
+    return "unknown";
+}
+
+std::vector<std::vector<trace_point>> load_polylines(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        perror(("Error opening polyline file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+
+    std::vector<std::vector<trace_point>> polylines(1);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line.find_first_not_of(" \t\r") == std::string::npos) {
+            if (!polylines.back().empty()) {
+                polylines.emplace_back();
+            }
+            continue;
+        }
+        if (line[line.find_first_not_of(" \t")] == '#') {
+            continue;
+        }
+
+        std::stringstream fields(line);
+        std::string field;
+        std::vector<double> values;
+        while (std::getline(fields, field, ',')) {
+            char *end = nullptr;
+            values.push_back(std::strtod(field.c_str(), &end));
+            if (end == field.c_str()) {
+                values.clear();
+                break;
+            }
+        }
+        if (values.size() < 2 || values.size() > 3) {
+            std::cerr << path << ":" << line_number << ": expected \"x,y\" or \"x,y,z\"" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        polylines.back().push_back({values[0], values[1], values.size() == 3 ? values[2] : 0});
+    }
+
+    polylines.erase(std::remove_if(polylines.begin(), polylines.end(),
+                                   [](const std::vector<trace_point> &polyline) { return polyline.size() < 2; }),
+                    polylines.end());
+    if (polylines.empty()) {
+        std::cerr << "No polyline with at least two points in " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return polylines;
+}
+
+void generate_traces(const trace_options &options) {
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::vector<trace_point>> polylines;
+    if (options.model == trace_model::POLYLINE) {
+        polylines = load_polylines(options.polyline_file);
+    }
+    if (options.model == trace_model::GRID && options.grid_blocks < 1) {
+        std::cerr << "The trace grid needs at least one block per side" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if (error) {
+        std::cerr << "Error creating trace directory " << options.directory << ": " << error.message() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(std::max(options.vehicles, 1))));
+
+    std::atomic<int> next{0};
+    std::atomic<std::size_t> bytes{0};
+    auto worker = [&]() {
+        for (int vehicle = next++; vehicle < options.vehicles; vehicle = next++) {
+            std::mt19937_64 rng(splitmix64(options.seed ^ splitmix64(static_cast<uint64_t>(vehicle))));
+            std::string contents;
+            if (options.model == trace_model::GRID) {
+                grid_route route(options, rng);
+                contents = drive(route, options, rng);
+            } else {
+                polyline_route route(polylines[static_cast<std::size_t>(vehicle) % polylines.size()], rng);
+                contents = drive(route, options, rng);
+            }
+            write_file(options.directory + "/" + std::to_string(vehicle) + ".csv", contents);
+            bytes += contents.size();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : pool) {
+        thread.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double rows = static_cast<double>(options.vehicles) * options.steps;
+    std::cout << "TRACES model=" << trace_model_name(options.model)
+              << " vehicles=" << options.vehicles
+              << " steps=" << options.steps
+              << " threads=" << threads
+              << " seed=" << options.seed
+              << " bytes=" << bytes.load()
+              << " seconds=" << seconds
+              << " rows_per_s=" << (seconds > 0 ? rows / seconds : 0.0)
+              << " directory=" << options.directory
+              << std::endl;
+}
@@ -0,0 +1,196 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+#include "trace_reader.h"
+
+// One thread reads ahead for every trace_reader in the process: trace I/O is sequential and small, and a thread per
+// vehicle would cost more than the reads it hides. Never destroyed, so it is safe to use from exit paths.
+class trace_prefetcher {
+public:
+    static trace_prefetcher &instance() {
+        static auto *prefetcher = new trace_prefetcher();
+        return *prefetcher;
+    }
+
+    void submit(trace_reader *reader, trace_reader::window *target) {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            jobs.emplace_back(reader, target);
+        }
+        wake.notify_one();
+    }
+
+private:
+    trace_prefetcher() {
+        std::thread(&trace_prefetcher::run, this).detach();
+    }
+
+    void run() {
+        for (;;) {
+            std::pair<trace_reader *, trace_reader::window *> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return !jobs.empty(); });
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            trace_reader &reader = *job.first;
+            reader.fill(*job.second);
+            {
+                std::lock_guard<std::mutex> guard(reader.mutex);
+                job.second->ready = true;
+                reader.fill_in_flight = false;
+            }
+            reader.filled.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::pair<trace_reader *, trace_reader::window *>> jobs;
+};
+
+trace_reader::trace_reader(const std::string &directory, int number, std::size_t window_rows)
+    : window_rows(std::max<std::size_t>(window_rows, 1)) {
+    const std::string base = directory + "/" + std::to_string(number);
+    path = base + ".bin";
+    file = open_binary_trace(path);
+    binary = file != nullptr;
+    if (!binary) {
+        path = base + ".csv";
+        file = std::fopen(path.c_str(), "r");
+        if (file == nullptr) {
+            perror(("Error opening trace file for vehicle " + std::to_string(number)).c_str());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // the first window is read here so the first message does not wait for the I/O thread
+    fill(*front);
+    if (front->rows.empty()) {
+        std::cerr << "Trace file " << path << " has no rows" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    current = previous = front->rows[0];
+    front_position = 1;
+    if (!front->last) {
+        request_fill(*back);
+    }
+}
+
+trace_reader::~trace_reader() {
+    std::unique_lock<std::mutex> lock(mutex);
+    filled.wait(lock, [this]() { return !fill_in_flight; });
+    std::fclose(file);
+    std::free(line);
+}
+
+const trace_row &trace_reader::row(std::size_t index) {
+    if (index == current_index) {
+        return current;
+    }
+    if (index + 1 == current_index) {
+        return previous;
+    }
+    if (index < current_index) {
+        std::cerr << "Trace " << path << " read out of order (row " << index << " after " << current_index << ")"
+                  << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    while (current_index < index) {
+        if (front_position == front->rows.size() && !front->last) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (!back->ready) {
+                    stall_count++;
+                    filled.wait(lock, [this]() { return back->ready; });
+                }
+                back->ready = false;
+            }
+            std::swap(front, back);
+            front_position = 0;
+            if (!front->last) {
+                request_fill(*back);
+            }
+        }
+
+        previous = current;
+        if (front_position < front->rows.size()) {
+            current = front->rows[front_position++];
+        }
+        current_index++;
+    }
+    return current;
+}
+
+void trace_reader::request_fill(window &target) {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        target.ready = false;
+        fill_in_flight = true;
+    }
+    trace_prefetcher::instance().submit(this, &target);
+}
+
+void trace_reader::fill(window &target) {
+    target.rows.resize(window_rows);
+    std::size_t count = 0;
+    if (binary) {
+        count = std::fread(target.rows.data(), sizeof(trace_row), window_rows, file);
+    } else {
+        while (count < window_rows && read_csv_row(target.rows[count])) {
+            count++;
+        }
+    }
+    if (std::ferror(file)) {
+        perror(("Error reading trace file " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+    target.rows.resize(count);
+    target.last = count < window_rows;
+}
+
+bool trace_reader::read_csv_row(trace_row &out) {
+    for (;;) {
+        if (::getline(&line, &line_capacity, file) < 0) {
+            return false;
+        }
+        float values[TRACE_ROW_FIELDS] = {};
+        std::size_t fields = 0;
+        const char *cursor = line;
+        char *end = nullptr;
+        while (fields < TRACE_ROW_FIELDS) {
+            const float value = std::strtof(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            values[fields++] = value;
+            cursor = end;
+            while (*cursor == ' ' || *cursor == '\t') {
+                cursor++;
+            }
+            if (*cursor != ',') {
+                break;
+            }
+            cursor++;
+        }
+        if (fields == 0) {
+            continue;           // blank line
+        }
+        if (fields < 3) {
+            std::cerr << "Trace file " << path << " has a row with fewer than three columns" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        out = {values[0], values[1], values[2], values[3], values[4]};
+        return true;
+    }
+}
@@ -1,31 +1,49 @@
 // Copyright (c) 2022. Geoff Twardokus
 // Reuse permitted under the MIT License as specified in the LICENSE file within this project.
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
 #include <openssl/ec.h>
 #include <openssl/sha.h>
 #include <oqs/oqs.h>
 
-void ecdsa_sign(unsigned char *hash, EC_KEY *signing_key, unsigned int* signature_buffer_length, unsigned char *signature) {
+#include "perf_counters.h"
+#include "v2vcrypto.h"
 
-    if(ECDSA_sign(0, hash, 32, signature, signature_buffer_length, signing_key) != 1) {
-        perror("Error in call to ECDSA_sign");
-        exit(EXIT_FAILURE);
-    }
+// Which Falcon variants exist is decided when falcon_sim is compiled, by the OQS_ENABLE_* switches of the liboqs
+// headers it is built against; a variant that is not compiled in is never offered. Only the choice among the
+// compiled-in variants (and the CPU check for AVX2) happens at run time, in select_crypto_kernels().
+#if defined(OQS_ENABLE_SIG_falcon_512)
+extern "C" int PQCLEAN_FALCON512_CLEAN_crypto_sign_signature(uint8_t *sig, size_t *siglen,
+                                                             const uint8_t *m, size_t mlen, const uint8_t *sk);
+extern "C" int PQCLEAN_FALCON512_CLEAN_crypto_sign_verify(const uint8_t *sig, size_t siglen,
+                                                          const uint8_t *m, size_t mlen, const uint8_t *pk);
+#endif
+#if defined(OQS_ENABLE_SIG_falcon_512_avx2)
+extern "C" int PQCLEAN_FALCON512_AVX2_crypto_sign_signature(uint8_t *sig, size_t *siglen,
+                                                            const uint8_t *m, size_t mlen, const uint8_t *sk);
+extern "C" int PQCLEAN_FALCON512_AVX2_crypto_sign_verify(const uint8_t *sig, size_t siglen,
+                                                         const uint8_t *m, size_t mlen, const uint8_t *pk);
+#endif
 
-}
+namespace {
 
-int ecdsa_verify(unsigned char *hash, unsigned char *signature, const unsigned int* signature_buffer_length, EC_KEY *verification_key) {
-    int result = ECDSA_verify(0, hash,32, signature, (int)*signature_buffer_length, verification_key);
-    if(result == -1) {
-        perror("Fatal error: ECDSA_verify returned -1");
-        exit(EXIT_FAILURE);
-    }
-    else
-        return result;
+// liboqs' public entry points do their own (build-dependent) dispatch; used when the individual variants are not
+// exported by the installed library.
+int liboqs_falcon_sign(uint8_t *signature, size_t *signature_len, const uint8_t *message, size_t message_len,
+                       const uint8_t *private_key) {
+    return OQS_SIG_falcon_512_sign(signature, signature_len, message, message_len, private_key) == OQS_SUCCESS ? 0 : -1;
+}
 
+int liboqs_falcon_verify(const uint8_t *signature, size_t signature_len, const uint8_t *message, size_t message_len,
+                         const uint8_t *public_key) {
+    return OQS_SIG_falcon_512_verify(message, message_len, signature, signature_len, public_key) == OQS_SUCCESS ? 0 : -1;
 }
 
-void sha256sum(void* data, unsigned long length, unsigned char* md) {
+void openssl_sha256(const void *data, unsigned long length, unsigned char *md) {
 
     SHA256_CTX context;
     if(!SHA256_Init(&context)) {
@@ -33,7 +51,7 @@ void sha256sum(void* data, unsigned long length, unsigned char* md) {
         exit(EXIT_FAILURE);
     }
 
-    if(!SHA256_Update(&context, (unsigned char*) data, length)) {
+    if(!SHA256_Update(&context, (const unsigned char*) data, length)) {
         perror("Error hashing provided input.");
         exit(EXIT_FAILURE);
     }
@@ -45,9 +63,209 @@ void sha256sum(void* data, unsigned long length, unsigned char* md) {
 
 }
 
+// Straightforward FIPS 180-4 SHA-256 without any SIMD or SHA-NI, used as the portable baseline for A/B runs
+// (OpenSSL always picks its fastest assembly path internally).
+constexpr uint32_t sha256_round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotr(uint32_t x, unsigned int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void sha256_compress(uint32_t state[8], const unsigned char block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+               (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+               static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                      sha256_round_constants[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void portable_sha256(const void *data, unsigned long length, unsigned char *md) {
+    uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+    const auto *input = static_cast<const unsigned char *>(data);
+    unsigned long remaining = length;
+    while (remaining >= 64) {
+        sha256_compress(state, input);
+        input += 64;
+        remaining -= 64;
+    }
+
+    unsigned char tail[128] = {};
+    std::memcpy(tail, input, remaining);
+    tail[remaining] = 0x80;
+    const std::size_t tail_length = remaining < 56 ? 64 : 128;
+    const uint64_t bit_length = static_cast<uint64_t>(length) * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_length - 1 - i] = static_cast<unsigned char>(bit_length >> (8 * i));
+    }
+    for (std::size_t offset = 0; offset < tail_length; offset += 64) {
+        sha256_compress(state, tail + offset);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        md[i * 4] = static_cast<unsigned char>(state[i] >> 24);
+        md[i * 4 + 1] = static_cast<unsigned char>(state[i] >> 16);
+        md[i * 4 + 2] = static_cast<unsigned char>(state[i] >> 8);
+        md[i * 4 + 3] = static_cast<unsigned char>(state[i]);
+    }
+}
+
+const crypto_kernels liboqs_kernels = {
+    "liboqs", "openssl", liboqs_falcon_sign, liboqs_falcon_verify, openssl_sha256
+};
+
+#if defined(OQS_ENABLE_SIG_falcon_512)
+const crypto_kernels portable_kernels = {
+    "portable", "portable",
+    PQCLEAN_FALCON512_CLEAN_crypto_sign_signature, PQCLEAN_FALCON512_CLEAN_crypto_sign_verify, portable_sha256
+};
+
+// AUTO on a host without AVX2: reference Falcon, but hashing keeps OpenSSL's best path
+const crypto_kernels fallback_kernels = {
+    "portable", "openssl",
+    PQCLEAN_FALCON512_CLEAN_crypto_sign_signature, PQCLEAN_FALCON512_CLEAN_crypto_sign_verify, openssl_sha256
+};
+#endif
+
+#if defined(OQS_ENABLE_SIG_falcon_512_avx2)
+const crypto_kernels avx2_kernels = {
+    "avx2", "openssl",
+    PQCLEAN_FALCON512_AVX2_crypto_sign_signature, PQCLEAN_FALCON512_AVX2_crypto_sign_verify, openssl_sha256
+};
+#endif
+
+const crypto_kernels *active_kernels = &liboqs_kernels;
+
+} // namespace
+
+crypto_kernel_preference parse_crypto_kernel_preference(const std::string &value) {
+    std::string lowered = value;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lowered.empty() || lowered == "auto") {
+        return crypto_kernel_preference::AUTO;
+    }
+    if (lowered == "portable") {
+        return crypto_kernel_preference::PORTABLE;
+    }
+    if (lowered == "avx2") {
+        return crypto_kernel_preference::AVX2;
+    }
+    std::cerr << "Unknown crypto kernel \"" << value << "\" (expected auto, portable or avx2)" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+const crypto_kernels &select_crypto_kernels(crypto_kernel_preference preference, const cpu_features &features) {
+    switch (preference) {
+        case crypto_kernel_preference::AVX2:
+#if defined(OQS_ENABLE_SIG_falcon_512_avx2)
+            if (!features.avx2) {
+                std::cerr << "AVX2 crypto kernels requested but this CPU does not support AVX2" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            active_kernels = &avx2_kernels;
+            break;
+#else
+            std::cerr << "AVX2 crypto kernels requested but liboqs was built without the Falcon AVX2 variant"
+                      << std::endl;
+            exit(EXIT_FAILURE);
+#endif
+        case crypto_kernel_preference::PORTABLE:
+#if defined(OQS_ENABLE_SIG_falcon_512)
+            active_kernels = &portable_kernels;
+            break;
+#else
+            std::cerr << "Portable crypto kernels requested but liboqs does not export the Falcon reference variant"
+                      << std::endl;
+            exit(EXIT_FAILURE);
+#endif
+        case crypto_kernel_preference::AUTO:
+        default:
+#if defined(OQS_ENABLE_SIG_falcon_512_avx2)
+            if (features.avx2) {
+                active_kernels = &avx2_kernels;
+                break;
+            }
+#endif
+#if defined(OQS_ENABLE_SIG_falcon_512)
+            active_kernels = &fallback_kernels;
+#else
+            active_kernels = &liboqs_kernels;
+#endif
+            break;
+    }
+
+    return *active_kernels;
+}
+
+const crypto_kernels &active_crypto_kernels() {
+    return *active_kernels;
+}
+
+void ecdsa_sign(unsigned char *hash, EC_KEY *signing_key, unsigned int* signature_buffer_length, unsigned char *signature) {
+
+    if(ECDSA_sign(0, hash, 32, signature, signature_buffer_length, signing_key) != 1) {
+        perror("Error in call to ECDSA_sign");
+        exit(EXIT_FAILURE);
+    }
+
+}
+
+int ecdsa_verify(unsigned char *hash, unsigned char *signature, const unsigned int* signature_buffer_length, EC_KEY *verification_key) {
+    int result = ECDSA_verify(0, hash,32, signature, (int)*signature_buffer_length, verification_key);
+    if(result == -1) {
+        perror("Fatal error: ECDSA_verify returned -1");
+        exit(EXIT_FAILURE);
+    }
+    else
+        return result;
+
+}
+
+void sha256sum(void* data, unsigned long length, unsigned char* md) {
+    perf_scope counters(perf_stage::hash);
+    active_kernels->sha256(data, length, md);
+}
+
 void falcon_sign(uint8_t *signature, size_t &signature_len, uint8_t *message, size_t message_len, uint8_t *private_key) {
 
-    if (OQS_SIG_falcon_512_sign(signature, &signature_len, message, message_len, private_key) != OQS_SUCCESS) {
+    if (active_kernels->falcon_sign(signature, &signature_len, message, message_len, private_key) != 0) {
         perror("Error in call to falcon_sign");
         exit(EXIT_FAILURE);
     }
@@ -55,8 +273,6 @@ void falcon_sign(uint8_t *signature, size_t &signature_len, uint8_t *message, si
 
 bool falcon_verify(uint8_t *message, size_t message_len, uint8_t *signature, size_t signature_len, uint8_t *public_key) {
 
-    OQS_STATUS result = OQS_SIG_falcon_512_verify(message, message_len, signature, signature_len, public_key);
-    return result == OQS_SUCCESS;
+    return active_kernels->falcon_verify(signature, signature_len, message, message_len, public_key) == 0;
 
 }
-
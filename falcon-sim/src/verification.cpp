@@ -0,0 +1,153 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include <openssl/pem.h>
+#include <openssl/sha.h>
+#include <oqs/oqs.h>
+
+#include "verification.h"
+
+namespace {
+uint8_t decode_hex_char(char c) {
+    if (c >= '0' && c <= '9') {
+        return static_cast<uint8_t>(c - '0');
+    }
+    if (c >= 'a' && c <= 'f') {
+        return static_cast<uint8_t>(c - 'a' + 10);
+    }
+    if (c >= 'A' && c <= 'F') {
+        return static_cast<uint8_t>(c - 'A' + 10);
+    }
+    throw std::runtime_error("Invalid hex character");
+}
+
+std::vector<uint8_t> hex_to_bytes(const std::string &hex) {
+    if (hex.size() % 2 != 0) {
+        throw std::runtime_error("Hex string length must be even");
+    }
+    std::vector<uint8_t> bytes;
+    bytes.reserve(hex.size() / 2);
+    for (std::size_t i = 0; i < hex.size(); i += 2) {
+        uint8_t msn = decode_hex_char(hex[i]);
+        uint8_t lsn = decode_hex_char(hex[i + 1]);
+        bytes.push_back(static_cast<uint8_t>((msn << 4) | lsn));
+    }
+    return bytes;
+}
+} // namespace
+
+ec_key_ptr load_ec_key(int number, bool certificate) {
+    std::string temp = certificate ? "cert_keys/" + std::to_string(number) + "/p256.key" :
+                                     "keys/" + std::to_string(number) + "/p256.key";
+
+    const char *filepath = temp.c_str();
+
+    FILE *fp = fopen(filepath, "r");
+    if (fp != nullptr) {
+        EVP_PKEY *key = nullptr;
+        PEM_read_PrivateKey(fp, &key, nullptr, nullptr);
+        if (!key) {
+            perror("Error while loading the key from file\n");
+            exit(EXIT_FAILURE);
+        }
+        ec_key_ptr ec_key(EVP_PKEY_get1_EC_KEY(key));
+        if (!ec_key) {
+            perror("Error while getting EC key from loaded key\n");
+            exit(EXIT_FAILURE);
+        }
+        EVP_PKEY_free(key);
+        fclose(fp);
+        return ec_key;
+    } else {
+        std::cout << filepath << std::endl;
+        std::cout << "Error while opening file from path. Error number : " << errno << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+std::vector<uint8_t> load_falcon_key(int number, bool private_key) {
+    const char *kind = private_key ? "private" : "public";
+    const std::size_t expected_length = private_key ? OQS_SIG_falcon_512_length_secret_key
+                                                    : OQS_SIG_falcon_512_length_public_key;
+
+    std::string path = "falcon_keys/" + std::to_string(number) + (private_key ? "/falcon.key" : "/falcon.pub");
+    std::ifstream key_file(path, std::ios::binary);
+    if (!key_file.is_open()) {
+        std::cerr << "Unable to open Falcon " << kind << " key: " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    std::string hex_key{std::istreambuf_iterator<char>(key_file), std::istreambuf_iterator<char>()};
+    try {
+        auto buffer = hex_to_bytes(hex_key);
+        if (buffer.size() != expected_length) {
+            std::cerr << "Unexpected Falcon " << kind << " key length: " << buffer.size()
+                      << " (expected " << expected_length << ")" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return buffer;
+    } catch (const std::exception &ex) {
+        std::cerr << "Failed to decode Falcon " << kind << " key: " << ex.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+EC_KEY *verification_key_cache::ecdsa_key(int number, verification_key_kind kind) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto &keys = kind == verification_key_kind::CERTIFICATE ? certificate_keys : message_keys;
+    auto it = keys.find(number);
+    if (it != keys.end()) {
+        return it->second.get();
+    }
+
+    return keys.emplace(number, load_ec_key(number, kind == verification_key_kind::CERTIFICATE)).first->second.get();
+}
+
+const std::vector<uint8_t> &verification_key_cache::falcon_public_key(int number) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = falcon_keys.find(number);
+    if (it != falcon_keys.end()) {
+        return it->second;
+    }
+    // unordered_map never relocates its nodes, so the reference stays valid after the lock is released
+    return falcon_keys.emplace(number, load_falcon_key(number, false)).first->second;
+}
+
+verification_key_cache &shared_verification_keys() {
+    static verification_key_cache keys;
+    return keys;
+}
+
+bool verify_signature(verification_key_cache &keys,
+                      signature_scheme scheme,
+                      verification_key_kind kind,
+                      int key_id,
+                      const uint8_t *message,
+                      std::size_t message_len,
+                      const uint8_t *signature,
+                      std::size_t signature_len) {
+    if (scheme == signature_scheme::FALCON && kind == verification_key_kind::MESSAGE) {
+        const auto &public_key = keys.falcon_public_key(key_id);
+        return falcon_verify(const_cast<uint8_t *>(message),
+                             message_len,
+                             const_cast<uint8_t *>(signature),
+                             signature_len,
+                             const_cast<uint8_t *>(public_key.data()));
+    }
+
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    sha256sum(const_cast<uint8_t *>(message), message_len, hash);
+    const auto length = static_cast<unsigned int>(signature_len);
+    return ecdsa_verify(hash,
+                        const_cast<uint8_t *>(signature),
+                        &length,
+                        keys.ecdsa_key(key_id, kind)) == 1;
+}
@@ -0,0 +1,489 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include "thread_affinity.h"
+#include "verify_offload.h"
+
+namespace {
+constexpr uint32_t OFFLOAD_MAGIC = 0x56584f46; // "VXOF"
+constexpr uint32_t OFFLOAD_VERSION = 1;
+constexpr std::size_t OFFLOAD_MAX_MESSAGE = 1024;
+constexpr std::size_t OFFLOAD_MAX_SIGNATURE = 1536;
+constexpr int SPIN_ITERATIONS = 2000;
+
+// Slot life cycle: FREE -> WRITING (client) -> SUBMITTED -> VERIFYING (service) -> DONE -> FREE (client).
+// A client that times out marks its slot ABANDONED and the service frees it once it is done with it.
+enum slot_state : uint32_t {
+    SLOT_FREE = 0,
+    SLOT_WRITING,
+    SLOT_SUBMITTED,
+    SLOT_VERIFYING,
+    SLOT_DONE,
+    SLOT_ABANDONED
+};
+
+struct offload_slot {
+    std::atomic<uint32_t> state;
+    uint8_t scheme;
+    uint8_t key_kind;
+    uint8_t key_id;
+    uint8_t result;
+    uint32_t message_len;
+    uint32_t signature_len;
+    uint8_t message[OFFLOAD_MAX_MESSAGE];
+    uint8_t signature[OFFLOAD_MAX_SIGNATURE];
+};
+
+// Cell of the bounded MPMC queue (D. Vyukov's design) that carries submitted slot indices to the verifier threads.
+struct queue_cell {
+    std::atomic<uint64_t> sequence;
+    uint32_t slot;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free to work across processes");
+
+void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+void futex_wait(std::atomic<uint32_t> *word, uint32_t expected, long timeout_ns) {
+    timespec timeout{timeout_ns / 1000000000L, timeout_ns % 1000000000L};
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t> *word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+std::size_t round_up_power_of_two(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+} // namespace
+
+struct verify_offload_region {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;                        // power of two
+    std::atomic<uint32_t> ready;
+    std::atomic<uint32_t> slot_hint;
+    std::atomic<uint32_t> work_signal;          // futex word bumped on every submission
+    std::atomic<uint32_t> sleeping_workers;
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) std::atomic<uint64_t> dequeue_pos;
+    alignas(64) std::atomic<uint64_t> submitted;
+    std::atomic<uint64_t> verified;
+    std::atomic<uint64_t> deduplicated;
+
+    static std::size_t bytes_for(std::size_t slot_count) {
+        return sizeof(verify_offload_region) + slot_count * (sizeof(queue_cell) + sizeof(offload_slot));
+    }
+
+    queue_cell *cells() {
+        return reinterpret_cast<queue_cell *>(this + 1);
+    }
+
+    offload_slot *slots() {
+        return reinterpret_cast<offload_slot *>(cells() + slot_count);
+    }
+
+    bool enqueue(uint32_t slot) {
+        const uint64_t mask = slot_count - 1;
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            queue_cell &cell = cells()[pos & mask];
+            const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.slot = slot;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool dequeue(uint32_t &slot) {
+        const uint64_t mask = slot_count - 1;
+        uint64_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            queue_cell &cell = cells()[pos & mask];
+            const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot = cell.slot;
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+verify_offload_client::verify_offload_client(const verify_offload_options &options) : timeout(options.timeout) {
+    int fd = shm_open(options.shm_name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        std::cerr << "Verification service is not running (cannot open shared memory "
+                  << options.shm_name << ": " << std::strerror(errno) << ")" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    struct stat info{};
+    if (fstat(fd, &info) < 0 || static_cast<std::size_t>(info.st_size) < sizeof(verify_offload_region)) {
+        std::cerr << "Verification service shared memory " << options.shm_name << " is not initialized" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    mapped_size = static_cast<std::size_t>(info.st_size);
+    void *mapping = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("mmap of verification service shared memory failed");
+        exit(EXIT_FAILURE);
+    }
+
+    region = static_cast<verify_offload_region *>(mapping);
+    if (region->magic != OFFLOAD_MAGIC || region->version != OFFLOAD_VERSION ||
+        region->ready.load(std::memory_order_acquire) == 0 ||
+        verify_offload_region::bytes_for(region->slot_count) > mapped_size) {
+        std::cerr << "Verification service shared memory " << options.shm_name
+                  << " has an unexpected layout" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+verify_offload_client::~verify_offload_client() {
+    if (region != nullptr) {
+        munmap(region, mapped_size);
+    }
+}
+
+bool verify_offload_client::verify(signature_scheme scheme,
+                                   verification_key_kind kind,
+                                   uint8_t key_id,
+                                   const uint8_t *message,
+                                   std::size_t message_len,
+                                   const uint8_t *signature,
+                                   std::size_t signature_len) {
+    auto verify_locally = [&]() {
+        fallbacks++;
+        return verify_signature(shared_verification_keys(), scheme, kind, key_id,
+                                message, message_len, signature, signature_len);
+    };
+
+    if (message_len > OFFLOAD_MAX_MESSAGE || signature_len > OFFLOAD_MAX_SIGNATURE) {
+        return verify_locally();
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const uint32_t slot_count = region->slot_count;
+    offload_slot *slot = nullptr;
+    uint32_t slot_index = 0;
+    while (slot == nullptr) {
+        const uint32_t start = region->slot_hint.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < slot_count; i++) {
+            const uint32_t candidate = (start + i) & (slot_count - 1);
+            uint32_t expected = SLOT_FREE;
+            if (region->slots()[candidate].state.compare_exchange_strong(expected, SLOT_WRITING,
+                                                                         std::memory_order_acquire)) {
+                slot = &region->slots()[candidate];
+                slot_index = candidate;
+                break;
+            }
+        }
+        if (slot == nullptr) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return verify_locally();
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    slot->scheme = static_cast<uint8_t>(scheme);
+    slot->key_kind = static_cast<uint8_t>(kind);
+    slot->key_id = key_id;
+    slot->result = 0;
+    slot->message_len = static_cast<uint32_t>(message_len);
+    slot->signature_len = static_cast<uint32_t>(signature_len);
+    std::memcpy(slot->message, message, message_len);
+    std::memcpy(slot->signature, signature, signature_len);
+    slot->state.store(SLOT_SUBMITTED, std::memory_order_release);
+
+    // the queue holds at most one entry per slot, so it cannot be full here
+    region->enqueue(slot_index);
+    region->submitted.fetch_add(1, std::memory_order_relaxed);
+    region->work_signal.fetch_add(1, std::memory_order_release);
+    if (region->sleeping_workers.load(std::memory_order_acquire) > 0) {
+        futex_wake(&region->work_signal, 1);
+    }
+
+    int spins = 0;
+    for (;;) {
+        uint32_t state = slot->state.load(std::memory_order_acquire);
+        if (state == SLOT_DONE) {
+            break;
+        }
+        if (spins < SPIN_ITERATIONS) {
+            spins++;
+            cpu_relax();
+            continue;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            if (slot->state.compare_exchange_strong(state, SLOT_ABANDONED, std::memory_order_acq_rel)) {
+                return verify_locally();
+            }
+            continue; // finished while we were giving up
+        }
+        futex_wait(&slot->state, state, 1000000);
+    }
+
+    const bool result = slot->result != 0;
+    slot->state.store(SLOT_FREE, std::memory_order_release);
+    return result;
+}
+
+namespace {
+struct digest_hash {
+    std::size_t operator()(const std::array<unsigned char, SHA256_DIGEST_LENGTH> &digest) const {
+        std::size_t value;
+        std::memcpy(&value, digest.data(), sizeof(value));
+        return value;
+    }
+};
+
+// Verdicts keyed by a digest of the whole request. Concurrent requests for the same SPDU share one in-flight
+// verification through the shared_future; the oldest entries are evicted once the cache is full.
+class verdict_cache {
+
+public:
+    explicit verdict_cache(std::size_t capacity) : capacity(capacity) {}
+
+    // Returns the (possibly still pending) verdict and whether the caller is responsible for fulfilling `promise`.
+    std::shared_future<bool> lookup(const std::array<unsigned char, SHA256_DIGEST_LENGTH> &key,
+                                    std::promise<bool> &promise,
+                                    bool &owner) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            owner = false;
+            return it->second;
+        }
+
+        owner = true;
+        auto verdict = promise.get_future().share();
+        entries.emplace(key, verdict);
+        order.push_back(key);
+        if (order.size() > capacity) {
+            entries.erase(order.front());
+            order.pop_front();
+        }
+        return verdict;
+    }
+
+private:
+    std::mutex mutex;
+    std::size_t capacity;
+    std::unordered_map<std::array<unsigned char, SHA256_DIGEST_LENGTH>, std::shared_future<bool>, digest_hash> entries;
+    std::deque<std::array<unsigned char, SHA256_DIGEST_LENGTH>> order;
+};
+
+void process_slot(verify_offload_region *region, uint32_t slot_index, verdict_cache &cache) {
+    offload_slot &slot = region->slots()[slot_index];
+    uint32_t expected = SLOT_SUBMITTED;
+    if (!slot.state.compare_exchange_strong(expected, SLOT_VERIFYING, std::memory_order_acquire)) {
+        // the client abandoned the request before we got to it
+        slot.state.store(SLOT_FREE, std::memory_order_release);
+        return;
+    }
+
+    // the lengths come from another process; read them once and never trust them past the slot's buffers
+    const std::size_t message_len = slot.message_len;
+    const std::size_t signature_len = slot.signature_len;
+    bool valid = false;
+    if (message_len <= OFFLOAD_MAX_MESSAGE && signature_len <= OFFLOAD_MAX_SIGNATURE) {
+        std::array<unsigned char, SHA256_DIGEST_LENGTH> key{};
+        EVP_MD_CTX *context = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(context, EVP_sha256(), nullptr);
+        EVP_DigestUpdate(context, &slot.scheme, 3); // scheme, key kind and key id
+        EVP_DigestUpdate(context, slot.message, message_len);
+        EVP_DigestUpdate(context, slot.signature, signature_len);
+        EVP_DigestFinal_ex(context, key.data(), nullptr);
+        EVP_MD_CTX_free(context);
+
+        std::promise<bool> promise;
+        bool owner = false;
+        auto verdict = cache.lookup(key, promise, owner);
+        if (owner) {
+            promise.set_value(verify_signature(shared_verification_keys(),
+                                               static_cast<signature_scheme>(slot.scheme),
+                                               static_cast<verification_key_kind>(slot.key_kind),
+                                               slot.key_id,
+                                               slot.message,
+                                               message_len,
+                                               slot.signature,
+                                               signature_len));
+            region->verified.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            region->deduplicated.fetch_add(1, std::memory_order_relaxed);
+        }
+        valid = verdict.get();
+    }
+
+    slot.result = valid ? 1 : 0;
+    expected = SLOT_VERIFYING;
+    if (slot.state.compare_exchange_strong(expected, SLOT_DONE, std::memory_order_release)) {
+        futex_wake(&slot.state, 1);
+    } else {
+        slot.state.store(SLOT_FREE, std::memory_order_release);
+    }
+}
+
+void verifier_worker(verify_offload_region *region, verdict_cache &cache, const std::atomic<bool> &stop) {
+    int idle_spins = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        uint32_t slot_index;
+        if (region->dequeue(slot_index)) {
+            idle_spins = 0;
+            process_slot(region, slot_index, cache);
+            continue;
+        }
+
+        if (idle_spins < SPIN_ITERATIONS) {
+            idle_spins++;
+            cpu_relax();
+            continue;
+        }
+
+        const uint32_t signal = region->work_signal.load(std::memory_order_acquire);
+        region->sleeping_workers.fetch_add(1, std::memory_order_acq_rel);
+        if (region->dequeue(slot_index)) {
+            region->sleeping_workers.fetch_sub(1, std::memory_order_acq_rel);
+            process_slot(region, slot_index, cache);
+            continue;
+        }
+        futex_wait(&region->work_signal, signal, 10000000);
+        region->sleeping_workers.fetch_sub(1, std::memory_order_acq_rel);
+        idle_spins = 0;
+    }
+}
+} // namespace
+
+void run_verifier_service(const verify_offload_options &options) {
+    const std::size_t slot_count = round_up_power_of_two(std::max<std::size_t>(options.slots, 2));
+    const std::size_t region_size = verify_offload_region::bytes_for(slot_count);
+    std::size_t thread_count = options.threads;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    shm_unlink(options.shm_name.c_str()); // stale segment from a service that did not shut down cleanly
+    int fd = shm_open(options.shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0) {
+        perror("shm_open for verification service failed");
+        exit(EXIT_FAILURE);
+    }
+    if (ftruncate(fd, static_cast<off_t>(region_size)) < 0) {
+        perror("ftruncate for verification service failed");
+        exit(EXIT_FAILURE);
+    }
+    void *mapping = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("mmap for verification service failed");
+        exit(EXIT_FAILURE);
+    }
+
+    auto *region = new (mapping) verify_offload_region();
+    region->magic = OFFLOAD_MAGIC;
+    region->version = OFFLOAD_VERSION;
+    region->slot_count = static_cast<uint32_t>(slot_count);
+    for (std::size_t i = 0; i < slot_count; i++) {
+        new (&region->cells()[i]) queue_cell();
+        region->cells()[i].sequence.store(i, std::memory_order_relaxed);
+        new (&region->slots()[i]) offload_slot();
+        region->slots()[i].state.store(SLOT_FREE, std::memory_order_relaxed);
+    }
+
+    // Handle shutdown signals synchronously on this thread; the workers inherit the blocked mask.
+    sigset_t shutdown_signals;
+    sigemptyset(&shutdown_signals);
+    sigaddset(&shutdown_signals, SIGINT);
+    sigaddset(&shutdown_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdown_signals, nullptr);
+
+    verdict_cache cache(std::max<std::size_t>(options.cache_entries, 1));
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back([region, &cache, &stop, &options, i]() {
+            pin_current_thread_round_robin(options.cpus, i);
+            verifier_worker(region, cache, stop);
+        });
+    }
+
+    region->ready.store(1, std::memory_order_release);
+    std::cout << "Verification service ready on " << options.shm_name
+              << " (slots=" << slot_count << ", threads=" << thread_count
+              << ", cpus=" << describe_cpu_list(options.cpus) << ")" << std::endl;
+
+    int received_signal = 0;
+    sigwait(&shutdown_signals, &received_signal);
+
+    stop.store(true);
+    region->ready.store(0, std::memory_order_release);
+    region->work_signal.fetch_add(1, std::memory_order_release);
+    futex_wake(&region->work_signal, INT_MAX);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    std::cout << "VERIFIER submitted=" << region->submitted.load()
+              << " verified=" << region->verified.load()
+              << " deduplicated=" << region->deduplicated.load()
+              << " threads=" << thread_count
+              << std::endl;
+
+    munmap(mapping, region_size);
+    shm_unlink(options.shm_name.c_str());
+}
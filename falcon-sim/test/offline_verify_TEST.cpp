@@ -0,0 +1,104 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+// verify-offline on damaged capture logs: every kind of damage is reported and counted, never read past.
+// Run from the repository root, where vehicle 0's keys are.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../ieee16092.h"
+#include "../offline_verify.h"
+#include "../spdu_capture.h"
+#include "../verification.h"
+
+namespace {
+
+std::string fresh_directory(const char *name) {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("offline_verify_test_" + std::to_string(getpid()) + "_" + name);
+    std::filesystem::remove_all(path);
+    return path.string();
+}
+
+// DER ECDSA signature (r = s = 1) that parses but never verifies.
+const uint8_t BOGUS_SIGNATURE[] = {0x30, 0x06, 0x02, 0x01, 0x01, 0x02, 0x01, 0x01};
+
+// Capture `count` ECDSA SPDUs from vehicle 0 signed with BOGUS_SIGNATURE and recorded as invalid, claiming the given
+// signature and certificate signature lengths.
+void write_capture(const std::string &directory, std::size_t count, std::size_t signature_bytes,
+                   uint16_t certificate_signature_bytes) {
+    capture_options options;
+    options.enabled = true;
+    options.directory = directory;
+    spdu_capture capture(options);
+
+    ieee1609dot2data_ecdsa_explicit data{};
+    std::copy(std::begin(BOGUS_SIGNATURE), std::end(BOGUS_SIGNATURE), data.certificate_signature);
+    std::vector<uint8_t> signature(std::max(signature_bytes, sizeof(BOGUS_SIGNATURE)));
+    std::copy(std::begin(BOGUS_SIGNATURE), std::end(BOGUS_SIGNATURE), signature.begin());
+    signature.resize(signature_bytes);
+    for (std::size_t i = 0; i < count; i++) {
+        capture_record record{};
+        record.sequence_number = static_cast<uint32_t>(i);
+        record.certificate_signature_bytes = certificate_signature_bytes;
+        record.signature_scheme = static_cast<uint8_t>(signature_scheme::ECDSA);
+        capture.append(record, &data, sizeof(data), signature.data(), signature.size());
+    }
+    capture.close();
+}
+
+uint64_t verify(const std::string &directory) {
+    offline_verify_options options;
+    options.directory = directory;
+    options.threads = 1;
+    return verify_offline(options);
+}
+
+} // namespace
+
+int main() {
+    // well-formed records that fail verification, as recorded: nothing to report
+    const std::string clean = fresh_directory("clean");
+    write_capture(clean, 2, sizeof(BOGUS_SIGNATURE), sizeof(BOGUS_SIGNATURE));
+    if (verify(clean) != 0)
+        return 1;
+
+    // certificate signature longer than the SPDU's 72-byte buffer
+    const std::string certificate = fresh_directory("certificate");
+    write_capture(certificate, 1, sizeof(BOGUS_SIGNATURE), 4000);
+    if (verify(certificate) != 1)
+        return 2;
+
+    // message signature longer than any ECDSA signature
+    const std::string signature = fresh_directory("signature");
+    write_capture(signature, 1, 700, sizeof(BOGUS_SIGNATURE));
+    if (verify(signature) != 1)
+        return 3;
+
+    // second record cut off and the index gone: one truncated record
+    const std::string truncated = fresh_directory("truncated");
+    write_capture(truncated, 2, sizeof(BOGUS_SIGNATURE), sizeof(BOGUS_SIGNATURE));
+    const std::string segment = capture_segment_path(truncated, 0);
+    std::filesystem::resize_file(segment, std::filesystem::file_size(segment) - 16);
+    std::filesystem::remove(capture_index_path(truncated, 0));
+    if (verify(truncated) != 1)
+        return 4;
+
+    // a segment that is not a capture segment next to a good one
+    const std::string foreign = fresh_directory("foreign");
+    write_capture(foreign, 1, sizeof(BOGUS_SIGNATURE), sizeof(BOGUS_SIGNATURE));
+    std::ofstream(capture_segment_path(foreign, 1), std::ios::binary) << std::string(128, 'x');
+    if (verify(foreign) != 1)
+        return 5;
+
+    for (const auto &directory : {clean, certificate, signature, truncated, foreign}) {
+        std::filesystem::remove_all(directory);
+    }
+    return 0;
+}
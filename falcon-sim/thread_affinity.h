@@ -0,0 +1,40 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_THREAD_AFFINITY_H
+#define CPP_THREAD_AFFINITY_H
+
+#include <pthread.h>
+
+#include <string>
+#include <vector>
+
+// CPU sets for each kind of thread. Empty means "leave it to the scheduler".
+struct thread_placement {
+    std::vector<int> receiver;
+    std::vector<int> transmitter;   // vehicle threads are spread round-robin over this set
+    std::vector<int> verifier;      // verifier service workers, round-robin
+    std::vector<int> hsm;           // HSM emulator engines, round-robin
+};
+
+// Parse a placement spec: "" / "none" (unpinned), a CPU list such as "0-3,6", "node:N" (the CPUs of NUMA node N)
+// or "isolated" (the kernel's isolcpus set). Exits on malformed specs.
+std::vector<int> parse_cpu_spec(const std::string &spec);
+
+// Defaults when nothing is configured: if the kernel isolated CPUs (isolcpus=), give the receiver the first one,
+// the transmitters the second and the verifier workers the rest; otherwise pin nothing.
+thread_placement default_thread_placement();
+
+std::string describe_cpu_list(const std::vector<int> &cpus);
+
+// `cpus` without any of `excluded`, order kept.
+std::vector<int> cpus_excluding(const std::vector<int> &cpus, const std::vector<int> &excluded);
+
+// Pin `thread` to `cpus` (no-op when empty). Exits if the kernel rejects the set.
+void pin_thread(pthread_t thread, const std::vector<int> &cpus);
+// Pin the calling thread to the `index`-th CPU of `cpus`, wrapping around (no-op when empty).
+void pin_current_thread_round_robin(const std::vector<int> &cpus, std::size_t index);
+// CPUs the calling thread may currently run on, as recorded in the METRIC/SIGNING output.
+std::vector<int> current_thread_cpus();
+
+#endif //CPP_THREAD_AFFINITY_H
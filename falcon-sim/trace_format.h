@@ -0,0 +1,36 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_TRACE_FORMAT_H
+#define CPP_TRACE_FORMAT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary trace: a 16-byte header (the magic, the number of fields per row, the row interval in ms) followed by
+// rows of TRACE_ROW_FIELDS native-endian floats, the same columns as a CSV trace. The row count is implied by the
+// file size, so a trace can be appended to without rewriting the header.
+constexpr char BINARY_TRACE_MAGIC[8] = {'V', '2', 'X', 'T', 'R', 'C', '0', '1'};
+constexpr uint32_t TRACE_ROW_FIELDS = 5;
+constexpr std::size_t BINARY_TRACE_HEADER_BYTES = 16;
+
+struct trace_row {
+    float x;
+    float y;
+    float z;
+    float speed_kph;
+    float heading;      // degrees, atan2(dy, dx) as in calculate_heading
+};
+static_assert(sizeof(trace_row) == TRACE_ROW_FIELDS * sizeof(float), "trace_row must be packed floats");
+
+// Write `rows` to `path`, creating (or truncating) the file with a header when `create` is set and appending
+// otherwise. Exits on I/O errors.
+void write_binary_trace(const std::string &path, const std::vector<trace_row> &rows, bool create);
+
+// Open a binary trace and position it at the first row. Returns nullptr if `path` does not exist; exits if it
+// exists but is not a binary trace.
+FILE *open_binary_trace(const std::string &path);
+
+#endif //CPP_TRACE_FORMAT_H
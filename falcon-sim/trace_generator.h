@@ -0,0 +1,53 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_TRACE_GENERATOR_H
+#define CPP_TRACE_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Rows are written one per TRACE_TICK_MS, the interval generate_bsm assumes when it derives speed from two rows.
+constexpr double TRACE_TICK_MS = 100;
+
+enum class trace_model {
+    GRID,       // random walk on a square grid of roads
+    POLYLINE    // back and forth along polylines read from a file
+};
+
+struct trace_point {
+    double x;
+    double y;
+    double z;
+};
+
+struct trace_options {
+    trace_model model = trace_model::GRID;
+    std::string polyline_file;          // POLYLINE: "x,y[,z]" per line (metres), a blank line starts a new polyline
+    int vehicles = 0;
+    int steps = 0;                      // rows per vehicle
+    uint64_t seed = 1;                  // traces depend only on the seed and the vehicle number, not on threads
+    int grid_blocks = 20;               // GRID: blocks per side
+    double grid_spacing_m = 100;        // GRID: block length
+    double max_speed_mps = 13.9;        // cruise speeds are drawn from 70-100% of this
+    double accel_mps2 = 2.0;
+    double decel_mps2 = 3.0;
+    double stop_probability = 0.3;      // GRID: chance of stopping at an intersection
+    double max_stop_s = 20;             // stops last 1 s to this long
+    unsigned threads = 0;               // 0 = one per online CPU (capped at the number of vehicles)
+    std::string directory = "trace_files";
+};
+
+// "grid" or "polyline"; exits on anything else.
+trace_model parse_trace_model(const std::string &name);
+const char *trace_model_name(trace_model model);
+
+// Read polylines for the POLYLINE model. Exits if the file cannot be read or holds no polyline of two or more points.
+std::vector<std::vector<trace_point>> load_polylines(const std::string &path);
+
+// Write <directory>/<n>.csv for n in [0, vehicles) as "x,y,z,speed_kph,heading" rows, spreading the vehicles over
+// a pool of threads, then print a TRACES summary line. Exits on I/O errors.
+void generate_traces(const trace_options &options);
+
+#endif //CPP_TRACE_GENERATOR_H
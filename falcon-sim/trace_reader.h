@@ -0,0 +1,71 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_TRACE_READER_H
+#define CPP_TRACE_READER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "trace_format.h"
+
+// Plays a trace back without holding it in memory: rows are read in windows of `window_rows`, and while the vehicle
+// works through one window a shared background I/O thread fills the other. Memory per vehicle is two windows,
+// whatever the length of the trace.
+class trace_reader {
+public:
+    // Open <directory>/<number>.bin, or <number>.csv if there is no binary trace, and read the first window.
+    // Exits if neither file can be read or the trace is empty.
+    trace_reader(const std::string &directory, int number, std::size_t window_rows);
+    ~trace_reader();
+
+    trace_reader(const trace_reader &) = delete;
+    trace_reader &operator=(const trace_reader &) = delete;
+
+    // Row `index` of the trace. Indexes must not decrease by more than one between calls (the previous row is
+    // kept for speed and heading). Past the end of the trace the last row repeats: the vehicle stays where it
+    // stopped.
+    const trace_row &row(std::size_t index);
+
+    // Times row() had to wait for the I/O thread because the read-ahead had not finished.
+    std::size_t stalls() const { return stall_count; }
+
+private:
+    struct window {
+        std::vector<trace_row> rows;
+        bool ready = false;     // filled and not yet consumed; guarded by mutex
+        bool last = false;      // the trace ends in this window
+    };
+
+    void fill(window &target);              // read the next rows from the file into `target`
+    void request_fill(window &target);      // fill `target` on the I/O thread
+    bool read_csv_row(trace_row &out);
+
+    std::string path;
+    FILE *file = nullptr;
+    bool binary = false;
+    std::size_t window_rows;
+    char *line = nullptr;                   // CSV read buffer (getline)
+    std::size_t line_capacity = 0;
+
+    window windows[2];
+    window *front = &windows[0];
+    window *back = &windows[1];
+    std::size_t front_position = 0;
+
+    std::size_t current_index = 0;
+    trace_row current{};
+    trace_row previous{};
+
+    std::mutex mutex;
+    std::condition_variable filled;
+    bool fill_in_flight = false;
+    std::size_t stall_count = 0;
+
+    friend class trace_prefetcher;
+};
+
+#endif //CPP_TRACE_READER_H
@@ -4,6 +4,40 @@
 #ifndef CPP_V2VCRYPTO_H
 #define CPP_V2VCRYPTO_H
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <openssl/ec.h>
+
+#include "cpu_features.h"
+
+enum class signature_scheme {
+    ECDSA = 0,
+    FALCON = 1
+};
+
+enum class crypto_kernel_preference {
+    AUTO = 0,
+    PORTABLE = 1,
+    AVX2 = 2
+};
+
+// Function-pointer table for the Falcon and SHA-256 kernels. Selected once at startup (before any worker threads
+// are started) and read-only afterwards, so the hot path only pays for an indirect call.
+struct crypto_kernels {
+    const char *falcon_name;
+    const char *hash_name;
+    int (*falcon_sign)(uint8_t *signature, size_t *signature_len, const uint8_t *message, size_t message_len,
+                       const uint8_t *private_key);
+    int (*falcon_verify)(const uint8_t *signature, size_t signature_len, const uint8_t *message, size_t message_len,
+                         const uint8_t *public_key);
+    void (*sha256)(const void *data, unsigned long length, unsigned char *md);
+};
+
+crypto_kernel_preference parse_crypto_kernel_preference(const std::string &value);
+const crypto_kernels &select_crypto_kernels(crypto_kernel_preference preference, const cpu_features &features);
+const crypto_kernels &active_crypto_kernels();
+
 void sha256sum(void* data, unsigned long length, unsigned char* md);
 void ecdsa_sign(unsigned char *hash, EC_KEY *signing_key, unsigned int* signature_buffer_length, unsigned char *signature);
 int ecdsa_verify(unsigned char *hash, unsigned char *signature, const unsigned int* signature_buffer_length, EC_KEY *verification_key);
@@ -0,0 +1,64 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_VERIFICATION_H
+#define CPP_VERIFICATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <openssl/ec.h>
+
+#include "v2vcrypto.h"
+
+// Which of a vehicle's keys a signature was made with: the message signing key (keys/) or the certificate issuing
+// key (cert_keys/).
+enum class verification_key_kind : uint8_t {
+    MESSAGE = 0,
+    CERTIFICATE = 1
+};
+
+struct ec_key_deleter {
+    void operator()(EC_KEY *key) const { EC_KEY_free(key); }
+};
+using ec_key_ptr = std::unique_ptr<EC_KEY, ec_key_deleter>;
+
+ec_key_ptr load_ec_key(int number, bool certificate);
+std::vector<uint8_t> load_falcon_key(int number, bool private_key);
+
+// Verification keys are loaded from disk on first use and kept for the lifetime of the process. Safe to share
+// between verifier threads.
+class verification_key_cache {
+
+public:
+    verification_key_cache() = default;
+    verification_key_cache(const verification_key_cache &) = delete;
+    verification_key_cache &operator=(const verification_key_cache &) = delete;
+
+    EC_KEY *ecdsa_key(int number, verification_key_kind kind);
+    const std::vector<uint8_t> &falcon_public_key(int number);
+
+private:
+    std::mutex mutex;
+    std::unordered_map<int, ec_key_ptr> message_keys;
+    std::unordered_map<int, ec_key_ptr> certificate_keys;
+    std::unordered_map<int, std::vector<uint8_t>> falcon_keys;
+};
+
+verification_key_cache &shared_verification_keys();
+
+// Verify `signature` over `message` with the given vehicle's key. ECDSA signatures are checked against the SHA-256
+// of the message, Falcon signatures against the message itself.
+bool verify_signature(verification_key_cache &keys,
+                      signature_scheme scheme,
+                      verification_key_kind kind,
+                      int key_id,
+                      const uint8_t *message,
+                      std::size_t message_len,
+                      const uint8_t *signature,
+                      std::size_t signature_len);
+
+#endif //CPP_VERIFICATION_H
@@ -0,0 +1,57 @@
+// Copyright (c) 2022. Geoff Twardokus
+// Reuse permitted under the MIT License as specified in the LICENSE file within this project.
+
+#ifndef CPP_VERIFY_OFFLOAD_H
+#define CPP_VERIFY_OFFLOAD_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "verification.h"
+
+struct verify_offload_options {
+    bool enabled = false;                      // receiver: submit verifications to the local verifier service
+    std::string shm_name = "/v2x_verifier";    // POSIX shared memory object shared by the service and receivers
+    std::size_t slots = 256;                   // service: request ring capacity
+    std::size_t threads = 0;                   // service: verifier threads, 0 = one per core
+    std::size_t cache_entries = 4096;          // service: remembered verdicts for deduplication
+    std::chrono::milliseconds timeout{2000};   // receiver: give up and verify locally after this long
+    std::vector<int> cpus;                     // service: CPUs for the worker threads, empty = unpinned
+};
+
+struct verify_offload_region;
+
+// Receiver-side handle on the verifier service's request ring. One client may be used from several threads.
+class verify_offload_client {
+
+public:
+    explicit verify_offload_client(const verify_offload_options &options);
+    verify_offload_client(const verify_offload_client &) = delete;
+    verify_offload_client &operator=(const verify_offload_client &) = delete;
+    ~verify_offload_client();
+
+    bool verify(signature_scheme scheme,
+                verification_key_kind kind,
+                uint8_t key_id,
+                const uint8_t *message,
+                std::size_t message_len,
+                const uint8_t *signature,
+                std::size_t signature_len);
+
+    uint64_t local_fallbacks() const { return fallbacks.load(); }
+
+private:
+    verify_offload_region *region = nullptr;
+    std::size_t mapped_size = 0;
+    std::chrono::milliseconds timeout;
+    std::atomic<uint64_t> fallbacks{0};
+};
+
+// Create the shared-memory request ring and serve verification requests until SIGINT/SIGTERM.
+void run_verifier_service(const verify_offload_options &options);
+
+#endif //CPP_VERIFY_OFFLOAD_H
@@ -0,0 +1,169 @@
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include "BinaryLog.h"
+
+namespace Logger {
+
+    namespace {
+        struct Site {
+            Level level;
+            std::string format;
+            std::string file;
+            int line;
+        };
+
+        constexpr std::size_t PENDING_FLUSH_BYTES = 64 * 1024;
+
+        std::mutex site_mtx;
+        std::vector<Site> sites;
+
+        std::unique_ptr<BinaryLog> shared_binary_log;
+
+        template<typename T>
+        void appendValue(std::vector<uint8_t> &out, T value) {
+            const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+
+        void appendString(std::vector<uint8_t> &out, std::string_view value) {
+            const auto length = static_cast<uint16_t>(std::min<std::size_t>(value.size(), UINT16_MAX));
+            appendValue(out, length);
+            out.insert(out.end(), value.begin(), value.begin() + length);
+        }
+
+        void appendSiteRecord(std::vector<uint8_t> &out, uint32_t id, const Site &site) {
+            out.push_back(BinaryLog::SiteRecord);
+            appendValue(out, id);
+            out.push_back(static_cast<uint8_t>(site.level));
+            appendValue(out, static_cast<uint32_t>(site.line));
+            appendString(out, site.file);
+            appendString(out, site.format);
+        }
+    }
+
+    void startBinaryLog(const std::string_view filepath, const std::size_t maxFileBytes, const std::size_t maxFiles) {
+        shared_binary_log = std::make_unique<BinaryLog>(filepath, maxFileBytes, maxFiles);
+    }
+
+    void stopBinaryLog() {
+        shared_binary_log.reset();
+    }
+
+    void flushBinaryLog() {
+        if(shared_binary_log) {
+            shared_binary_log->flush();
+        }
+    }
+
+    BinaryLog::BinaryLog(const std::string_view filepath, const std::size_t maxFileBytes, const std::size_t maxFiles)
+            : path{filepath}, maxFileBytes{maxFileBytes}, maxFiles{std::max<std::size_t>(maxFiles, 1)} {
+        pending.reserve(PENDING_FLUSH_BYTES);
+        openFile();
+    }
+
+    BinaryLog::~BinaryLog() {
+        flush();
+        file.close();
+    }
+
+    uint32_t BinaryLog::registerSite(const Level level, const char *format, const char *file, const int line) {
+        std::vector<uint8_t> record;
+        uint32_t id;
+        {
+            std::lock_guard<std::mutex> guard(site_mtx);
+            id = static_cast<uint32_t>(sites.size());
+            sites.push_back(Site{level, format, file, line});
+            appendSiteRecord(record, id, sites.back());
+        }
+        // taken without site_mtx held: openFile() locks the two in the opposite order
+        if(shared_binary_log) {
+            shared_binary_log->append(record.data(), record.size());
+        }
+        return id;
+    }
+
+    void BinaryLog::append(const uint8_t *record, const std::size_t length) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if(fileBytes + pending.size() + length > maxFileBytes && fileBytes + pending.size() > headerBytes) {
+            writePending();
+            rotate();
+        }
+        pending.insert(pending.end(), record, record + length);
+        if(pending.size() >= PENDING_FLUSH_BYTES) {
+            writePending();
+        }
+    }
+
+    void BinaryLog::flush() {
+        std::lock_guard<std::mutex> guard(mutex);
+        writePending();
+        file.flush();
+    }
+
+    void BinaryLog::writePending() {
+        if(pending.empty()) {
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(pending.data()), static_cast<std::streamsize>(pending.size()));
+        fileBytes += pending.size();
+        pending.clear();
+    }
+
+    void BinaryLog::rotate() {
+        file.close();
+        // vehicleLog.bin -> vehicleLog.bin.1 -> ... -> vehicleLog.bin.<maxFiles - 1>, the oldest is overwritten
+        for(std::size_t i = maxFiles - 1; i >= 1; i--) {
+            const std::string from = i == 1 ? path : path + "." + std::to_string(i - 1);
+            std::rename(from.c_str(), (path + "." + std::to_string(i)).c_str());
+        }
+        openFile();
+    }
+
+    void BinaryLog::openFile() {
+        file.open(path, std::ios::binary | std::ios::trunc);
+
+        std::vector<uint8_t> header(MAGIC, MAGIC + sizeof(MAGIC));
+        {
+            std::lock_guard<std::mutex> guard(site_mtx);
+            for(std::size_t id = 0; id < sites.size(); id++) {
+                appendSiteRecord(header, static_cast<uint32_t>(id), sites[id]);
+            }
+        }
+        file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+        fileBytes = headerBytes = header.size();
+    }
+
+    BinaryLog::EventBuilder::EventBuilder(const uint32_t site) {
+        const auto timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        put(EventRecord);
+        putValue(site);
+        putValue(timestamp);
+        put(0); // argument count, filled in by commit()
+    }
+
+    void BinaryLog::EventBuilder::addString(const std::string_view value) {
+        put(StringArgument);
+        const std::size_t room = buffer.size() - std::min(buffer.size(), length + sizeof(uint16_t));
+        const auto stored = static_cast<uint16_t>(std::min(value.size(), room));
+        putValue(stored);
+        if(!overflow) {
+            std::memcpy(buffer.data() + length, value.data(), stored);
+            length += stored;
+        }
+    }
+
+    void BinaryLog::EventBuilder::commit() {
+        constexpr std::size_t argumentCountOffset = 1 + sizeof(uint32_t) + sizeof(uint64_t);
+        buffer[argumentCountOffset] = arguments;
+        if(shared_binary_log) {
+            shared_binary_log->append(buffer.data(), length);
+        }
+    }
+
+}
@@ -0,0 +1,167 @@
+//
+// Binary log with deferred formatting.
+//
+// Call sites record a format string once and then only the raw argument values; nothing is formatted in the
+// process. binlog_decode turns a log file back into text. Levels above LOGGER_COMPILE_LEVEL are discarded at
+// compile time: the arguments are not even evaluated.
+//
+//     BINLOG_WARNING("Failed to update {} (invalid value: {})", "latitude", latitude);
+//
+
+#ifndef V2VERIFIER_BINARYLOG_H
+#define V2VERIFIER_BINARYLOG_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Log.h"
+
+// Highest level that is compiled in (Fatal = 0, Error = 1, Warning = 2, Info = 3).
+#ifndef LOGGER_COMPILE_LEVEL
+#define LOGGER_COMPILE_LEVEL 3
+#endif
+
+#define BINLOG(level, format, ...)                                                                      \
+    do {                                                                                                \
+        if constexpr (static_cast<int>(level) <= LOGGER_COMPILE_LEVEL) {                                \
+            static const uint32_t binlog_site = Logger::BinaryLog::registerSite(level, format,          \
+                                                                                 __FILE__, __LINE__);   \
+            Logger::BinaryLog::write(level, binlog_site, ##__VA_ARGS__);                               \
+        }                                                                                               \
+    } while(0)
+
+#define BINLOG_FATAL(format, ...) BINLOG(Logger::Fatal, format, ##__VA_ARGS__)
+#define BINLOG_ERROR(format, ...) BINLOG(Logger::Error, format, ##__VA_ARGS__)
+#define BINLOG_WARNING(format, ...) BINLOG(Logger::Warning, format, ##__VA_ARGS__)
+#define BINLOG_INFO(format, ...) BINLOG(Logger::Info, format, ##__VA_ARGS__)
+
+namespace Logger {
+
+    void startBinaryLog(std::string_view filepath,
+                        std::size_t maxFileBytes = 16 * 1024 * 1024,
+                        std::size_t maxFiles = 4);
+    void stopBinaryLog();
+    void flushBinaryLog();
+
+    // File layout: the 8-byte magic "V2XBLOG1", then records. A site record (type 1) maps a site id to its level,
+    // source location and format string; every file starts with all sites known so far, so rotated files decode
+    // on their own. An event record (type 2) carries a site id, a timestamp and the tagged argument values.
+    class BinaryLog {
+    public:
+        static constexpr char MAGIC[8] = {'V', '2', 'X', 'B', 'L', 'O', 'G', '1'};
+        static constexpr std::size_t MAX_EVENT_BYTES = 512;
+
+        enum RecordType : uint8_t {
+            SiteRecord = 1,
+            EventRecord = 2
+        };
+
+        enum ArgumentType : uint8_t {
+            SignedArgument = 1,
+            UnsignedArgument = 2,
+            DoubleArgument = 3,
+            StringArgument = 4,
+            BoolArgument = 5
+        };
+
+        BinaryLog(std::string_view filepath, std::size_t maxFileBytes, std::size_t maxFiles);
+        BinaryLog(const BinaryLog &) = delete;
+        BinaryLog &operator=(const BinaryLog &) = delete;
+        ~BinaryLog();
+
+        void append(const uint8_t *record, std::size_t length);
+        void flush();
+
+        static uint32_t registerSite(Level level, const char *format, const char *file, int line);
+
+        template<typename... Args>
+        static void write(Level level, uint32_t site, const Args &... args) {
+            EventBuilder event(site);
+            (event.add(args), ...);
+            event.commit();
+            if (level == Fatal) {
+                flushBinaryLog();
+            }
+        }
+
+    private:
+        class EventBuilder {
+        public:
+            explicit EventBuilder(uint32_t site);
+
+            template<typename T>
+            void add(const T &value) {
+                const std::size_t start = length;
+                if constexpr (std::is_same_v<T, bool>) {
+                    put(BoolArgument);
+                    put(static_cast<uint8_t>(value ? 1 : 0));
+                } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                    put(SignedArgument);
+                    putValue(static_cast<int64_t>(value));
+                } else if constexpr (std::is_integral_v<T>) {
+                    put(UnsignedArgument);
+                    putValue(static_cast<uint64_t>(value));
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    put(DoubleArgument);
+                    putValue(static_cast<double>(value));
+                } else if constexpr (std::is_enum_v<T>) {
+                    put(SignedArgument);
+                    putValue(static_cast<int64_t>(value));
+                } else {
+                    addString(std::string_view(value));
+                }
+                if (overflow) {
+                    length = start;     // drop the argument that did not fit and everything after it
+                } else {
+                    arguments++;
+                }
+            }
+
+            void commit();
+
+        private:
+            void put(uint8_t byte) {
+                putValue(byte);
+            }
+            template<typename T>
+            void putValue(T value) {
+                if (length + sizeof(T) > buffer.size()) {
+                    overflow = true;
+                    return;
+                }
+                std::memcpy(buffer.data() + length, &value, sizeof(T));
+                length += sizeof(T);
+            }
+            void addString(std::string_view value);
+
+            std::array<uint8_t, MAX_EVENT_BYTES> buffer;
+            std::size_t length = 0;
+            bool overflow = false;
+            uint8_t arguments = 0;
+        };
+
+        void openFile();
+        void rotate();
+        void writePending();
+
+        std::string path;
+        std::size_t maxFileBytes;
+        std::size_t maxFiles;
+        std::ofstream file;
+        std::size_t fileBytes = 0;
+        std::size_t headerBytes = 0;       // magic and site table at the start of the current file
+        std::vector<uint8_t> pending;      // records not yet handed to the file
+        std::mutex mutex;
+    };
+
+};
+
+#endif //V2VERIFIER_BINARYLOG_H
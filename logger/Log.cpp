@@ -1,52 +1,231 @@
 
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
 #include "Log.h"
 
 namespace Logger {
 
     static std::unique_ptr<Log> shared_log;
 
-    std::mutex log_mtx;
+    static std::atomic<uint64_t> next_log_id{1};
 
     void startLog(const std::string_view filepath) {
         shared_log = std::make_unique<Log>(filepath);
         Logger::log(Level::Info, "Initialized log");
     }
 
+    void stopLog() {
+        shared_log.reset();
+    }
+
     void log(Level l, const std::string_view message) {
-        shared_log->addLog(l, message);
+        if(shared_log) {
+            shared_log->addLog(l, message);
+        }
     }
 
     void logFatal(std::string_view message) {
-        shared_log->addLog(Logger::Fatal, message);
+        log(Logger::Fatal, message);
     }
 
     void logError(std::string_view message) {
-        shared_log->addLog(Logger::Error, message);
+        log(Logger::Error, message);
     }
 
     void logWarning(std::string_view message) {
-        shared_log->addLog(Logger::Warning, message);
+        log(Logger::Warning, message);
     }
 
     void logInfo(std::string_view message) {
-        shared_log->addLog(Logger::Info, message);
+        log(Logger::Info, message);
+    }
+
+    void flush() {
+        if(shared_log) {
+            shared_log->flush();
+        }
+    }
+
+    Stats stats() {
+        return shared_log ? shared_log->stats() : Stats{};
+    }
+
+    Log::Log(const std::string_view filepath) : id{next_log_id++}, logfile{} {
+        logfile.open(std::string(filepath));
+        writer = std::thread(&Log::writerLoop, this);
     }
 
-    Log::Log(const std::string_view filepath) : logfile{} {
-        logfile.open(filepath);
+    Log::ThreadRing &Log::ringForThisThread() {
+        // Each thread registers its own ring the first time it logs to this Log; when the thread exits the ring is
+        // marked retired and the writer frees it once it has been drained.
+        struct Handle {
+            uint64_t owner = 0;
+            std::shared_ptr<ThreadRing> ring;
+
+            ~Handle() {
+                if(ring) {
+                    ring->retired.store(true, std::memory_order_release);
+                }
+            }
+        };
+        thread_local Handle handle;
+
+        if(handle.owner != id || !handle.ring) {
+            if(handle.ring) {
+                handle.ring->retired.store(true, std::memory_order_release);
+            }
+            handle.ring = std::make_shared<ThreadRing>();
+            handle.owner = id;
+            std::lock_guard<std::mutex> guard(ringsMutex);
+            rings.push_back(handle.ring);
+        }
+        return *handle.ring;
     }
 
     void Log::addLog(Logger::Level l, const std::string_view message) {
-//        std::lock_guard<std::mutex> guard(log_mtx);
-        if(logfile.is_open()) {
-            logfile << levels[static_cast<int>(l)] << ": " << message << std::endl;
+        if(!logfile.is_open()) {
+            return;
+        }
+
+        if(l == Fatal) {
+            // the process may be about to die: get everything before this entry out, then write it directly
+            flush();
+            std::string line;
+            appendEntry(line, l, message);
+            writeBatch(line);
+            written.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ThreadRing &ring = ringForThisThread();
+        const std::size_t head = ring.head.load(std::memory_order_relaxed);
+        if(head - ring.tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            droppedTotal.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Entry &entry = ring.entries[head & (RING_CAPACITY - 1)];
+        const std::size_t length = std::min(message.size(), MAX_MESSAGE_LENGTH);
+        if(length < message.size()) {
+            truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        entry.level = l;
+        entry.length = static_cast<uint16_t>(length);
+        std::memcpy(entry.text.data(), message.data(), length);
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Log::flush() {
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if(stopping) {
+            return;
+        }
+        const uint64_t target = ++flushRequested;
+        wake.notify_all();
+        flushed.wait(lock, [this, target]() { return flushCompleted >= target; });
+    }
+
+    Stats Log::stats() const {
+        Stats current;
+        current.written = written.load(std::memory_order_relaxed);
+        current.dropped = droppedTotal.load(std::memory_order_relaxed);
+        current.truncated = truncated.load(std::memory_order_relaxed);
+        return current;
+    }
+
+    void Log::appendEntry(std::string &batch, Logger::Level l, const std::string_view message) {
+        batch += levels[static_cast<int>(l)];
+        batch += ": ";
+        batch.append(message.data(), message.size());
+        batch += '\n';
+    }
+
+    std::size_t Log::drainInto(std::string &batch) {
+        std::vector<std::shared_ptr<ThreadRing>> snapshot;
+        {
+            std::lock_guard<std::mutex> guard(ringsMutex);
+            snapshot = rings;
+        }
+
+        std::size_t drained = 0;
+        for(auto &ring : snapshot) {
+            const bool retired = ring->retired.load(std::memory_order_acquire);
+            const std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+            const std::size_t head = ring->head.load(std::memory_order_acquire);
+            for(std::size_t i = tail; i != head; i++) {
+                const Entry &entry = ring->entries[i & (RING_CAPACITY - 1)];
+                appendEntry(batch, entry.level, std::string_view(entry.text.data(), entry.length));
+            }
+            ring->tail.store(head, std::memory_order_release);
+            drained += head - tail;
+
+            const uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+            if(dropped != ring->droppedReported) {
+                appendEntry(batch, Warning, std::to_string(dropped - ring->droppedReported) +
+                                            " log entries dropped (thread log buffer full)");
+                ring->droppedReported = dropped;
+            }
+
+            if(retired) {
+                std::lock_guard<std::mutex> guard(ringsMutex);
+                rings.erase(std::remove(rings.begin(), rings.end(), ring), rings.end());
+            }
+        }
+        return drained;
+    }
+
+    void Log::writeBatch(const std::string &batch) {
+        std::lock_guard<std::mutex> guard(fileMutex);
+        logfile.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        logfile.flush();
+    }
+
+    void Log::writerLoop() {
+        std::string batch;
+        for(;;) {
+            uint64_t flushTarget;
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait_for(lock, std::chrono::milliseconds(5), [this]() {
+                    return stopping || flushRequested > flushCompleted;
+                });
+                flushTarget = flushRequested;
+                stop = stopping;
+            }
+
+            batch.clear();
+            const std::size_t drained = drainInto(batch);
+            if(!batch.empty()) {
+                writeBatch(batch);
+                written.fetch_add(drained, std::memory_order_relaxed);
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(wakeMutex);
+                flushCompleted = flushTarget;
+            }
+            flushed.notify_all();
+
+            if(stop) {
+                return;
+            }
         }
     }
 
     Log::~Log() {
         addLog(Level::Info, "Stopped logging.");
+        {
+            std::lock_guard<std::mutex> guard(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        writer.join();
         logfile.close();
     }
 
-}
\ No newline at end of file
+}
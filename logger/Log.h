@@ -5,9 +5,18 @@
 #ifndef V2VERIFIER_LOG_H
 #define V2VERIFIER_LOG_H
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 namespace Logger {
 
@@ -18,27 +27,86 @@ namespace Logger {
         Info
     };
 
+    struct Stats {
+        uint64_t written = 0;      // entries written to the file
+        uint64_t dropped = 0;      // entries lost because a thread's ring was full
+        uint64_t truncated = 0;    // entries cut to MAX_MESSAGE_LENGTH
+    };
+
     void startLog(std::string_view filepath);
+    void stopLog();
     void log(Level l, std::string_view message);
     void logFatal(std::string_view message);
     void logError(std::string_view message);
     void logWarning(std::string_view message);
     void logInfo(std::string_view message);
+    void flush();
+    Stats stats();
 
+    // Entries are copied into a fixed-size ring owned by the calling thread (single producer, single consumer) and
+    // written out in batches by a background thread, so logging never blocks on the file. When a ring is full the
+    // entry is dropped and counted; fatal entries bypass the rings and are written and flushed synchronously.
     class Log {
     public:
-        Log(std::string_view filepath);
+        static constexpr std::size_t RING_CAPACITY = 256;       // entries per thread, power of two
+        static constexpr std::size_t MAX_MESSAGE_LENGTH = 240;  // longer messages are truncated
+
+        explicit Log(std::string_view filepath);
+        Log(const Log &) = delete;
+        Log &operator=(const Log &) = delete;
 
         void addLog(Level l, std::string_view message);
 
+        // Block until everything logged so far by any thread is in the file.
+        void flush();
+
+        Stats stats() const;
+
         ~Log();
 
     private:
+        struct Entry {
+            Level level;
+            uint16_t length;
+            std::array<char, MAX_MESSAGE_LENGTH> text;
+        };
+
+        struct ThreadRing {
+            std::array<Entry, RING_CAPACITY> entries;
+            alignas(64) std::atomic<std::size_t> head{0};     // next slot the producer writes
+            alignas(64) std::atomic<std::size_t> tail{0};     // next slot the writer reads
+            std::atomic<uint64_t> dropped{0};
+            uint64_t droppedReported = 0;                     // writer thread only
+            std::atomic<bool> retired{false};                 // owning thread has exited
+        };
+
+        ThreadRing &ringForThisThread();
+        std::size_t drainInto(std::string &batch);
+        void writeBatch(const std::string &batch);
+        void appendEntry(std::string &batch, Level l, std::string_view message);
+        void writerLoop();
+
+        const uint64_t id;
         std::ofstream logfile;
+        std::mutex fileMutex;                      // writer batches vs. synchronous fatal writes
         std::string levels[4] = {"Fatal", "Error", "Warning", "Info"};
-    };
 
+        std::mutex ringsMutex;                     // taken only when a thread logs for the first time
+        std::vector<std::shared_ptr<ThreadRing>> rings;
 
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::condition_variable flushed;
+        uint64_t flushRequested = 0;
+        uint64_t flushCompleted = 0;
+        bool stopping = false;
+
+        std::atomic<uint64_t> written{0};
+        std::atomic<uint64_t> truncated{0};
+        std::atomic<uint64_t> droppedTotal{0};
+
+        std::thread writer;
+    };
 
 };
 
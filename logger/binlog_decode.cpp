@@ -0,0 +1,216 @@
+//
+// binlog_decode: print BinaryLog files as text.
+//
+// Usage: binlog_decode FILE...
+// Rotated files can be given oldest first (e.g. vehicleLog.bin.3 vehicleLog.bin.2 vehicleLog.bin.1 vehicleLog.bin).
+//
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BinaryLog.h"
+
+namespace {
+
+    struct Site {
+        int level;
+        uint32_t line;
+        std::string file;
+        std::string format;
+    };
+
+    const char *levelNames[4] = {"Fatal", "Error", "Warning", "Info"};
+
+    class Reader {
+    public:
+        explicit Reader(std::vector<uint8_t> data) : data(std::move(data)) {}
+
+        bool atEnd() const { return offset >= data.size(); }
+
+        template<typename T>
+        bool read(T &value) {
+            if(offset + sizeof(T) > data.size()) {
+                return false;
+            }
+            std::memcpy(&value, data.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        bool readString(std::string &value) {
+            uint16_t length;
+            if(!read(length) || offset + length > data.size()) {
+                return false;
+            }
+            value.assign(reinterpret_cast<const char *>(data.data() + offset), length);
+            offset += length;
+            return true;
+        }
+
+        bool skip(std::size_t count) {
+            if(offset + count > data.size()) {
+                return false;
+            }
+            offset += count;
+            return true;
+        }
+
+    private:
+        std::vector<uint8_t> data;
+        std::size_t offset = 0;
+    };
+
+    bool readArgument(Reader &reader, std::string &text) {
+        uint8_t type;
+        if(!reader.read(type)) {
+            return false;
+        }
+        switch(type) {
+            case Logger::BinaryLog::SignedArgument: {
+                int64_t value;
+                if(!reader.read(value)) return false;
+                text = std::to_string(value);
+                return true;
+            }
+            case Logger::BinaryLog::UnsignedArgument: {
+                uint64_t value;
+                if(!reader.read(value)) return false;
+                text = std::to_string(value);
+                return true;
+            }
+            case Logger::BinaryLog::DoubleArgument: {
+                double value;
+                if(!reader.read(value)) return false;
+                text = std::to_string(value);
+                return true;
+            }
+            case Logger::BinaryLog::StringArgument:
+                return reader.readString(text);
+            case Logger::BinaryLog::BoolArgument: {
+                uint8_t value;
+                if(!reader.read(value)) return false;
+                text = value ? "true" : "false";
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    std::string format(const std::string &pattern, const std::vector<std::string> &arguments) {
+        std::string out;
+        std::size_t next = 0;
+        for(std::size_t i = 0; i < pattern.size(); i++) {
+            if(pattern[i] == '{' && i + 1 < pattern.size() && pattern[i + 1] == '}') {
+                out += next < arguments.size() ? arguments[next] : "{?}";
+                next++;
+                i++;
+            } else {
+                out += pattern[i];
+            }
+        }
+        return out;
+    }
+
+    std::string formatTimestamp(uint64_t nanoseconds) {
+        std::time_t seconds = static_cast<std::time_t>(nanoseconds / 1000000000ULL);
+        std::tm utc{};
+        gmtime_r(&seconds, &utc);
+        char buffer[64];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+        char fraction[16];
+        std::snprintf(fraction, sizeof(fraction), ".%06lluZ",
+                      static_cast<unsigned long long>((nanoseconds % 1000000000ULL) / 1000));
+        return std::string(buffer) + fraction;
+    }
+
+    bool decodeFile(const char *path) {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.is_open()) {
+            std::cerr << "Unable to open " << path << std::endl;
+            return false;
+        }
+        Reader reader(std::vector<uint8_t>{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()});
+
+        char magic[sizeof(Logger::BinaryLog::MAGIC)];
+        for(char &c : magic) {
+            if(!reader.read(c)) {
+                break;
+            }
+        }
+        if(std::memcmp(magic, Logger::BinaryLog::MAGIC, sizeof(magic)) != 0) {
+            std::cerr << path << " is not a binary log" << std::endl;
+            return false;
+        }
+
+        std::unordered_map<uint32_t, Site> sites;
+        while(!reader.atEnd()) {
+            uint8_t type;
+            uint32_t id;
+            if(!reader.read(type) || !reader.read(id)) {
+                std::cerr << path << ": truncated record" << std::endl;
+                return false;
+            }
+
+            if(type == Logger::BinaryLog::SiteRecord) {
+                Site site{};
+                uint8_t level;
+                if(!reader.read(level) || !reader.read(site.line) ||
+                   !reader.readString(site.file) || !reader.readString(site.format)) {
+                    std::cerr << path << ": truncated site record" << std::endl;
+                    return false;
+                }
+                site.level = level;
+                sites[id] = site;
+            } else if(type == Logger::BinaryLog::EventRecord) {
+                uint64_t timestamp;
+                uint8_t count;
+                if(!reader.read(timestamp) || !reader.read(count)) {
+                    std::cerr << path << ": truncated event record" << std::endl;
+                    return false;
+                }
+                std::vector<std::string> arguments(count);
+                for(auto &argument : arguments) {
+                    if(!readArgument(reader, argument)) {
+                        std::cerr << path << ": malformed event argument" << std::endl;
+                        return false;
+                    }
+                }
+
+                auto site = sites.find(id);
+                if(site == sites.end()) {
+                    std::cout << formatTimestamp(timestamp) << " ?: unknown log site " << id << std::endl;
+                    continue;
+                }
+                const int level = site->second.level;
+                std::cout << formatTimestamp(timestamp) << ' '
+                          << (level >= 0 && level < 4 ? levelNames[level] : "?") << ": "
+                          << format(site->second.format, arguments)
+                          << " [" << site->second.file << ':' << site->second.line << ']' << std::endl;
+            } else {
+                std::cerr << path << ": unknown record type " << static_cast<int>(type) << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 2) {
+        std::cout << "Usage: binlog_decode FILE..." << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    for(int i = 1; i < argc; i++) {
+        ok = decodeFile(argv[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -11,12 +11,17 @@ from collections import defaultdict
 from typing import Dict, Iterable, List, Tuple
 
 DEFAULT_METRICS = pathlib.Path("falcon_metrics.csv")
+LATENCY_STAGES = ["queue", "sign", "send", "wire", "reassembly", "dispatch", "verify", "output", "total"]
 
 
 def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser(description="Generate summaries from V2X metrics CSV files")
     parser.add_argument("--metrics", type=pathlib.Path, default=DEFAULT_METRICS,
                         help="Metrics CSV produced by run_remote_falcon.py (default: %(default)s)")
+    parser.add_argument("--resources", type=pathlib.Path, default=None,
+                        help="Optional resource CSV (V2X_RESOURCE_FILE) to summarise CPU and memory per role")
+    parser.add_argument("--latency", type=pathlib.Path, default=None,
+                        help="Optional per-message latency CSV (V2X_LATENCY_FILE) to break latency down by stage")
     parser.add_argument("--filter", action="append", default=[],
                         help="Filter entries by key=value pairs present in the note column")
     parser.add_argument("--group", nargs="*", default=["scheme", "fragment", "compression", "loss"],
@@ -25,6 +30,8 @@ def parse_args() -> argparse.Namespace:
                         help="Optional path to write the aggregated summary as JSON")
     parser.add_argument("--output-markdown", type=pathlib.Path, default=None,
                         help="Optional path to write a Markdown table summary")
+    parser.add_argument("--include-warmup", action="store_true",
+                        help="Keep rows of warm-up runs (note warmup=1), which are skipped by default")
     parser.add_argument("--quiet", action="store_true",
                         help="Suppress console output (useful when writing to files)")
     return parser.parse_args()
@@ -80,7 +87,8 @@ def summarise_group(group: List[Dict[str, str]]) -> Dict[str, float]:
     return summary
 
 
-def load_rows(metrics_path: pathlib.Path, filters: Iterable[str]) -> List[Dict[str, str]]:
+def load_rows(metrics_path: pathlib.Path, filters: Iterable[str],
+              include_warmup: bool = False) -> List[Dict[str, str]]:
     if not metrics_path.exists():
         raise FileNotFoundError(f"Metrics file not found: {metrics_path}")
     with metrics_path.open("r", encoding="utf-8") as handle:
@@ -88,11 +96,82 @@ def load_rows(metrics_path: pathlib.Path, filters: Iterable[str]) -> List[Dict[s
         rows = []
         for row in reader:
             note_fields = parse_note(row.get("note", ""))
+            if not include_warmup and note_fields.get("warmup") == "1":
+                continue
             if matches_filters(note_fields, filters):
                 rows.append(row)
         return rows
 
 
+def summarise_resources(rows: List[Dict[str, str]],
+                        group_keys: List[str]) -> Dict[Tuple, Dict[str, Dict[str, float]]]:
+    """Average the whole-process rows of each group per role (transmitter/receiver)."""
+    by_role: Dict[Tuple, Dict[str, List[Dict[str, str]]]] = defaultdict(lambda: defaultdict(list))
+    for row in rows:
+        if row.get("thread") != "process":
+            continue
+        note_fields = parse_note(row.get("note", ""))
+        group_id = tuple(note_fields.get(key, "-") for key in group_keys)
+        by_role[group_id][row.get("role", "-")].append(row)
+
+    def mean_of(items: List[Dict[str, str]], column: str) -> float:
+        values = [float(item[column]) for item in items if item.get(column)]
+        return statistics.mean(values) if values else 0.0
+
+    summaries: Dict[Tuple, Dict[str, Dict[str, float]]] = {}
+    for group_id, roles in by_role.items():
+        summaries[group_id] = {}
+        for role, items in roles.items():
+            summaries[group_id][role] = {
+                "count": len(items),
+                "avg_cpu_us": mean_of(items, "cpu_us"),
+                "avg_user_us": mean_of(items, "user_us"),
+                "avg_system_us": mean_of(items, "system_us"),
+                "max_rss_kb": max((float(item["max_rss_kb"]) for item in items if item.get("max_rss_kb")),
+                                  default=0.0),
+                "avg_context_switches": mean_of(items, "voluntary_switches") + mean_of(items, "involuntary_switches"),
+                "avg_minor_faults": mean_of(items, "minor_faults"),
+                "avg_major_faults": mean_of(items, "major_faults"),
+            }
+    return summaries
+
+
+def quantile(sorted_values: List[float], q: float) -> float:
+    """Nearest-rank quantile, as in the receiver's LATENCY lines."""
+    rank = int(q * (len(sorted_values) - 1) + 0.5)
+    return sorted_values[min(rank, len(sorted_values) - 1)]
+
+
+def summarise_latency(rows: List[Dict[str, str]],
+                      group_keys: List[str]) -> Dict[Tuple, Dict[str, Dict[str, float]]]:
+    """Percentiles of every latency budget stage over all messages of each group."""
+    by_group: Dict[Tuple, Dict[str, List[float]]] = defaultdict(lambda: defaultdict(list))
+    for row in rows:
+        note_fields = parse_note(row.get("note", ""))
+        group_id = tuple(note_fields.get(key, "-") for key in group_keys)
+        for stage in LATENCY_STAGES:
+            value = row.get(f"{stage}_us")
+            if value:
+                by_group[group_id][stage].append(float(value))
+
+    summaries: Dict[Tuple, Dict[str, Dict[str, float]]] = {}
+    for group_id, stages in by_group.items():
+        summaries[group_id] = {}
+        for stage in LATENCY_STAGES:
+            values = sorted(stages.get(stage, []))
+            if not values:
+                continue
+            summaries[group_id][stage] = {
+                "count": len(values),
+                "avg_us": statistics.mean(values),
+                "p50_us": quantile(values, 0.50),
+                "p90_us": quantile(values, 0.90),
+                "p99_us": quantile(values, 0.99),
+                "max_us": values[-1],
+            }
+    return summaries
+
+
 def print_table(headers: List[str], data: List[List[str]]) -> None:
     widths = [len(h) for h in headers]
     for row in data:
@@ -110,7 +189,12 @@ def print_table(headers: List[str], data: List[List[str]]) -> None:
 
 
 def write_markdown(headers: List[str], data: List[List[str]], output_path: pathlib.Path) -> None:
-    with output_path.open("w", encoding="utf-8") as handle:
+    output_path.write_text("", encoding="utf-8")
+    append_markdown(headers, data, output_path)
+
+
+def append_markdown(headers: List[str], data: List[List[str]], output_path: pathlib.Path) -> None:
+    with output_path.open("a", encoding="utf-8") as handle:
         handle.write("| " + " | ".join(headers) + " |\n")
         handle.write("| " + " | ".join(["---"] * len(headers)) + " |\n")
         for row in data:
@@ -119,7 +203,7 @@ def write_markdown(headers: List[str], data: List[List[str]], output_path: pathl
 
 def main() -> None:
     args = parse_args()
-    rows = load_rows(args.metrics, args.filter)
+    rows = load_rows(args.metrics, args.filter, args.include_warmup)
 
     grouped = group_metrics(rows, args.group)
     headers = ["group"] + ["count", "avg_total_us", "stdev_total_us", "min_total_us", "max_total_us", "avg_total_ms"]
@@ -139,8 +223,57 @@ def main() -> None:
             f"{summary['avg_total_ms']:.4f}",
         ])
 
+    resource_headers = ["group", "role", "count", "avg_cpu_us", "avg_user_us", "avg_system_us", "max_rss_kb",
+                        "avg_context_switches", "avg_minor_faults"]
+    resource_rows: List[List[str]] = []
+    if args.resources:
+        resources = summarise_resources(load_rows(args.resources, args.filter, args.include_warmup), args.group)
+        for group_id, roles in sorted(resources.items()):
+            group_name = ";".join(map(str, group_id))
+            json_output.setdefault(group_name, {})["resources"] = roles
+            for role, summary in sorted(roles.items()):
+                resource_rows.append([
+                    group_name,
+                    role,
+                    str(summary["count"]),
+                    f"{summary['avg_cpu_us']:.0f}",
+                    f"{summary['avg_user_us']:.0f}",
+                    f"{summary['avg_system_us']:.0f}",
+                    f"{summary['max_rss_kb']:.0f}",
+                    f"{summary['avg_context_switches']:.1f}",
+                    f"{summary['avg_minor_faults']:.1f}",
+                ])
+
+    latency_headers = ["group", "stage", "messages", "avg_us", "p50_us", "p90_us", "p99_us", "max_us"]
+    latency_rows: List[List[str]] = []
+    if args.latency:
+        latency = summarise_latency(load_rows(args.latency, args.filter, args.include_warmup), args.group)
+        for group_id, stages in sorted(latency.items()):
+            group_name = ";".join(map(str, group_id))
+            json_output.setdefault(group_name, {})["latency"] = stages
+            for stage in LATENCY_STAGES:
+                if stage not in stages:
+                    continue
+                summary = stages[stage]
+                latency_rows.append([
+                    group_name,
+                    stage,
+                    str(summary["count"]),
+                    f"{summary['avg_us']:.1f}",
+                    f"{summary['p50_us']:.0f}",
+                    f"{summary['p90_us']:.0f}",
+                    f"{summary['p99_us']:.0f}",
+                    f"{summary['max_us']:.0f}",
+                ])
+
     if not args.quiet:
         print_table(headers, table_rows)
+        if resource_rows:
+            print()
+            print_table(resource_headers, resource_rows)
+        if latency_rows:
+            print()
+            print_table(latency_headers, latency_rows)
 
     if args.output_json:
         with args.output_json.open("w", encoding="utf-8") as handle:
@@ -148,6 +281,14 @@ def main() -> None:
 
     if args.output_markdown:
         write_markdown(headers, table_rows, args.output_markdown)
+        if resource_rows:
+            with args.output_markdown.open("a", encoding="utf-8") as handle:
+                handle.write("\n")
+            append_markdown(resource_headers, resource_rows, args.output_markdown)
+        if latency_rows:
+            with args.output_markdown.open("a", encoding="utf-8") as handle:
+                handle.write("\n")
+            append_markdown(latency_headers, latency_rows, args.output_markdown)
 
 if __name__ == "__main__":
     main()
@@ -13,25 +13,49 @@ from __future__ import annotations
 
 import argparse
 import csv
+import io
 import json
+import math
 import os
 import pathlib
+import select
 import statistics
+import re
+import shutil
 import subprocess
 import tempfile
+import threading
 import time
+from concurrent.futures import ThreadPoolExecutor
 from dataclasses import dataclass
 from typing import Dict, Iterable, IO, List, Optional, Tuple
 
 DEFAULT_BINARY = pathlib.Path("build") / "falcon-sim" / "falcon_sim"
 DEFAULT_CONFIG = pathlib.Path("falcon-sim") / "config.json"
 DEFAULT_METRICS = pathlib.Path("falcon_metrics.csv")
+DEFAULT_RESOURCES = pathlib.Path("falcon_resources.csv")
+DEFAULT_LATENCY = pathlib.Path("falcon_latency.csv")
+METRICS_FIELDS = ["run", "scheme", "total_us", "first_us", "last_us", "note"]
+RESOURCE_HEADER = ("run,role,thread,scheme,wall_us,cpu_us,user_us,system_us,max_rss_kb,"
+                   "voluntary_switches,involuntary_switches,minor_faults,major_faults,note\n")
+LATENCY_HEADER = ("run,vehicle,sequence,scheme,generated_us,queue_us,sign_us,send_us,wire_us,reassembly_us,"
+                  "dispatch_us,verify_us,output_us,total_us,note\n")
 
 
 @dataclass
 class SweepParameters:
     fragment_size: Optional[int]
     compression: Optional[str]
+    scheme: str = "falcon"
+    packet_loss: float = 0.0
+
+
+@dataclass
+class RunSlot:
+    """Resources owned by one concurrently running parameter set."""
+    index: int
+    port: Optional[int]
+    cpus: Optional[List[int]]
 
 
 def parse_args() -> argparse.Namespace:
@@ -43,9 +67,23 @@ def parse_args() -> argparse.Namespace:
     parser.add_argument("--config", type=pathlib.Path, default=DEFAULT_CONFIG,
                         help="Base configuration JSON used as input (default: %(default)s)")
     parser.add_argument("--runs", type=int, default=10,
-                        help="Number of iterations per parameter set (default: %(default)s)")
-    parser.add_argument("--scheme", choices=["ecdsa", "falcon"], default="falcon",
-                        help="Signature scheme to exercise (default: %(default)s)")
+                        help="Number of iterations per parameter set; the upper bound when a CI target is set "
+                             "(default: %(default)s)")
+    parser.add_argument("--warmup-runs", type=int, default=0,
+                        help="Extra runs per parameter set before measuring; their rows are tagged warmup=1 and "
+                             "excluded from summaries (default: %(default)s)")
+    parser.add_argument("--ci-width-us", type=float, default=None,
+                        help="Stop a parameter set once the confidence interval of the mean total_us is at most "
+                             "this wide (full width, microseconds)")
+    parser.add_argument("--ci-rel-width", type=float, default=None,
+                        help="Stop a parameter set once the confidence interval is at most this fraction of the "
+                             "mean wide (e.g. 0.02 for +/-1%%)")
+    parser.add_argument("--confidence", type=float, default=0.95,
+                        help="Confidence level for --ci-width-us/--ci-rel-width (default: %(default)s)")
+    parser.add_argument("--min-runs", type=int, default=30,
+                        help="Measured runs before a CI target may stop a parameter set (default: %(default)s)")
+    parser.add_argument("--scheme", choices=["ecdsa", "falcon"], nargs="+", default=["falcon"],
+                        help="Signature scheme(s) to exercise (default: %(default)s)")
     parser.add_argument("--fragment-sizes", type=int, nargs="*", default=None,
                         help="Fragment sizes (bytes) to sweep for Falcon mode")
     parser.add_argument("--compression", nargs="*", default=None,
@@ -54,18 +92,41 @@ def parse_args() -> argparse.Namespace:
                         help="Override number of vehicles in config")
     parser.add_argument("--messages", type=int, default=None,
                         help="Override number of messages per vehicle in config")
-    parser.add_argument("--packet-loss", type=float, default=0.0,
-                        help="Simulated fragment loss rate (0.0-1.0) applied at the transmitter")
+    parser.add_argument("--packet-loss", type=float, nargs="+", default=[0.0],
+                        help="Simulated fragment loss rate(s) (0.0-1.0) applied at the transmitter")
     parser.add_argument("--metrics-file", type=pathlib.Path, default=DEFAULT_METRICS,
                         help="CSV file to append metrics to (default: %(default)s)")
+    parser.add_argument("--resource-file", type=pathlib.Path, default=DEFAULT_RESOURCES,
+                        help="CSV file for per-thread/per-process CPU, memory and scheduling usage of both "
+                             "roles (default: %(default)s)")
+    parser.add_argument("--latency-file", type=pathlib.Path, default=DEFAULT_LATENCY,
+                        help="CSV file for the per-message latency budget (sign, wire, reassembly, verify, output "
+                             "stages) recorded by the receiver (default: %(default)s)")
     parser.add_argument("--log-dir", type=pathlib.Path, default=None,
                         help="Optional directory for per-run stdout/stderr logs")
     parser.add_argument("--note", default="",
                         help="Free-form note stored alongside metrics entries")
+    parser.add_argument("--ready", choices=["fd", "file", "sleep"], default="fd",
+                        help="How the transmitter waits for the receiver: 'fd' waits for the receiver to write to "
+                             "an inherited pipe (V2X_READY_FD), 'file' starts both at once and lets the transmitter "
+                             "wait for V2X_READY_FILE, 'sleep' waits --sleep-ms (default: %(default)s)")
+    parser.add_argument("--ready-timeout-ms", type=int, default=10000,
+                        help="Give up on a run if the receiver is not ready within this time (default: %(default)s)")
     parser.add_argument("--sleep-ms", type=int, default=200,
-                        help="Delay between launching receiver and transmitter (default: %(default)s ms)")
+                        help="Delay between launching receiver and transmitter with --ready sleep "
+                             "(default: %(default)s ms)")
     parser.add_argument("--base-port", type=int, default=None,
-                        help="Override test UDP port (default: 6666)")
+                        help="Override test UDP port; concurrent parameter sets use consecutive ports from here "
+                             "(default: 6666)")
+    parser.add_argument("--parallel", type=int, default=1,
+                        help="Parameter sets to run at once, each with its own port, CPUs and output files, merged "
+                             "into --metrics-file/--resource-file/--latency-file at the end (default: %(default)s)")
+    parser.add_argument("--pin", choices=["auto", "none"], default="auto",
+                        help="With --parallel > 1, 'auto' splits the allowed CPUs evenly between the parameter sets "
+                             "(V2X_AFFINITY_*); 'none' leaves placement to the binary's own settings "
+                             "(default: %(default)s)")
+    parser.add_argument("--crypto-kernel", choices=["auto", "portable", "avx2"], default=None,
+                        help="Force the Falcon/SHA-256 kernel variant for A/B benchmarking (default: config/auto)")
     parser.add_argument("--dry-run", action="store_true",
                         help="Print the derived run plan without executing it")
     parser.add_argument("--keep-temp-config", action="store_true",
@@ -84,6 +145,24 @@ def ensure_metrics_header(path: pathlib.Path) -> None:
         handle.write(header)
 
 
+def ensure_resource_header(path: pathlib.Path) -> None:
+    if path.exists():
+        with path.open("r", encoding="utf-8") as existing:
+            if existing.readline().startswith("run,role,"):
+                return
+    with path.open("w", encoding="utf-8") as handle:
+        handle.write(RESOURCE_HEADER)
+
+
+def ensure_latency_header(path: pathlib.Path) -> None:
+    if path.exists():
+        with path.open("r", encoding="utf-8") as existing:
+            if existing.readline().startswith("run,vehicle,"):
+                return
+    with path.open("w", encoding="utf-8") as handle:
+        handle.write(LATENCY_HEADER)
+
+
 def load_base_config(path: pathlib.Path) -> Dict:
     with path.open("r", encoding="utf-8") as handle:
         return json.load(handle)
@@ -136,18 +215,68 @@ def plan_parameters(args: argparse.Namespace, base_config: Dict) -> Iterable[Swe
         compression_modes = [default_compression]
 
     seen = set()
-    for fragment_size in fragment_sizes:
-        for comp in compression_modes:
-            key = (fragment_size, comp)
-            if key in seen:
-                continue
-            seen.add(key)
-            yield SweepParameters(fragment_size=fragment_size, compression=comp)
+    for scheme in args.scheme:
+        for loss in args.packet_loss:
+            # ECDSA signatures are never fragmented, so there is nothing to sweep
+            scheme_fragments = fragment_sizes if scheme == "falcon" else [default_fragment]
+            for fragment_size in scheme_fragments:
+                for comp in compression_modes:
+                    key = (scheme, loss, fragment_size, comp)
+                    if key in seen:
+                        continue
+                    seen.add(key)
+                    yield SweepParameters(fragment_size=fragment_size, compression=comp, scheme=scheme,
+                                          packet_loss=loss)
+
+
+def plan_slots(args: argparse.Namespace) -> List[RunSlot]:
+    """One port and (optionally) one disjoint CPU set per concurrent parameter set."""
+    count = max(args.parallel, 1)
+    base_port = args.base_port if args.base_port is not None else (6666 if count > 1 else None)
+    cpu_sets: List[Optional[List[int]]] = [None] * count
+    if count > 1 and args.pin == "auto":
+        cpus = sorted(os.sched_getaffinity(0))
+        share = len(cpus) // count
+        if share >= 1:
+            cpu_sets = [cpus[i * share:(i + 1) * share] for i in range(count)]
+        else:
+            print(f"Warning: {len(cpus)} CPUs for {count} parallel parameter sets; not pinning.")
+    return [RunSlot(index=i, port=None if base_port is None else base_port + i, cpus=cpu_sets[i])
+            for i in range(count)]
+
+
+def slot_affinity_env(cpus: List[int]) -> Dict[str, str]:
+    """Receiver on the slot's first CPU, transmitters on the rest, verifier threads anywhere in the slot."""
+    def cpu_list(values: List[int]) -> str:
+        return ",".join(str(cpu) for cpu in values)
+    transmitter = cpus[1:] or cpus
+    return {
+        "V2X_AFFINITY_RECEIVER": cpu_list(cpus[:1]),
+        "V2X_AFFINITY_TRANSMITTER": cpu_list(transmitter),
+        "V2X_AFFINITY_VERIFIER": cpu_list(cpus),
+    }
+
+
+def slot_resource_env(base_config: Dict, env_base: Dict[str, str], slot: RunSlot) -> Dict[str, str]:
+    """Per-slot verification-service shared memory, HSM socket and capture directory, named after the slot."""
+    scenario = base_config.get("scenario", {})
+    shm = env_base.get("V2X_VERIFIER_SHM") or scenario.get("verifier", {}).get("shmName", "/v2x_verifier")
+    socket = env_base.get("V2X_HSM_SOCKET") or scenario.get("signing", {}).get("hsmSocket", "/tmp/v2x_hsm.sock")
+    env = {
+        "V2X_VERIFIER_SHM": f"{shm}_{slot.index}",
+        "V2X_HSM_SOCKET": f"{socket}.{slot.index}",
+    }
+    capture = scenario.get("capture", {})
+    if env_base.get("V2X_CAPTURE_DIR") or capture.get("enabled"):
+        directory = env_base.get("V2X_CAPTURE_DIR") or capture.get("directory", "captures")
+        env["V2X_CAPTURE_DIR"] = str(pathlib.Path(directory) / f"slot{slot.index}")
+    return env
 
 
 def launch_process(command: List[str],
                    env: Dict[str, str],
-                   log_path: Optional[pathlib.Path]) -> Tuple[subprocess.Popen, Optional[IO[str]]]:
+                   log_path: Optional[pathlib.Path],
+                   pass_fds: Tuple[int, ...] = ()) -> Tuple[subprocess.Popen, Optional[IO[str]]]:
     stdout_target = subprocess.PIPE
     log_handle: Optional[IO[str]] = None
     if log_path is not None:
@@ -158,7 +287,8 @@ def launch_process(command: List[str],
         command,
         stdout=stdout_target,
         stderr=subprocess.STDOUT,
-        env=env
+        env=env,
+        pass_fds=pass_fds
     )
     return process, log_handle
 
@@ -178,12 +308,28 @@ def collect_output(process: subprocess.Popen,
         print(decoded)
 
 
+def wait_for_ready_fd(read_fd: int, receiver_proc: subprocess.Popen, timeout_ms: int) -> None:
+    """Block until the receiver reports its socket is bound (a line on the pipe), it exits, or the timeout."""
+    try:
+        readable, _, _ = select.select([read_fd], [], [], max(timeout_ms, 0) / 1000.0)
+        if not readable:
+            receiver_proc.kill()
+            raise RuntimeError(f"Receiver not ready within {timeout_ms} ms")
+        if not os.read(read_fd, 64).startswith(b"ready"):
+            # EOF: the receiver exited (or closed the pipe) before binding
+            raise RuntimeError(f"Receiver exited before becoming ready (status {receiver_proc.wait()})")
+    finally:
+        os.close(read_fd)
+
+
 def run_iteration(binary: pathlib.Path,
                   config_path: pathlib.Path,
                   env_template: Dict[str, str],
                   run_id: int,
                   log_dir: Optional[pathlib.Path],
-                  sleep_ms: int) -> None:
+                  sleep_ms: int,
+                  ready: str = "sleep",
+                  ready_timeout_ms: int = 10000) -> None:
     env = dict(env_template)
     env["V2X_METRICS_RUN"] = str(run_id)
     env["V2X_CONFIG_PATH"] = str(config_path)
@@ -195,16 +341,36 @@ def run_iteration(binary: pathlib.Path,
         transmitter_log = log_dir / f"transmitter_run_{run_id:04d}.log"
 
     receiver_cmd = [str(binary), "dsrc", "receiver", "nogui", "--test"]
+    ready_tag = env.get("V2X_TEST_PORT", "default")
     transmitter_cmd = [str(binary), "dsrc", "transmitter", "nogui", "--test"]
 
-    receiver_proc, receiver_handle = launch_process(receiver_cmd, env, receiver_log)
-    time.sleep(max(sleep_ms, 0) / 1000.0)
+    ready_file: Optional[pathlib.Path] = None
+    if ready == "fd":
+        read_fd, write_fd = os.pipe()
+        env["V2X_READY_FD"] = str(write_fd)
+        try:
+            receiver_proc, receiver_handle = launch_process(receiver_cmd, env, receiver_log, pass_fds=(write_fd,))
+        finally:
+            os.close(write_fd)
+        wait_for_ready_fd(read_fd, receiver_proc, ready_timeout_ms)
+        del env["V2X_READY_FD"]
+    elif ready == "file":
+        ready_file = pathlib.Path(tempfile.gettempdir()) / f"pqv2_ready_{os.getpid()}_{ready_tag}_{run_id}"
+        ready_file.unlink(missing_ok=True)
+        env["V2X_READY_FILE"] = str(ready_file)
+        env["V2X_READY_TIMEOUT_MS"] = str(ready_timeout_ms)
+        receiver_proc, receiver_handle = launch_process(receiver_cmd, env, receiver_log)
+    else:
+        receiver_proc, receiver_handle = launch_process(receiver_cmd, env, receiver_log)
+        time.sleep(max(sleep_ms, 0) / 1000.0)
     transmitter_proc, transmitter_handle = launch_process(transmitter_cmd, env, transmitter_log)
 
     transmitter_code = transmitter_proc.wait()
     collect_output(transmitter_proc, transmitter_handle, transmitter_log)
     receiver_code = receiver_proc.wait()
     collect_output(receiver_proc, receiver_handle, receiver_log)
+    if ready_file is not None:
+        ready_file.unlink(missing_ok=True)
 
     if transmitter_code != 0:
         raise RuntimeError(f"Transmitter exited with status {transmitter_code} for run {run_id}")
@@ -225,6 +391,114 @@ def read_metrics(metrics_path: pathlib.Path, note_filter: str) -> List[Dict[str,
     return results
 
 
+class MetricsFollower:
+    """Reads the rows appended to the metrics CSV since the last call."""
+
+    def __init__(self, path: pathlib.Path) -> None:
+        self.path = path
+        self.offset = path.stat().st_size if path.exists() else 0
+
+    def new_rows(self) -> List[Dict[str, str]]:
+        if not self.path.exists():
+            return []
+        with self.path.open("r", encoding="utf-8", newline="") as handle:
+            handle.seek(self.offset)
+            text = handle.read()
+        complete = text[:text.rfind("\n") + 1]     # leave a partly written row for the next call
+        self.offset += len(complete.encode("utf-8"))
+        return list(csv.DictReader(io.StringIO(complete), fieldnames=METRICS_FIELDS))
+
+
+# Two-sided Student t critical values for 1..30 degrees of freedom at the usual confidence levels.
+T_TABLE = {
+    0.90: (6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812,
+           1.796, 1.782, 1.771, 1.761, 1.753, 1.746, 1.740, 1.734, 1.729, 1.725,
+           1.721, 1.717, 1.714, 1.711, 1.708, 1.706, 1.703, 1.701, 1.699, 1.697),
+    0.95: (12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+           2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+           2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042),
+    0.99: (63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169,
+           3.106, 3.055, 3.012, 2.977, 2.947, 2.921, 2.898, 2.878, 2.861, 2.845,
+           2.831, 2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750),
+}
+T_TABLE_MAX_DOF = 30
+
+
+def t_central_probability(t: float, dof: int) -> float:
+    """P(|T| < t) for integer degrees of freedom (closed-form series in theta = atan(t / sqrt(dof)))."""
+    theta = math.atan(t / math.sqrt(dof))
+    cos2 = math.cos(theta) ** 2
+    if dof % 2:
+        term = math.cos(theta)
+        total = term if dof > 1 else 0.0
+        for k in range(3, dof - 1, 2):          # cos + 2/3 cos^3 + (2*4)/(3*5) cos^5 + ...
+            term *= cos2 * (k - 1) / k
+            total += term
+        return 2.0 / math.pi * (theta + math.sin(theta) * total)
+    term, total = 1.0, 1.0
+    for k in range(2, dof, 2):                  # 1 + 1/2 cos^2 + (1*3)/(2*4) cos^4 + ...
+        term *= cos2 * (k - 1) / k
+        total += term
+    return math.sin(theta) * total
+
+
+def t_quantile(confidence: float, dof: int) -> float:
+    """Two-sided Student t critical value.
+
+    Exact up to 30 degrees of freedom (the table, or bisection on the closed-form distribution for other
+    confidence levels); above that the Cornish-Fisher expansion around the normal quantile is good to 1e-3."""
+    dof = max(dof, 1)
+    if dof <= T_TABLE_MAX_DOF:
+        for level, row in T_TABLE.items():
+            if math.isclose(confidence, level):
+                return row[dof - 1]
+        low, high = 0.0, 1.0
+        while t_central_probability(high, dof) < confidence:
+            high *= 2.0
+        for _ in range(100):
+            middle = (low + high) / 2.0
+            if t_central_probability(middle, dof) < confidence:
+                low = middle
+            else:
+                high = middle
+        return (low + high) / 2.0
+    z = statistics.NormalDist().inv_cdf(0.5 + confidence / 2.0)
+    nu = float(dof)
+    return (z
+            + (z ** 3 + z) / (4 * nu)
+            + (5 * z ** 5 + 16 * z ** 3 + 3 * z) / (96 * nu ** 2)
+            + (3 * z ** 7 + 19 * z ** 5 + 17 * z ** 3 - 15 * z) / (384 * nu ** 3))
+
+
+def confidence_interval(values: List[float], confidence: float) -> Tuple[float, float]:
+    """Mean and half-width of its confidence interval."""
+    mean = statistics.mean(values)
+    if len(values) < 2:
+        return mean, math.inf
+    stderr = statistics.stdev(values) / math.sqrt(len(values))
+    return mean, t_quantile(confidence, len(values) - 1) * stderr
+
+
+def ci_target_reached(values: List[float], args: argparse.Namespace) -> bool:
+    if len(values) < max(args.min_runs, 2):
+        return False
+    mean, half_width = confidence_interval(values, args.confidence)
+    if args.ci_width_us is not None and 2 * half_width > args.ci_width_us:
+        return False
+    if args.ci_rel_width is not None and 2 * half_width > args.ci_rel_width * abs(mean):
+        return False
+    return True
+
+
+def find_outliers(values: List[float]) -> List[int]:
+    """Indices of values outside Tukey's fences (1.5 IQR beyond the quartiles)."""
+    if len(values) < 4:
+        return []
+    q1, _, q3 = statistics.quantiles(values, n=4)
+    spread = 1.5 * (q3 - q1)
+    return [i for i, value in enumerate(values) if value < q1 - spread or value > q3 + spread]
+
+
 def summarise_metrics(rows: List[Dict[str, str]]) -> Dict[str, float]:
     totals = [float(row["total_us"]) for row in rows if row.get("total_us")]
     if not totals:
@@ -238,99 +512,223 @@ def summarise_metrics(rows: List[Dict[str, str]]) -> Dict[str, float]:
     return summary
 
 
+def run_parameter_set(args: argparse.Namespace,
+                      base_config: Dict,
+                      params: SweepParameters,
+                      env_base: Dict[str, str],
+                      slot: RunSlot,
+                      metrics_file: pathlib.Path,
+                      resource_file: pathlib.Path,
+                      latency_file: pathlib.Path,
+                      log_dir: Optional[pathlib.Path],
+                      print_lock: threading.Lock) -> None:
+    env_template = dict(env_base)
+    env_template["V2X_SIGNATURE_SCHEME"] = params.scheme
+    env_template["V2X_METRICS_FILE"] = str(metrics_file)
+    env_template["V2X_RESOURCE_FILE"] = str(resource_file)
+    env_template["V2X_LATENCY_FILE"] = str(latency_file)
+    if params.packet_loss > 0.0:
+        env_template["V2X_PACKET_LOSS_RATE"] = f"{params.packet_loss:.6f}"
+    else:
+        env_template.pop("V2X_PACKET_LOSS_RATE", None)
+    if slot.port is not None:
+        env_template["V2X_TEST_PORT"] = str(slot.port)
+        env_template.update(slot_resource_env(base_config, env_base, slot))
+    else:
+        env_template.pop("V2X_TEST_PORT", None)
+    if slot.cpus:
+        env_template.update(slot_affinity_env(slot.cpus))
+
+    run_note = f"scheme={params.scheme}"
+    if params.fragment_size is not None:
+        run_note += f";fragment={params.fragment_size}"
+        env_template["V2X_FALCON_FRAGMENT_BYTES"] = str(params.fragment_size)
+    else:
+        env_template.pop("V2X_FALCON_FRAGMENT_BYTES", None)
+
+    if params.compression is not None:
+        env_template["V2X_FALCON_COMPRESSION"] = params.compression
+        run_note += f";compression={params.compression}"
+    else:
+        env_template.pop("V2X_FALCON_COMPRESSION", None)
+
+    if params.packet_loss > 0.0:
+        run_note += f";loss={params.packet_loss}"
+    if args.crypto_kernel is not None:
+        run_note += f";kernel={args.crypto_kernel}"
+
+    note_base = args.note.strip()
+    if note_base:
+        run_note += f";{note_base}"
+
+    temp_config = build_temp_config(
+        base_config,
+        params.scheme,
+        args.vehicles,
+        args.messages,
+        params.fragment_size,
+        params.compression,
+        keep_file=args.keep_temp_config,
+    )
+
+    adaptive = args.ci_width_us is not None or args.ci_rel_width is not None
+    follower = MetricsFollower(metrics_file)
+    totals: List[float] = []
+    total_run_ids: List[str] = []
+    try:
+        for run_index in range(args.warmup_runs + args.runs):
+            warmup = run_index < args.warmup_runs
+            env_template["V2X_METRICS_NOTE"] = run_note + ";warmup=1" if warmup else run_note
+            run_iteration(
+                binary=args.binary,
+                config_path=temp_config,
+                env_template=env_template,
+                run_id=run_index,
+                log_dir=log_dir,
+                sleep_ms=args.sleep_ms,
+                ready=args.ready,
+                ready_timeout_ms=args.ready_timeout_ms,
+            )
+            for row in follower.new_rows():
+                if not warmup and row.get("note") == run_note and row.get("total_us"):
+                    totals.append(float(row["total_us"]))
+                    total_run_ids.append(row.get("run", "?"))
+            if adaptive and not warmup and ci_target_reached(totals, args):
+                with print_lock:
+                    print(f"CI target reached for {run_note} after {len(totals)} measured runs")
+                break
+    finally:
+        if not args.keep_temp_config and temp_config.exists():
+            temp_config.unlink(missing_ok=True)
+
+    lines = []
+    rows = read_metrics(metrics_file, run_note)
+    summary = summarise_metrics(rows)
+    if summary:
+        lines.append(f"Summary for {run_note}: "
+                     f"{summary['count']} runs, "
+                     f"avg_total_us={summary['avg_total_us']:.2f}, "
+                     f"stdev_total_us={summary['stdev_total_us']:.2f}, "
+                     f"avg_total_ms={summary['avg_total_ms']:.4f}")
+    else:
+        lines.append(f"No metrics captured for {run_note}")
+
+    if totals:
+        mean, half_width = confidence_interval(totals, args.confidence)
+        lines.append(f"This sweep: {len(totals)} measured runs (+{args.warmup_runs} warm-up), "
+                     f"mean_total_us={mean:.2f} +/- {half_width:.2f} ({args.confidence:.0%} CI)")
+        outliers = find_outliers(totals)
+        if outliers:
+            listed = ", ".join(f"run {total_run_ids[i]} ({totals[i]:.0f} us)" for i in outliers[:10])
+            more = f" and {len(outliers) - 10} more" if len(outliers) > 10 else ""
+            lines.append(f"  {len(outliers)} outliers beyond 1.5 IQR (kept in the mean): {listed}{more}")
+    with print_lock:
+        print("\n".join(lines))
+
+
+def merge_csv_parts(parts: List[pathlib.Path], target: pathlib.Path) -> None:
+    """Append the data rows of each part (header skipped) to target, in order."""
+    with target.open("a", encoding="utf-8") as out:
+        for part in parts:
+            if not part.exists():
+                continue
+            with part.open("r", encoding="utf-8") as handle:
+                handle.readline()
+                shutil.copyfileobj(handle, out)
+
+
 def main() -> None:
     args = parse_args()
 
-    if args.scheme == "ecdsa" and args.fragment_sizes:
+    if args.scheme == ["ecdsa"] and args.fragment_sizes:
         print("Warning: fragment sizes are ignored for ECDSA runs.")
 
     base_config = load_base_config(args.config)
     ensure_metrics_header(args.metrics_file)
+    ensure_resource_header(args.resource_file)
+    ensure_latency_header(args.latency_file)
 
     plan = list(plan_parameters(args, base_config))
     if not plan:
         plan = [SweepParameters(fragment_size=None, compression=None)]
+    slots = plan_slots(args)
 
     if args.dry_run:
         print("Dry run plan:")
         for params in plan:
-            print(f"  fragment_size={params.fragment_size}, compression={params.compression}")
+            print(f"  scheme={params.scheme}, loss={params.packet_loss}, "
+                  f"fragment_size={params.fragment_size}, compression={params.compression}")
+        if len(slots) > 1:
+            print(f"{len(slots)} at a time, each in the next free slot:")
+            for slot in slots:
+                resources = slot_resource_env(base_config, os.environ, slot)
+                capture = f", capture_dir={resources['V2X_CAPTURE_DIR']}" if "V2X_CAPTURE_DIR" in resources else ""
+                print(f"  slot {slot.index}: port={slot.port}, cpus={slot.cpus if slot.cpus else 'unpinned'}, "
+                      f"verifier_shm={resources['V2X_VERIFIER_SHM']}, hsm_socket={resources['V2X_HSM_SOCKET']}"
+                      f"{capture}")
         return
 
     if not args.binary.exists():
         raise FileNotFoundError(f"Executable not found at {args.binary}")
 
-    env_template = os.environ.copy()
-    env_template["V2X_SIGNATURE_SCHEME"] = args.scheme
-    env_template["V2X_METRICS_FILE"] = str(args.metrics_file)
-    if args.packet_loss > 0.0:
-        env_template["V2X_PACKET_LOSS_RATE"] = f"{args.packet_loss:.6f}"
+    env_base = os.environ.copy()
+    if args.crypto_kernel is not None:
+        env_base["V2X_CRYPTO_KERNEL"] = args.crypto_kernel
     else:
-        env_template.pop("V2X_PACKET_LOSS_RATE", None)
-    if args.base_port is not None:
-        env_template["V2X_TEST_PORT"] = str(args.base_port)
-    else:
-        env_template.pop("V2X_TEST_PORT", None)
-    note_base = args.note.strip()
+        env_base.pop("V2X_CRYPTO_KERNEL", None)
+    print_lock = threading.Lock()
 
-    for params in plan:
-        run_note = f"scheme={args.scheme}"
-        if params.fragment_size is not None:
-            run_note += f";fragment={params.fragment_size}"
-            env_template["V2X_FALCON_FRAGMENT_BYTES"] = str(params.fragment_size)
-        elif "V2X_FALCON_FRAGMENT_BYTES" in env_template:
-            env_template.pop("V2X_FALCON_FRAGMENT_BYTES", None)
-
-        if params.compression is not None:
-            env_template["V2X_FALCON_COMPRESSION"] = params.compression
-            run_note += f";compression={params.compression}"
-        elif "V2X_FALCON_COMPRESSION" in env_template:
-            env_template.pop("V2X_FALCON_COMPRESSION", None)
-
-        if args.packet_loss > 0.0:
-            run_note += f";loss={args.packet_loss}"
-        if args.base_port is not None:
-            run_note += f";port={args.base_port}"
-
-        if note_base:
-            run_note += f";{note_base}"
-
-        env_template["V2X_METRICS_NOTE"] = run_note
-
-        temp_config = build_temp_config(
-            base_config,
-            args.scheme,
-            args.vehicles,
-            args.messages,
-            params.fragment_size,
-            params.compression,
-            keep_file=args.keep_temp_config,
-        )
+    if len(slots) == 1:
+        for params in plan:
+            run_parameter_set(args, base_config, params, env_base, slots[0], args.metrics_file,
+                              args.resource_file, args.latency_file, args.log_dir, print_lock)
+        return
 
+    # Concurrent parameter sets write their own files under <metrics>.parts/, merged in plan order at the end.
+    parts_dir = args.metrics_file.parent / f"{args.metrics_file.stem}.parts"
+    parts_dir.mkdir(parents=True, exist_ok=True)
+    free_slots = list(slots)
+    slot_lock = threading.Lock()
+    metrics_parts: List[pathlib.Path] = []
+    resource_parts: List[pathlib.Path] = []
+    latency_parts: List[pathlib.Path] = []
+
+    def run_in_slot(index: int, params: SweepParameters) -> None:
+        with slot_lock:
+            slot = free_slots.pop()
         try:
-            for run_index in range(args.runs):
-                run_iteration(
-                    binary=args.binary,
-                    config_path=temp_config,
-                    env_template=env_template,
-                    run_id=run_index,
-                    log_dir=args.log_dir,
-                    sleep_ms=args.sleep_ms,
-                )
+            label = re.sub(r"[^A-Za-z0-9.]+", "_", f"{params.scheme}_{params.fragment_size}_"
+                                                    f"{params.compression}_{params.packet_loss}")
+            set_log_dir = args.log_dir / f"set{index:03d}_{label}" if args.log_dir is not None else None
+            run_parameter_set(args, base_config, params, env_base, slot, metrics_parts[index],
+                              resource_parts[index], latency_parts[index], set_log_dir, print_lock)
         finally:
-            if not args.keep_temp_config and temp_config.exists():
-                temp_config.unlink(missing_ok=True)
-
-        rows = read_metrics(args.metrics_file, run_note)
-        summary = summarise_metrics(rows)
-        if summary:
-            print(f"Summary for {run_note}: "
-                  f"{summary['count']} runs, "
-                  f"avg_total_us={summary['avg_total_us']:.2f}, "
-                  f"stdev_total_us={summary['stdev_total_us']:.2f}, "
-                  f"avg_total_ms={summary['avg_total_ms']:.4f}")
-        else:
-            print(f"No metrics captured for {run_note}")
+            with slot_lock:
+                free_slots.append(slot)
+
+    for index in range(len(plan)):
+        metrics_parts.append(parts_dir / f"{index:03d}_metrics.csv")
+        resource_parts.append(parts_dir / f"{index:03d}_resources.csv")
+        latency_parts.append(parts_dir / f"{index:03d}_latency.csv")
+        metrics_parts[index].unlink(missing_ok=True)
+        resource_parts[index].unlink(missing_ok=True)
+        latency_parts[index].unlink(missing_ok=True)
+        ensure_metrics_header(metrics_parts[index])
+        ensure_resource_header(resource_parts[index])
+        ensure_latency_header(latency_parts[index])
+
+    with ThreadPoolExecutor(max_workers=len(slots)) as executor:
+        futures = [executor.submit(run_in_slot, index, params) for index, params in enumerate(plan)]
+        errors = [future.exception() for future in futures]
+
+    # keep whatever finished, even if some parameter sets failed
+    merge_csv_parts(metrics_parts, args.metrics_file)
+    merge_csv_parts(resource_parts, args.resource_file)
+    merge_csv_parts(latency_parts, args.latency_file)
+    shutil.rmtree(parts_dir, ignore_errors=True)
+    for error in errors:
+        if error is not None:
+            raise error
 
 
 if __name__ == "__main__":
@@ -0,0 +1,174 @@
+/** @file   EncryptionBenchmark.cpp
+ *  @brief  Encrypt and decrypt throughput of V2VEncryption for unicast V2I messages.
+ *
+ *  Usage: v2verifier_encryption_bench [iterations]
+ *
+ *  Prints one BENCH line per payload size, key encapsulation, payload cipher and mode. mode=per_message encapsulates
+ *  a fresh data key for the recipient in every message; mode=session encapsulates once and then names the cached
+ *  key with a pskRecipInfo. The key_schedule_per_call rows seal each payload with a context initialized from scratch
+ *  (no cached key schedule) as a baseline for the session rows.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include "../include/V2VEncryption.hpp"
+
+namespace {
+
+    /** @brief  Run `operation` `iterations` times and report the rate. */
+    bool runBenchmark(const std::string &name, size_t payloadSize, unsigned iterations,
+                      const std::function<bool()> &operation) {
+        unsigned failures = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for(unsigned i = 0; i < iterations; i++) {
+            if(!operation()) {
+                failures++;
+            }
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "BENCH op=" << name
+                  << " bytes=" << payloadSize
+                  << " ops=" << iterations
+                  << " seconds=" << seconds
+                  << " ops_per_s=" << (seconds > 0 ? iterations / seconds : 0.0)
+                  << " mb_per_s=" << (seconds > 0 ? iterations * payloadSize / seconds / 1e6 : 0.0)
+                  << " failures=" << failures
+                  << std::endl;
+        return failures == 0;
+    }
+
+    /** @brief  AES-128-CCM seal with the key schedule computed for this one message. */
+    bool sealWithFreshContext(const V2VEncryption::DataKey &key, const std::vector<uint8_t> &payload,
+                              std::vector<uint8_t> &out) {
+        uint8_t nonce[12];
+        out.resize(payload.size() + V2VEncryption::TAG_LENGTH);
+        int outLength = 0;
+        int finalLength = 0;
+        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+        bool ok = ctx != nullptr && RAND_bytes(nonce, sizeof(nonce)) == 1 &&
+                  EVP_EncryptInit_ex(ctx, EVP_aes_128_ccm(), nullptr, nullptr, nullptr) == 1 &&
+                  EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, sizeof(nonce), nullptr) == 1 &&
+                  EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, V2VEncryption::TAG_LENGTH, nullptr) == 1 &&
+                  EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), nonce) == 1 &&
+                  EVP_EncryptUpdate(ctx, nullptr, &outLength, nullptr, static_cast<int>(payload.size())) == 1 &&
+                  EVP_EncryptUpdate(ctx, out.data(), &outLength, payload.data(), static_cast<int>(payload.size())) == 1 &&
+                  EVP_EncryptFinal_ex(ctx, out.data() + outLength, &finalLength) == 1 &&
+                  EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, V2VEncryption::TAG_LENGTH,
+                                      out.data() + payload.size()) == 1;
+        EVP_CIPHER_CTX_free(ctx);
+        return ok;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    unsigned iterations = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : 2000;
+
+    V2VEncryption sender;
+    V2VEncryption receiver;
+    const std::vector<V2VEncryption::RecipientKey> recipients = {receiver.publicKey()};
+
+    const std::vector<std::pair<V2VEncryption::KeyEncapsulation, std::string>> kems = {
+        {V2VEncryption::KeyEncapsulation::eciesNistP256, "ecies"},
+        {V2VEncryption::KeyEncapsulation::mlKem768, "mlkem768"}
+    };
+    const std::vector<std::pair<V2VEncryption::PayloadCipher, std::string>> ciphers = {
+        {V2VEncryption::PayloadCipher::aes128Ccm, "ccm"},
+        {V2VEncryption::PayloadCipher::aes128Gcm, "gcm"}
+    };
+
+    bool ok = true;
+
+    // roughly a signed BSM, a map/SPaT fragment and a full-MTU V2I payload
+    for(size_t payloadSize : {100, 300, 1200}) {
+        std::vector<uint8_t> payload(payloadSize);
+        for(size_t i = 0; i < payload.size(); i++) {
+            payload[i] = static_cast<uint8_t>(i * 31 + 7);
+        }
+
+        for(const auto &kem : kems) {
+            for(const auto &cipher : ciphers) {
+                const std::string suffix = " kem=" + kem.second + " cipher=" + cipher.second;
+
+                EncryptedData message;
+                V2VEncryption::DataKey sessionKey{};
+                std::vector<uint8_t> plaintext;
+                if(!sender.encrypt(payload.data(), payload.size(), recipients, kem.first, cipher.first, message,
+                                   &sessionKey) ||
+                   !receiver.decrypt(message, plaintext) || plaintext != payload) {
+                    std::cerr << "Round trip failed for" << suffix << std::endl;
+                    return 1;
+                }
+
+                auto encryptPerMessage = [&]() {
+                    EncryptedData out;
+                    return sender.encrypt(payload.data(), payload.size(), recipients, kem.first, cipher.first, out);
+                };
+                auto encryptSession = [&]() {
+                    EncryptedData out;
+                    return sender.encryptWithKey(payload.data(), payload.size(), sessionKey, cipher.first, out);
+                };
+
+                EncryptedData perMessage;
+                EncryptedData session;
+                sender.encrypt(payload.data(), payload.size(), recipients, kem.first, cipher.first, perMessage);
+                sender.encryptWithKey(payload.data(), payload.size(), sessionKey, cipher.first, session);
+                auto perMessageCoer = perMessage.getCOER();
+                auto sessionCoer = session.getCOER();
+
+                ok = runBenchmark("encrypt mode=per_message" + suffix, payloadSize, iterations,
+                                  encryptPerMessage) && ok;
+                ok = runBenchmark("encrypt mode=session" + suffix, payloadSize, iterations, encryptSession) && ok;
+
+                // every received message is decoded from COER first, as it would be off the air
+                ok = runBenchmark("decrypt mode=per_message" + suffix, payloadSize, iterations, [&]() {
+                    EncryptedData received(perMessageCoer);
+                    std::vector<uint8_t> out;
+                    return receiver.decrypt(received, out) && out == payload;
+                }) && ok;
+                ok = runBenchmark("decrypt mode=session" + suffix, payloadSize, iterations, [&]() {
+                    EncryptedData received(sessionCoer);
+                    std::vector<uint8_t> out;
+                    return receiver.decrypt(received, out) && out == payload;
+                }) && ok;
+            }
+        }
+
+        V2VEncryption::DataKey key{};
+        RAND_bytes(key.data(), static_cast<int>(key.size()));
+        ok = runBenchmark("encrypt mode=key_schedule_per_call cipher=ccm", payloadSize, iterations, [&]() {
+            std::vector<uint8_t> out;
+            return sealWithFreshContext(key, payload, out);
+        }) && ok;
+    }
+
+    // tampering must be caught, not decrypted
+    std::vector<uint8_t> payload(100, 0x5a);
+    EncryptedData message;
+    V2VEncryption::DataKey sessionKey{};
+    sender.encrypt(payload.data(), payload.size(), recipients, V2VEncryption::KeyEncapsulation::eciesNistP256,
+                   V2VEncryption::PayloadCipher::aes128Ccm, message, &sessionKey);
+    auto coer = message.getCOER();
+    coer[coer.size() - 20] ^= std::byte{1};
+    EncryptedData tampered(coer);
+    std::vector<uint8_t> out;
+    if(receiver.decrypt(tampered, out)) {
+        std::cerr << "Tampered ciphertext decrypted" << std::endl;
+        return 1;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/** @file   FleetBenchmark.cpp
+ *  @brief  Per-tick update cost of a Fleet versus one heap-allocated object per vehicle.
+ *
+ *  Usage: v2verifier_fleet_bench [vehicles] [ticks]
+ *
+ *  Every tick moves every vehicle a little and applies the new state with range checks. The layout=objects rows
+ *  keep each vehicle in its own heap object with the same members and per-field validated setters as Vehicle (the
+ *  previous way to hold many vehicles); the layout=fleet rows apply the same updates through Fleet::applyUpdate.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include "../include/Fleet.hpp"
+
+namespace {
+
+    /** @brief  Write a fresh P-256 keypair to a temporary PEM file.
+     *
+     *  @return path of the file, which the caller removes.
+     */
+    std::string writeTemporaryKey() {
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        char path[] = "/tmp/v2v_bench_keyXXXXXX";
+        int fd = mkstemp(path);
+        FILE *fp = fd >= 0 ? fdopen(fd, "w") : nullptr;
+        if(key == nullptr || fp == nullptr || PEM_write_PrivateKey(fp, key, nullptr, nullptr, 0, nullptr, nullptr) != 1) {
+            std::cerr << "Failed to create a benchmark key" << std::endl;
+            exit(-1);
+        }
+        fclose(fp);
+        EVP_PKEY_free(key);
+        return path;
+    }
+
+    /** Same members and checks as Vehicle, without the key loading. */
+    struct ObjectVehicle {
+        VehicleLocationData locationData{};
+        VehicleMotionData motionData{};
+        V2VSecurity *securityManager = nullptr;
+        std::string keyFilepath = "../../test.pem";
+
+        int update(double latitude, double longitude, double elevation, double speed, double heading) {
+            if(!(VehicleLimits::MIN_LATITUDE <= latitude && latitude <= VehicleLimits::MAX_LATITUDE))
+                return -1;
+            if(!(VehicleLimits::MIN_LONGITUDE <= longitude && longitude <= VehicleLimits::MAX_LONGITUDE))
+                return -1;
+            if(!(VehicleLimits::MIN_ELEVATION <= elevation && elevation <= VehicleLimits::MAX_ELEVATION))
+                return -1;
+            if(!(VehicleLimits::MIN_SPEED <= speed && speed <= VehicleLimits::MAX_SPEED))
+                return -1;
+            if(!(VehicleLimits::MIN_HEADING <= heading && heading < VehicleLimits::MAX_HEADING))
+                return -1;
+            locationData = {latitude, longitude, elevation};
+            motionData = {speed, heading};
+            return 0;
+        }
+    };
+
+    /** @brief  Build the updates for one tick: small moves, with one row in ~1000 out of range. */
+    void nextTick(FleetUpdate &update, std::mt19937 &generator) {
+        std::uniform_real_distribution<double> step(-1e-4, 1e-4);
+        std::uniform_int_distribution<int> invalid(0, 999);
+        for(size_t i = 0; i < update.size(); i++) {
+            update.latitude[i] = 42.0 + step(generator);
+            update.longitude[i] = -71.0 + step(generator);
+            update.elevation[i] = 20.0 + step(generator);
+            update.speed[i] = 15.0 + step(generator);
+            update.heading[i] = invalid(generator) == 0 ? 400.0 : 90.0 + step(generator);
+        }
+    }
+
+    void report(const char *layout, size_t vehicles, unsigned ticks, double seconds, size_t applied) {
+        const double updates = static_cast<double>(vehicles) * ticks;
+        std::cout << "BENCH op=fleet_update layout=" << layout
+                  << " kernel=" << Fleet::rangeCheckKernel()
+                  << " vehicles=" << vehicles
+                  << " ticks=" << ticks
+                  << " seconds=" << seconds
+                  << " us_per_tick=" << (ticks > 0 ? seconds * 1e6 / ticks : 0.0)
+                  << " updates_per_s=" << (seconds > 0 ? updates / seconds : 0.0)
+                  << " applied=" << applied
+                  << std::endl;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t vehicles = argc > 1 ? std::stoul(argv[1]) : 100000;
+    unsigned ticks = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 100;
+
+    std::string keyPath = writeTemporaryKey();
+
+    Fleet fleet;
+    fleet.reserve(vehicles);
+    std::vector<std::unique_ptr<ObjectVehicle>> objects;
+    objects.reserve(vehicles);
+    for(size_t i = 0; i < vehicles; i++) {
+        if(fleet.addVehicle(42.0, -71.0, 20.0, 15.0, 90.0, keyPath) < 0) {
+            std::cerr << "Failed to add vehicle " << i << std::endl;
+            return 1;
+        }
+        objects.push_back(std::make_unique<ObjectVehicle>());
+        objects.back()->securityManager = &fleet.security(i);
+    }
+    unlink(keyPath.c_str());
+
+    // generate every tick up front so only the updates themselves are timed
+    std::mt19937 generator(85);
+    std::vector<FleetUpdate> updates(ticks);
+    for(auto &update : updates) {
+        update.latitude.resize(vehicles);
+        update.longitude.resize(vehicles);
+        update.elevation.resize(vehicles);
+        update.speed.resize(vehicles);
+        update.heading.resize(vehicles);
+        nextTick(update, generator);
+    }
+
+    size_t applied = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(const auto &update : updates) {
+        for(size_t i = 0; i < vehicles; i++) {
+            if(objects[i]->update(update.latitude[i], update.longitude[i], update.elevation[i], update.speed[i],
+                                  update.heading[i]) == 0) {
+                applied++;
+            }
+        }
+    }
+    report("objects", vehicles, ticks, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+           applied);
+
+    applied = 0;
+    start = std::chrono::steady_clock::now();
+    for(const auto &update : updates) {
+        applied += fleet.applyUpdate(update);
+    }
+    report("fleet", vehicles, ticks, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+           applied);
+
+    return 0;
+}
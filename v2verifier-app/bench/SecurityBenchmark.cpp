@@ -0,0 +1,142 @@
+/** @file   SecurityBenchmark.cpp
+ *  @brief  Signing and verification throughput of V2VSecurity for 1 to N threads.
+ *
+ *  Usage: v2verifier_security_bench [maxThreads] [iterationsPerThread]
+ *
+ *  Prints one BENCH line per operation and thread count. The verify_init_per_call rows re-initialize the digest
+ *  context for every message (the previous V2VSecurity behaviour) as a baseline for the cached contexts.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include "../include/V2VSecurity.hpp"
+
+namespace {
+
+    /** @brief  Write a fresh P-256 keypair to a temporary PEM file.
+     *
+     *  @return path of the file, which the caller removes.
+     */
+    std::string writeTemporaryKey() {
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        char path[] = "/tmp/v2v_bench_keyXXXXXX";
+        int fd = mkstemp(path);
+        FILE *fp = fd >= 0 ? fdopen(fd, "w") : nullptr;
+        if(key == nullptr || fp == nullptr || PEM_write_PrivateKey(fp, key, nullptr, nullptr, 0, nullptr, nullptr) != 1) {
+            std::cerr << "Failed to create a benchmark key" << std::endl;
+            exit(-1);
+        }
+        fclose(fp);
+        EVP_PKEY_free(key);
+        return path;
+    }
+
+    /** @brief  Run `operation` `iterations` times on each of `threads` threads and report the aggregate rate. */
+    bool runBenchmark(const std::string &name, unsigned threads, unsigned iterations,
+                      const std::function<bool()> &operation) {
+        std::atomic<unsigned> failures{0};
+        std::vector<std::thread> workers;
+        const auto start = std::chrono::steady_clock::now();
+        for(unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&]() {
+                for(unsigned i = 0; i < iterations; i++) {
+                    if(!operation()) {
+                        failures++;
+                    }
+                }
+            });
+        }
+        for(auto &worker : workers) {
+            worker.join();
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double ops = static_cast<double>(threads) * iterations;
+
+        std::cout << "BENCH op=" << name
+                  << " threads=" << threads
+                  << " ops=" << static_cast<unsigned long long>(ops)
+                  << " seconds=" << seconds
+                  << " ops_per_s=" << (seconds > 0 ? ops / seconds : 0.0)
+                  << " failures=" << failures.load()
+                  << std::endl;
+        return failures == 0;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+
+    unsigned maxThreads = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1]))
+                                   : std::max(1u, std::thread::hardware_concurrency());
+    unsigned iterations = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 2000;
+
+    std::string keyPath = writeTemporaryKey();
+    V2VSecurity security(keyPath);
+    unlink(keyPath.c_str());
+
+    std::vector<uint8_t> message(256);
+    for(size_t i = 0; i < message.size(); i++) {
+        message[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+
+    std::vector<unsigned char> signature(security.maxSignatureLength());
+    size_t signatureLength = 0;
+    if(!security.sign(message.data(), message.size(), signature.data(), signature.size(), signatureLength) ||
+       !security.verify(message.data(), message.size(), security.pkey, signature.data(), signatureLength)) {
+        std::cerr << "Sign/verify round trip failed" << std::endl;
+        return 1;
+    }
+    message[0] ^= 1;
+    if(security.verify(message.data(), message.size(), security.pkey, signature.data(), signatureLength)) {
+        std::cerr << "Tampered message verified" << std::endl;
+        return 1;
+    }
+    message[0] ^= 1;
+
+    std::vector<unsigned> threadCounts;
+    for(unsigned t = 1; t < maxThreads; t *= 2) {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    bool ok = true;
+    for(unsigned threads : threadCounts) {
+        ok = runBenchmark("sign", threads, iterations, [&]() {
+            unsigned char localSignature[128];
+            size_t localLength = 0;
+            return security.sign(message.data(), message.size(), localSignature, sizeof(localSignature), localLength);
+        }) && ok;
+
+        ok = runBenchmark("verify", threads, iterations, [&]() {
+            return security.verify(message.data(), message.size(), security.pkey, signature.data(), signatureLength);
+        }) && ok;
+
+        ok = runBenchmark("verify_init_per_call", threads, iterations, [&]() {
+            EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+            bool valid = EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, security.pkey) == 1 &&
+                         EVP_DigestVerifyUpdate(ctx, message.data(), message.size()) == 1 &&
+                         EVP_DigestVerifyFinal(ctx, signature.data(), signatureLength) == 1;
+            EVP_MD_CTX_free(ctx);
+            return valid;
+        }) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/** @file   Fleet.hpp
+ *  @brief  Structure-of-arrays store for the state of many vehicles.
+ *
+ *  Where a Vehicle object holds the state of one vehicle, a Fleet holds each field of every vehicle in its own
+ *  contiguous column, so a tick that updates the whole fleet streams through memory instead of chasing one object
+ *  per vehicle. Vehicles that use the same key file share one V2VSecurity, which is safe to use from several
+ *  threads at once.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs
+*/
+
+#ifndef V2VERIFIER_FLEET_HPP
+#define V2VERIFIER_FLEET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Vehicle.hpp"
+#include "V2VSecurity.hpp"
+
+/** @brief  A batch of state updates for a Fleet, one row per vehicle, in the same column layout as the Fleet. */
+typedef struct FleetUpdate {
+    std::vector<uint32_t> vehicles;     ///< fleet index of each row; empty means row i updates vehicle i
+    std::vector<double> latitude;
+    std::vector<double> longitude;
+    std::vector<double> elevation;
+    std::vector<double> speed;
+    std::vector<double> heading;
+
+    /** @brief  Number of rows in the batch. */
+    [[nodiscard]] size_t size() const {
+        return latitude.size();
+    }
+} FleetUpdate;
+
+class Fleet {
+
+public:
+    /** @brief Create an empty fleet. */
+    Fleet() = default;
+
+    /** @brief  Not copyable: owns the security contexts its vehicles refer to. */
+    Fleet(const Fleet &) = delete;
+    Fleet &operator=(const Fleet &) = delete;
+
+    /** @brief  Reserve room for `count` vehicles in every column.
+     *
+     *  @param  count   Expected number of vehicles.
+     */
+    void reserve(size_t count);
+
+    /** @brief  Add a vehicle with the provided location and motion information.
+     *
+     *  @param  latitude    the vehicle latitude
+     *  @param  longitude   the vehicle longitude
+     *  @param  elevation   the vehicle elevation
+     *  @param  speed       the vehicle speed
+     *  @param  heading     the vehicle heading
+     *  @param  keyFilename PEM key of the vehicle; each distinct file is loaded once.
+     *  @return             the fleet index of the new vehicle, or -1 if any value is out of range
+     */
+    long addVehicle(double latitude, double longitude, double elevation, double speed, double heading,
+                    const std::string &keyFilename);
+
+    /** @brief  Validate and apply a batch of updates.
+     *
+     *  Rows with any value out of range, or with an unknown vehicle index, are skipped and reported in a single log
+     *  entry. When the rows are in vehicle order (update.vehicles empty), checking and copying is one pass over the
+     *  columns, four rows at a time with AVX2 where the CPU has it.
+     *
+     *  @param  update  The rows to apply. Every column must have update.size() entries.
+     *  @return         the number of rows applied
+     */
+    size_t applyUpdate(const FleetUpdate &update);
+
+    /** @brief  Number of vehicles in the fleet. */
+    [[nodiscard]] size_t size() const {
+        return latitude.size();
+    }
+
+    /** @brief  Location of one vehicle. */
+    [[nodiscard]] VehicleLocationData location(size_t vehicle) const;
+
+    /** @brief  Motion of one vehicle. */
+    [[nodiscard]] VehicleMotionData motion(size_t vehicle) const;
+
+    /** @brief  Security context of one vehicle, shared with every vehicle using the same key file. */
+    [[nodiscard]] V2VSecurity &security(size_t vehicle) const;
+
+    /** @brief  The latitude column (size() entries); the other columns have matching accessors. */
+    [[nodiscard]] const double *latitudes() const { return latitude.data(); }
+    [[nodiscard]] const double *longitudes() const { return longitude.data(); }
+    [[nodiscard]] const double *elevations() const { return elevation.data(); }
+    [[nodiscard]] const double *speeds() const { return speed.data(); }
+    [[nodiscard]] const double *headings() const { return heading.data(); }
+
+    /** @brief  Name of the range-check implementation selected for this CPU ("avx2" or "portable"). */
+    static const char *rangeCheckKernel();
+
+private:
+    std::vector<double> latitude;
+    std::vector<double> longitude;
+    std::vector<double> elevation;
+    std::vector<double> speed;
+    std::vector<double> heading;
+    std::vector<uint32_t> keyHandle;    ///< index into keys
+
+    std::vector<std::unique_ptr<V2VSecurity>> keys;
+    std::unordered_map<std::string, uint32_t> keyHandles;  ///< key filename -> index into keys
+
+    /** @brief  Handle of the security context for a key file, loading the file the first time.
+     *
+     *  @param  keyFilename Path to the PEM key.
+     *  @return             index into keys
+     */
+    uint32_t keyHandleFor(const std::string &keyFilename);
+};
+
+#endif //V2VERIFIER_FLEET_HPP
@@ -0,0 +1,184 @@
+/** @file   V2VEncryption.hpp
+ *  @brief  Generation and parsing of IEEE 1609.2 EncryptedData for unicast messages.
+ *
+ *  The payload is encrypted once with a fresh 128-bit data key (AES-128-CCM, or AES-128-GCM as a local extension),
+ *  and the data key is encapsulated separately for each recipient with ECIES over P-256 or with ML-KEM-768 (also
+ *  a local extension). Once a data key is known to both ends, later messages can name it with a pskRecipInfo and
+ *  skip encapsulation altogether.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+#ifndef V2VERIFIER_V2VENCRYPTION_HPP
+#define V2VERIFIER_V2VENCRYPTION_HPP
+
+#include <openssl/evp.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../../v2xmessage/include/EncryptedData.hpp"
+
+class V2VEncryption {
+
+public:
+
+    /** @brief How the data key is encapsulated for each recipient. */
+    enum class KeyEncapsulation {
+        eciesNistP256,  ///< ECIES over P-256 as specified in IEEE 1609.2
+        mlKem768        ///< ML-KEM-768 shared secret run through the same KDF and key wrap
+    };
+
+    /** @brief Symmetric algorithm for the payload. */
+    enum class PayloadCipher {
+        aes128Ccm,      ///< AES-128-CCM as specified in IEEE 1609.2
+        aes128Gcm       ///< AES-128-GCM
+    };
+
+    /** @brief  A 128-bit data encryption key. */
+    using DataKey = std::array<uint8_t, 16>;
+
+    /** @brief  Everything a sender needs to encapsulate a data key for one recipient. */
+    struct RecipientKey {
+        std::vector<std::byte> recipientId;     ///< HashedId8 of the recipient's ECIES public key
+        EVP_PKEY *eciesPublicKey = nullptr;     ///< owned by the recipient's V2VEncryption
+        std::vector<uint8_t> mlKemPublicKey;
+    };
+
+    /** @brief  Length of the authentication tag appended to every ciphertext. */
+    static const size_t TAG_LENGTH = 16;
+
+    /** @brief  Create a new module with freshly generated ECIES and ML-KEM-768 keypairs.
+     *
+     *  @param  keyCacheCapacity    How many data keys to keep initialized cipher contexts for.
+     */
+    explicit V2VEncryption(size_t keyCacheCapacity = 1024);
+
+    /** @brief Destructor */
+    ~V2VEncryption();
+
+    /** @brief  Not copyable: owns OpenSSL keys and contexts. */
+    V2VEncryption(const V2VEncryption &) = delete;
+    V2VEncryption &operator=(const V2VEncryption &) = delete;
+
+    /** @brief  Get the public keys other modules use to encrypt to this one.
+     *
+     *  @return The recipient key for this module; valid for the lifetime of this object.
+     */
+    RecipientKey publicKey() const;
+
+    /** @brief  Encrypt a payload under a fresh data key encapsulated for every recipient.
+     *
+     *  @param  payload     Pointer to the data to be encrypted.
+     *  @param  length      Number of bytes to encrypt.
+     *  @param  recipients  Recipients that can recover the data key.
+     *  @param  kem         How the data key is encapsulated.
+     *  @param  cipher      How the payload is encrypted.
+     *  @param  out         Receives the EncryptedData.
+     *  @param  dataKey     If not null, receives the data key so later messages can use encryptWithKey().
+     *  @return             True on success, false if a cryptographic operation failed.
+     */
+    bool encrypt(const uint8_t *payload, size_t length, const std::vector<RecipientKey> &recipients,
+                 KeyEncapsulation kem, PayloadCipher cipher, EncryptedData &out, DataKey *dataKey = nullptr);
+
+    /** @brief  Encrypt a payload under a data key the recipients already hold, naming it with a pskRecipInfo.
+     *
+     *  The cipher contexts for the key are initialized once and cached, so no key schedule is computed per message.
+     *
+     *  @param  payload     Pointer to the data to be encrypted.
+     *  @param  length      Number of bytes to encrypt.
+     *  @param  dataKey     The data key, typically from an earlier encrypt().
+     *  @param  cipher      How the payload is encrypted.
+     *  @param  out         Receives the EncryptedData.
+     *  @return             True on success, false if a cryptographic operation failed.
+     */
+    bool encryptWithKey(const uint8_t *payload, size_t length, const DataKey &dataKey, PayloadCipher cipher,
+                        EncryptedData &out);
+
+    /** @brief  Decrypt an EncryptedData addressed to this module.
+     *
+     *  Recipients naming a cached data key are tried first; otherwise the data key is unwrapped from the entry for
+     *  this module's public key and cached, so a later pskRecipInfo for the same key succeeds. Safe to call from
+     *  several threads at once.
+     *
+     *  @param  data        The EncryptedData to decrypt.
+     *  @param  plaintext   Receives the payload.
+     *  @return             True on success, false if no usable recipient was found or authentication failed.
+     */
+    bool decrypt(const EncryptedData &data, std::vector<uint8_t> &plaintext);
+
+    /** @brief  Get the HashedId8 naming a data key in a pskRecipInfo.
+     *
+     *  @param  dataKey The data key.
+     *  @return The low-order 8 bytes of SHA-256 over the COER encoding of the aes128Ccm SymmetricEncryptionKey.
+     */
+    static std::vector<std::byte> keyId(const DataKey &dataKey);
+
+private:
+
+    /** A data key with cipher contexts initialized once for it, created on first use per cipher and direction
+     *  and only ever copied from after that. */
+    struct CachedKey {
+        DataKey key{};
+        mutable std::atomic<EVP_CIPHER_CTX *> templates[2][2] = {};    ///< [PayloadCipher][encrypt]
+
+        explicit CachedKey(const DataKey &key) : key(key) {}
+        ~CachedKey();
+
+        /** @brief  Get the initialized context for a cipher and direction, or nullptr on error. */
+        const EVP_CIPHER_CTX *templateFor(PayloadCipher cipher, bool encrypt) const;
+    };
+
+    EVP_PKEY *eciesKey = nullptr;
+    std::vector<uint8_t> mlKemPublicKey;
+    std::vector<uint8_t> mlKemSecretKey;
+    std::vector<std::byte> ownId;
+
+    /** Data keys with initialized contexts, keyed by keyId(), evicted oldest first. */
+    size_t keyCacheCapacity;
+    std::unordered_map<uint64_t, std::shared_ptr<const CachedKey>> keyCache;
+    std::deque<uint64_t> keyCacheOrder;
+    std::shared_mutex keyCacheMutex;
+
+    /** @brief  Find or create the cached contexts for a data key.
+     *
+     *  @param  dataKey     The data key.
+     *  @param  dataKeyId   keyId() of the data key.
+     *  @return The cache entry, which stays valid for the caller even if it is evicted meanwhile.
+     */
+    std::shared_ptr<const CachedKey> cachedKeyFor(const DataKey &dataKey, const std::vector<std::byte> &dataKeyId);
+
+    /** @brief  Look up a data key by the HashedId8 from a pskRecipInfo.
+     *
+     *  @param  id  The HashedId8.
+     *  @return The cached contexts, or nullptr if the key is not cached.
+     */
+    std::shared_ptr<const CachedKey> findCachedKey(const std::vector<std::byte> &id);
+
+    /** @brief  Encrypt the payload with cached contexts into a SymmetricCiphertext. */
+    static bool seal(const CachedKey &cachedKey, PayloadCipher cipher, const uint8_t *payload, size_t length,
+                     SymmetricCiphertext &out);
+
+    /** @brief  Decrypt and authenticate a SymmetricCiphertext with cached contexts. */
+    static bool open(const CachedKey &cachedKey, const SymmetricCiphertext &ciphertext,
+                     std::vector<uint8_t> &plaintext);
+
+    /** @brief  Encapsulate a data key for one recipient. */
+    static bool wrapKey(const DataKey &dataKey, const RecipientKey &recipient, KeyEncapsulation kem,
+                        EncryptedDataEncryptionKey &out);
+
+    /** @brief  Recover a data key encapsulated for this module. */
+    bool unwrapKey(const EncryptedDataEncryptionKey &encKey, DataKey &dataKey) const;
+
+};
+
+#endif //V2VERIFIER_V2VENCRYPTION_HPP
@@ -10,8 +10,12 @@
 #define V2VERIFIER_V2VSECURITY_HPP
 
 #include <openssl/evp.h>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <fstream>
+#include <shared_mutex>
+#include <unordered_map>
 
 class V2VSecurity {
 
@@ -30,7 +34,67 @@ public:
     /** @brief Destructor */
     ~V2VSecurity();
 
-    /** @brief  Sign arbitrary data with ECDSA P.256. Allocates new memory on the heap to store the `sig` value.
+    /** @brief  Not copyable: owns OpenSSL contexts. */
+    V2VSecurity(const V2VSecurity &) = delete;
+    V2VSecurity &operator=(const V2VSecurity &) = delete;
+
+    /** @brief  Sign `length` bytes of arbitrary data with ECDSA P.256 into a caller-provided buffer.
+     *
+     *  Safe to call from several threads at once. Each call copies a signing context that was initialized once
+     *  with the key into a per-thread working context, so no key setup or allocation happens per message.
+     *
+     *  @param  msg         Pointer to the message data to be signed.
+     *  @param  length      Number of bytes to sign.
+     *  @param  sig         Buffer that receives the DER-encoded signature.
+     *  @param  sigCapacity Size of `sig`; maxSignatureLength() bytes is always enough.
+     *  @param  sig_len     Length of the generated signature.
+     *  @return             True if the signature is successfully generated, false if errors are encountered.
+     */
+    bool sign(const uint8_t *msg, size_t length, unsigned char *sig, size_t sigCapacity, size_t &sig_len);
+
+    /** @brief  Verify an ECDSA P.256 signature over `length` bytes of data.
+     *
+     *  Safe to call from several threads at once. A verification context is initialized once per public key and
+     *  cached for the lifetime of this object (holding a reference to the key); each call copies it into a
+     *  per-thread working context.
+     *
+     *  @param msg          Pointer to the message data to be verified.
+     *  @param length       Number of bytes covered by the signature.
+     *  @param publicKey    Public key to be used for verification.
+     *  @param signature    Pointer to the ECDSA signature to be verified.
+     *  @param sig_len      Length of the signature to be verified.
+     *  @return             True on successful verification, false on error or verification failure.
+     */
+    bool verify(const uint8_t *msg, size_t length, EVP_PKEY *publicKey, const unsigned char *signature,
+                size_t sig_len);
+
+    /** @brief  Upper bound on the length of signatures produced by sign(). */
+    size_t maxSignatureLength() const;
+
+    /** @brief  Length of a signature in the r || s form carried by an IEEE 1609.2 EcdsaP256Signature. */
+    static const size_t RAW_SIGNATURE_LENGTH = 64;
+
+    /** @brief  Sign like sign(), but output the signature as 32-byte r followed by 32-byte s instead of DER.
+     *
+     *  @param  msg     Pointer to the message data to be signed.
+     *  @param  length  Number of bytes to sign.
+     *  @param  rs      Buffer of RAW_SIGNATURE_LENGTH bytes that receives r || s.
+     *  @return         True if the signature is successfully generated, false if errors are encountered.
+     */
+    bool signRaw(const uint8_t *msg, size_t length, uint8_t *rs);
+
+    /** @brief  Verify like verify(), but take the signature as 32-byte r followed by 32-byte s.
+     *
+     *  @param msg          Pointer to the message data to be verified.
+     *  @param length       Number of bytes covered by the signature.
+     *  @param publicKey    Public key to be used for verification.
+     *  @param rs           RAW_SIGNATURE_LENGTH bytes holding r || s.
+     *  @return             True on successful verification, false on error or verification failure.
+     */
+    bool verifyRaw(const uint8_t *msg, size_t length, EVP_PKEY *publicKey, const uint8_t *rs);
+
+    /** @brief  Sign a NUL-terminated string with ECDSA P.256. Allocates new memory on the heap (new[]) to store
+     *          the `sig` value. Prefer sign(), which also handles binary data.
      *
      *  @param  msg     Pointer to the raw message data to be signed.
      *  @param  sig     Pointer to be used to store the signature.
@@ -39,7 +103,8 @@ public:
      */
     bool signMessage(char* msg, unsigned char* &sig, size_t &sig_len);
 
-    /** @brief  Verify ECDSA P.256 signature.
+    /** @brief  Verify ECDSA P.256 signature over a NUL-terminated string. Prefer verify(), which also handles
+     *          binary data.
      *
      *  @param msg          Pointer to the raw message data to be verified.
      *  @param publicKey    Pointer to the public key to be used for verification.
@@ -55,8 +120,19 @@ private:
 
     std::ifstream pemfile;
 
+    /** Initialized once with the private key; only ever copied from after setup(). */
     EVP_MD_CTX *mdctx_sign = nullptr;
-    EVP_MD_CTX *mdctx_verify = nullptr;
+
+    /** Verification contexts already initialized for a public key, keyed by the key. */
+    std::unordered_map<const EVP_PKEY *, EVP_MD_CTX *> verifyTemplates;
+    std::shared_mutex verifyTemplatesMutex;
+
+    /** @brief  Find or create the initialized verification context for a public key.
+     *
+     *  @param  publicKey   Key the context is for.
+     *  @return             Context to copy from, or nullptr if it could not be initialized.
+     */
+    const EVP_MD_CTX *verifyTemplateFor(EVP_PKEY *publicKey);
 
     /** @brief  Load a public/private keypair from a provided filepath.
      *
@@ -10,9 +10,29 @@
 #define V2VERIFIER_VEHICLE_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "../include/V2VSecurity.hpp"
+#include "../../v2xmessage/include/J2735BSM.hpp"
+
+/** @brief Plausible ranges for vehicle state; updates outside them are rejected. */
+namespace VehicleLimits {
+    constexpr double MIN_LATITUDE = -90;
+    constexpr double MAX_LATITUDE = 90;
+    constexpr double MIN_LONGITUDE = -180;
+    constexpr double MAX_LONGITUDE = 180;
+    // The lowest elevation for a road is roughly -500m (near the Dead Sea)
+    // The highest elevation for a road is roughly 5800m (near Ladakh, India)
+    constexpr double MIN_ELEVATION = -600;
+    constexpr double MAX_ELEVATION = 6000;
+    // speed should never be less than zero
+    // we do not expect a vehicle to exceed 110 m/s (250 mph)
+    constexpr double MIN_SPEED = 0;
+    constexpr double MAX_SPEED = 110;
+    constexpr double MIN_HEADING = 0;
+    constexpr double MAX_HEADING = 360;     ///< exclusive
+}
 
 /** @brief Representation of vehicle position/location data to be kept updated and retrieved as needed.*/
 typedef struct VehicleLocationData {
@@ -27,6 +47,12 @@ typedef struct VehicleMotionData {
     double heading;
 } VehicleMotionData;
 
+/** @brief Settings for the transmit/receive workloads (the same knobs falcon_sim exposes). */
+typedef struct PipelineOptions {
+    uint16_t port = 6666;           ///< UDP port the receiver listens on and the transmitter sends to
+    long intervalUs = 100000;       ///< delay between transmitted messages, in microseconds
+    uint32_t vehicleId = 0;         ///< TemporaryID placed in transmitted BSMs
+} PipelineOptions;
 
 class Vehicle {
 
@@ -56,6 +82,36 @@ public:
      */
     Vehicle(double latitude, double longitude, double elevation, std::string &keyFilename);
 
+    /** @brief  Generate a COER-encoded, self-signed IEEE 1609.2 SPDU carrying a BSM for the current vehicle state.
+     *
+     *  @param  msgCount    Message count placed in the BSM.
+     *  @param  vehicleId   TemporaryID placed in the BSM.
+     *  @return             The COER encoding of the SPDU (an Ieee1609Dot2Data).
+     */
+    std::vector<std::byte> generateSignedBSM(uint8_t msgCount, uint32_t vehicleId);
+
+    /** @brief  Decode a COER-encoded SPDU and verify its signature.
+     *
+     *  @param  coerBytes   The received SPDU.
+     *  @param  bsm         Receives the BSM carried by the SPDU if it could be decoded.
+     *  @return             True if the SPDU decoded and its signature is valid, false otherwise.
+     */
+    bool verifySignedBSM(const std::vector<std::byte> &coerBytes, J2735BSM &bsm);
+
+    /** @brief  Send `numMessages` signed BSM SPDUs over UDP, one every `options.intervalUs`.
+     *
+     *  @param  numMessages Number of SPDUs to send.
+     *  @param  options     Port, interval and identity to use.
+     */
+    void transmit(int numMessages, const PipelineOptions &options);
+
+    /** @brief  Receive and verify `numMessages` SPDUs over UDP, then report METRIC timing like falcon_sim.
+     *
+     *  @param  numMessages Number of SPDUs to wait for.
+     *  @param  options     Port to listen on.
+     */
+    void receive(int numMessages, const PipelineOptions &options);
+
 private:
 
     VehicleLocationData locationData;
@@ -131,22 +187,6 @@ private:
      */
     int updateHeading(double heading);
 
-    /** @brief Format an error string for an invalid double value provided as a location or motion field.
-     *
-     *  @param field name of the field that was to be set
-     *  @param invalidValue the invalid value
-     *  @return formatted string error message
-     */
-    static std::string formatErrorForInvalidValue(std::string &field, double invalidValue);
-
-    /** @brief Format an error string for an invalid integer value provided as a location or motion field.
-     *
-     *  @param field name of the field that was to be set
-     *  @param invalidValue the invalid value
-     *  @return formatted string error message
-     */
-    static std::string formatErrorForInvalidValue(std::string &field, int invalidValue);
-
 
 
 };
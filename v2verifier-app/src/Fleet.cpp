@@ -0,0 +1,238 @@
+/** @file   Fleet.cpp
+ *  @brief  Implementation of Fleet class.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include <stdexcept>
+
+#include "../../logger/BinaryLog.h"
+#include "../../logger/Log.h"
+#include "../include/Fleet.hpp"
+
+namespace {
+
+    /** @brief  Whether one vehicle state is within VehicleLimits (NaN never is). */
+    bool inRange(double latitude, double longitude, double elevation, double speed, double heading) {
+        return VehicleLimits::MIN_LATITUDE <= latitude && latitude <= VehicleLimits::MAX_LATITUDE &&
+               VehicleLimits::MIN_LONGITUDE <= longitude && longitude <= VehicleLimits::MAX_LONGITUDE &&
+               VehicleLimits::MIN_ELEVATION <= elevation && elevation <= VehicleLimits::MAX_ELEVATION &&
+               VehicleLimits::MIN_SPEED <= speed && speed <= VehicleLimits::MAX_SPEED &&
+               VehicleLimits::MIN_HEADING <= heading && heading < VehicleLimits::MAX_HEADING;
+    }
+
+    /** Copy row i of the five input columns (latitude, longitude, elevation, speed, heading) to row i of the output
+     *  columns for every row that is in range. Returns the number of rows copied; firstRejected is set to the first
+     *  row skipped if it is still negative. */
+    typedef size_t (*ApplyRows)(const double *const *in, double *const *out, size_t count, long &firstRejected);
+
+    size_t applyRowsPortable(const double *const *in, double *const *out, size_t count, long &firstRejected) {
+        size_t applied = 0;
+        for(size_t i = 0; i < count; i++) {
+            if(!inRange(in[0][i], in[1][i], in[2][i], in[3][i], in[4][i])) {
+                if(firstRejected < 0) {
+                    firstRejected = static_cast<long>(i);
+                }
+                continue;
+            }
+            for(int column = 0; column < 5; column++) {
+                out[column][i] = in[column][i];
+            }
+            applied++;
+        }
+        return applied;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    __m256d inRangeAvx2(__m256d value, double low, double high) {
+        return _mm256_and_pd(_mm256_cmp_pd(value, _mm256_set1_pd(low), _CMP_GE_OQ),
+                             _mm256_cmp_pd(value, _mm256_set1_pd(high), _CMP_LE_OQ));
+    }
+
+    /** Four rows per step: all five columns are checked and written in a single pass over the input. */
+    __attribute__((target("avx2")))
+    size_t applyRowsAvx2(const double *const *in, double *const *out, size_t count, long &firstRejected) {
+        size_t applied = 0;
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4) {
+            __m256d values[5];
+            for(int column = 0; column < 5; column++) {
+                values[column] = _mm256_loadu_pd(in[column] + i);
+            }
+
+            __m256d valid = inRangeAvx2(values[0], VehicleLimits::MIN_LATITUDE, VehicleLimits::MAX_LATITUDE);
+            valid = _mm256_and_pd(valid, inRangeAvx2(values[1], VehicleLimits::MIN_LONGITUDE,
+                                                     VehicleLimits::MAX_LONGITUDE));
+            valid = _mm256_and_pd(valid, inRangeAvx2(values[2], VehicleLimits::MIN_ELEVATION,
+                                                     VehicleLimits::MAX_ELEVATION));
+            valid = _mm256_and_pd(valid, inRangeAvx2(values[3], VehicleLimits::MIN_SPEED, VehicleLimits::MAX_SPEED));
+            // heading excludes its upper bound
+            valid = _mm256_and_pd(valid, _mm256_and_pd(
+                    _mm256_cmp_pd(values[4], _mm256_set1_pd(VehicleLimits::MIN_HEADING), _CMP_GE_OQ),
+                    _mm256_cmp_pd(values[4], _mm256_set1_pd(VehicleLimits::MAX_HEADING), _CMP_LT_OQ)));
+
+            const int mask = _mm256_movemask_pd(valid);
+            if(mask == 0xF) {
+                for(int column = 0; column < 5; column++) {
+                    _mm256_storeu_pd(out[column] + i, values[column]);
+                }
+                applied += 4;
+                continue;
+            }
+
+            for(int column = 0; column < 5; column++) {
+                _mm256_storeu_pd(out[column] + i,
+                                 _mm256_blendv_pd(_mm256_loadu_pd(out[column] + i), values[column], valid));
+            }
+            applied += static_cast<size_t>(__builtin_popcount(mask));
+            if(firstRejected < 0) {
+                firstRejected = static_cast<long>(i) + __builtin_ctz(~mask & 0xF);
+            }
+        }
+
+        const double *tailIn[5];
+        double *tailOut[5];
+        for(int column = 0; column < 5; column++) {
+            tailIn[column] = in[column] + i;
+            tailOut[column] = out[column] + i;
+        }
+        long tailRejected = -1;
+        applied += applyRowsPortable(tailIn, tailOut, count - i, tailRejected);
+        if(firstRejected < 0 && tailRejected >= 0) {
+            firstRejected = static_cast<long>(i) + tailRejected;
+        }
+        return applied;
+    }
+#endif
+
+    struct ApplyRowsKernel {
+        ApplyRows apply;
+        const char *name;
+    };
+
+    const ApplyRowsKernel &applyRows() {
+        static const ApplyRowsKernel kernel = []() -> ApplyRowsKernel {
+#if defined(__x86_64__) || defined(__i386__)
+            if(__builtin_cpu_supports("avx2")) {
+                return {applyRowsAvx2, "avx2"};
+            }
+#endif
+            return {applyRowsPortable, "portable"};
+        }();
+        return kernel;
+    }
+
+}
+
+void Fleet::reserve(size_t count) {
+    this->latitude.reserve(count);
+    this->longitude.reserve(count);
+    this->elevation.reserve(count);
+    this->speed.reserve(count);
+    this->heading.reserve(count);
+    this->keyHandle.reserve(count);
+}
+
+long Fleet::addVehicle(double latitude, double longitude, double elevation, double speed, double heading,
+                       const std::string &keyFilename) {
+
+    if(!inRange(latitude, longitude, elevation, speed, heading)) {
+        BINLOG_WARNING("Failed to add vehicle to fleet (invalid state: {}, {}, {}, {}, {})",
+                       latitude, longitude, elevation, speed, heading);
+        return -1;
+    }
+
+    const uint32_t handle = keyHandleFor(keyFilename);
+
+    this->latitude.push_back(latitude);
+    this->longitude.push_back(longitude);
+    this->elevation.push_back(elevation);
+    this->speed.push_back(speed);
+    this->heading.push_back(heading);
+    this->keyHandle.push_back(handle);
+
+    return static_cast<long>(this->latitude.size() - 1);
+}
+
+uint32_t Fleet::keyHandleFor(const std::string &keyFilename) {
+    auto it = this->keyHandles.find(keyFilename);
+    if(it != this->keyHandles.end()) {
+        return it->second;
+    }
+
+    std::string filename = keyFilename;
+    this->keys.push_back(std::make_unique<V2VSecurity>(filename));
+    const auto handle = static_cast<uint32_t>(this->keys.size() - 1);
+    this->keyHandles.emplace(keyFilename, handle);
+    return handle;
+}
+
+size_t Fleet::applyUpdate(const FleetUpdate &update) {
+
+    const size_t rows = update.size();
+    if(update.longitude.size() != rows || update.elevation.size() != rows || update.speed.size() != rows ||
+       update.heading.size() != rows || (!update.vehicles.empty() && update.vehicles.size() != rows)) {
+        throw std::invalid_argument("FleetUpdate columns have different lengths");
+    }
+
+    const size_t vehicles = size();
+    size_t applied = 0;
+    long firstRejected = -1;
+
+    if(update.vehicles.empty() && rows <= vehicles) {
+        // rows map onto the first vehicles in order: check and copy all columns in one vectorized pass
+        const double *in[5] = {update.latitude.data(), update.longitude.data(), update.elevation.data(),
+                               update.speed.data(), update.heading.data()};
+        double *out[5] = {this->latitude.data(), this->longitude.data(), this->elevation.data(),
+                          this->speed.data(), this->heading.data()};
+        applied = applyRows().apply(in, out, rows, firstRejected);
+    }
+    else {
+        for(size_t row = 0; row < rows; row++) {
+            const size_t vehicle = update.vehicles.empty() ? row : update.vehicles[row];
+            if(vehicle >= vehicles || !inRange(update.latitude[row], update.longitude[row], update.elevation[row],
+                                               update.speed[row], update.heading[row])) {
+                if(firstRejected < 0) {
+                    firstRejected = static_cast<long>(vehicle);
+                }
+                continue;
+            }
+            this->latitude[vehicle] = update.latitude[row];
+            this->longitude[vehicle] = update.longitude[row];
+            this->elevation[vehicle] = update.elevation[row];
+            this->speed[vehicle] = update.speed[row];
+            this->heading[vehicle] = update.heading[row];
+            applied++;
+        }
+    }
+
+    if(applied != rows) {
+        BINLOG_WARNING("Rejected {} of {} fleet updates (first rejected vehicle: {})",
+                       rows - applied, rows, firstRejected);
+    }
+
+    return applied;
+}
+
+VehicleLocationData Fleet::location(size_t vehicle) const {
+    return VehicleLocationData{this->latitude.at(vehicle), this->longitude.at(vehicle), this->elevation.at(vehicle)};
+}
+
+VehicleMotionData Fleet::motion(size_t vehicle) const {
+    return VehicleMotionData{this->speed.at(vehicle), this->heading.at(vehicle)};
+}
+
+V2VSecurity &Fleet::security(size_t vehicle) const {
+    return *this->keys[this->keyHandle.at(vehicle)];
+}
+
+const char *Fleet::rangeCheckKernel() {
+    return applyRows().name;
+}
@@ -0,0 +1,515 @@
+/** @file   V2VEncryption.cpp
+ *  @brief  Generation and parsing of IEEE 1609.2 EncryptedData for unicast messages.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <oqs/oqs.h>
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include "../include/V2VEncryption.hpp"
+
+namespace {
+
+    const size_t NONCE_LENGTH = SymmetricCiphertext::NONCE_SIZE_BYTES;
+    const size_t WRAP_LENGTH = EncryptedDataEncryptionKey::WRAPPED_KEY_SIZE_BYTES;
+    const size_t COMPRESSED_POINT_LENGTH = EccP256CurvePoint::ECC_P256_CURVE_POINT_SIZE_BYTES;
+
+    struct CipherCtxDeleter {
+        void operator()(EVP_CIPHER_CTX *ctx) const { EVP_CIPHER_CTX_free(ctx); }
+    };
+
+    /** Per-thread working context. Every seal/open overwrites it with a copy of an initialized template, so one
+     *  context per thread serves all V2VEncryption instances and keys. */
+    EVP_CIPHER_CTX *threadWorkContext() {
+        thread_local std::unique_ptr<EVP_CIPHER_CTX, CipherCtxDeleter> ctx(EVP_CIPHER_CTX_new());
+        return ctx.get();
+    }
+
+    std::vector<std::byte> hashedId8(const uint8_t *data, size_t length) {
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        SHA256(data, length, digest);
+        // a HashedId8 is the low-order (last) eight bytes of the hash
+        auto id = reinterpret_cast<const std::byte *>(digest + SHA256_DIGEST_LENGTH - 8);
+        return {id, id + 8};
+    }
+
+    uint64_t idToKey(const std::vector<std::byte> &id) {
+        uint64_t key = 0;
+        std::memcpy(&key, id.data(), sizeof(key));
+        return key;
+    }
+
+    /** @brief  Get the 33-byte SEC 1 compressed encoding of a P-256 public key. */
+    bool compressedPublicKey(EVP_PKEY *key, uint8_t *out) {
+        // keys generated by OpenSSL export uncompressed whatever their conversion format says, so compress here
+        uint8_t uncompressed[1 + 2 * 32];
+        size_t length = 0;
+        if(EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_ENCODED_PUBLIC_KEY, uncompressed,
+                                           sizeof(uncompressed), &length) != 1 ||
+           length != sizeof(uncompressed) || uncompressed[0] != 0x04) {
+            return false;
+        }
+        out[0] = 0x02 | (uncompressed[sizeof(uncompressed) - 1] & 1);
+        std::memcpy(out + 1, uncompressed + 1, COMPRESSED_POINT_LENGTH - 1);
+        return true;
+    }
+
+    /** @brief  Rebuild a P-256 public key from its SEC 1 encoding. Caller frees the result. */
+    EVP_PKEY *publicKeyFromEncoding(const uint8_t *encoding, size_t length) {
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, const_cast<char *>("prime256v1"), 0),
+            OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY, const_cast<uint8_t *>(encoding), length),
+            OSSL_PARAM_construct_end()
+        };
+        EVP_PKEY *key = nullptr;
+        EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+        if(ctx == nullptr || EVP_PKEY_fromdata_init(ctx) != 1 ||
+           EVP_PKEY_fromdata(ctx, &key, EVP_PKEY_PUBLIC_KEY, params) != 1) {
+            key = nullptr;
+        }
+        EVP_PKEY_CTX_free(ctx);
+        return key;
+    }
+
+    /** @brief  ECDH over P-256: the x-coordinate of the shared point. */
+    bool deriveSharedSecret(EVP_PKEY *own, EVP_PKEY *peer, uint8_t *secret) {
+        EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(own, nullptr);
+        size_t length = 32;
+        bool ok = ctx != nullptr && EVP_PKEY_derive_init(ctx) == 1 && EVP_PKEY_derive_set_peer(ctx, peer) == 1 &&
+                  EVP_PKEY_derive(ctx, secret, &length) == 1 && length == 32;
+        EVP_PKEY_CTX_free(ctx);
+        return ok;
+    }
+
+    /** @brief  KDF2 with SHA-256 (IEEE 1363a), P1 = SHA-256 of the empty string as for keys not bound to a
+     *          certificate: 16 bytes of key-wrapping key followed by 32 bytes of MAC key. */
+    void deriveWrapKeys(const uint8_t *secret, size_t secretLength, uint8_t *kEnc, uint8_t *kMac) {
+        uint8_t p1[SHA256_DIGEST_LENGTH];
+        SHA256(nullptr, 0, p1);
+
+        // Z || counter || P1, hashed once per 32-byte block of output
+        std::vector<uint8_t> input(secret, secret + secretLength);
+        input.insert(input.end(), {0, 0, 0, 0});
+        input.insert(input.end(), p1, p1 + sizeof(p1));
+        uint8_t output[2 * SHA256_DIGEST_LENGTH];
+        for(uint8_t counter = 1; counter <= 2; counter++) {
+            input[secretLength + 3] = counter;
+            SHA256(input.data(), input.size(), output + (counter - 1) * SHA256_DIGEST_LENGTH);
+        }
+        OPENSSL_cleanse(input.data(), input.size());
+        std::memcpy(kEnc, output, WRAP_LENGTH);
+        std::memcpy(kMac, output + WRAP_LENGTH, 32);
+    }
+
+    /** @brief  c = dataKey XOR kEnc, t = HMAC-SHA-256(kMac, c) truncated to 16 bytes. */
+    void wrap(const V2VEncryption::DataKey &dataKey, const uint8_t *secret, size_t secretLength,
+              std::vector<std::byte> &c, std::vector<std::byte> &t) {
+        uint8_t kEnc[WRAP_LENGTH];
+        uint8_t kMac[32];
+        deriveWrapKeys(secret, secretLength, kEnc, kMac);
+
+        c.resize(WRAP_LENGTH);
+        for(size_t i = 0; i < WRAP_LENGTH; i++) {
+            c[i] = std::byte{static_cast<uint8_t>(dataKey[i] ^ kEnc[i])};
+        }
+
+        uint8_t mac[SHA256_DIGEST_LENGTH];
+        unsigned int macLength = 0;
+        HMAC(EVP_sha256(), kMac, sizeof(kMac), reinterpret_cast<const uint8_t *>(c.data()), c.size(), mac,
+             &macLength);
+        t.assign(reinterpret_cast<const std::byte *>(mac), reinterpret_cast<const std::byte *>(mac) + WRAP_LENGTH);
+        OPENSSL_cleanse(kEnc, sizeof(kEnc));
+        OPENSSL_cleanse(kMac, sizeof(kMac));
+    }
+
+    bool unwrap(const std::vector<std::byte> &c, const std::vector<std::byte> &t, const uint8_t *secret,
+                size_t secretLength, V2VEncryption::DataKey &dataKey) {
+        uint8_t kEnc[WRAP_LENGTH];
+        uint8_t kMac[32];
+        deriveWrapKeys(secret, secretLength, kEnc, kMac);
+
+        uint8_t mac[SHA256_DIGEST_LENGTH];
+        unsigned int macLength = 0;
+        HMAC(EVP_sha256(), kMac, sizeof(kMac), reinterpret_cast<const uint8_t *>(c.data()), c.size(), mac,
+             &macLength);
+        bool ok = CRYPTO_memcmp(mac, t.data(), WRAP_LENGTH) == 0;
+        if(ok) {
+            for(size_t i = 0; i < WRAP_LENGTH; i++) {
+                dataKey[i] = static_cast<uint8_t>(c[i]) ^ kEnc[i];
+            }
+        }
+        OPENSSL_cleanse(kEnc, sizeof(kEnc));
+        OPENSSL_cleanse(kMac, sizeof(kMac));
+        return ok;
+    }
+
+}
+
+
+V2VEncryption::V2VEncryption(size_t keyCacheCapacity) : keyCacheCapacity(std::max<size_t>(keyCacheCapacity, 1)) {
+
+    this->eciesKey = EVP_EC_gen("P-256");
+    uint8_t encoded[COMPRESSED_POINT_LENGTH];
+    if(this->eciesKey == nullptr || !compressedPublicKey(this->eciesKey, encoded)) {
+        throw std::runtime_error("Fatal error - could not generate ECIES key.");
+    }
+    this->ownId = hashedId8(encoded, sizeof(encoded));
+
+    this->mlKemPublicKey.resize(OQS_KEM_ml_kem_768_length_public_key);
+    this->mlKemSecretKey.resize(OQS_KEM_ml_kem_768_length_secret_key);
+    if(OQS_KEM_ml_kem_768_keypair(this->mlKemPublicKey.data(), this->mlKemSecretKey.data()) != OQS_SUCCESS) {
+        throw std::runtime_error("Fatal error - could not generate ML-KEM-768 key.");
+    }
+}
+
+V2VEncryption::~V2VEncryption() {
+    EVP_PKEY_free(this->eciesKey);
+    OPENSSL_cleanse(this->mlKemSecretKey.data(), this->mlKemSecretKey.size());
+}
+
+V2VEncryption::CachedKey::~CachedKey() {
+    for(auto &perCipher : this->templates) {
+        for(auto &ctx : perCipher) {
+            EVP_CIPHER_CTX_free(ctx.load());
+        }
+    }
+    OPENSSL_cleanse(this->key.data(), this->key.size());
+}
+
+const EVP_CIPHER_CTX *V2VEncryption::CachedKey::templateFor(PayloadCipher cipher, bool encrypt) const {
+
+    auto &slot = this->templates[static_cast<int>(cipher)][encrypt ? 1 : 0];
+    EVP_CIPHER_CTX *existing = slot.load(std::memory_order_acquire);
+    if(existing != nullptr) {
+        return existing;
+    }
+
+    const bool ccm = cipher == PayloadCipher::aes128Ccm;
+    const int enc = encrypt ? 1 : 0;
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if(ctx == nullptr ||
+       EVP_CipherInit_ex(ctx, ccm ? EVP_aes_128_ccm() : EVP_aes_128_gcm(), nullptr, nullptr, nullptr, enc) != 1 ||
+       EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, NONCE_LENGTH, nullptr) != 1 ||
+       (ccm && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, TAG_LENGTH, nullptr) != 1) ||
+       EVP_CipherInit_ex(ctx, nullptr, nullptr, this->key.data(), nullptr, enc) != 1) {
+        EVP_CIPHER_CTX_free(ctx);
+        return nullptr;
+    }
+
+    if(!slot.compare_exchange_strong(existing, ctx, std::memory_order_acq_rel)) {
+        // another thread initialized the same context first
+        EVP_CIPHER_CTX_free(ctx);
+        return existing;
+    }
+    return ctx;
+}
+
+V2VEncryption::RecipientKey V2VEncryption::publicKey() const {
+    RecipientKey recipient;
+    recipient.recipientId = this->ownId;
+    recipient.eciesPublicKey = this->eciesKey;
+    recipient.mlKemPublicKey = this->mlKemPublicKey;
+    return recipient;
+}
+
+std::vector<std::byte> V2VEncryption::keyId(const DataKey &dataKey) {
+    // COER of SymmetricEncryptionKey: the aes128Ccm choice tag followed by the key
+    uint8_t encoded[1 + sizeof(DataKey)];
+    encoded[0] = 0x80;
+    std::memcpy(encoded + 1, dataKey.data(), dataKey.size());
+    return hashedId8(encoded, sizeof(encoded));
+}
+
+std::shared_ptr<const V2VEncryption::CachedKey> V2VEncryption::findCachedKey(const std::vector<std::byte> &id) {
+    std::shared_lock<std::shared_mutex> lock(this->keyCacheMutex);
+    auto it = this->keyCache.find(idToKey(id));
+    return it == this->keyCache.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const V2VEncryption::CachedKey> V2VEncryption::cachedKeyFor(const DataKey &dataKey,
+                                                                           const std::vector<std::byte> &dataKeyId) {
+
+    const uint64_t id = idToKey(dataKeyId);
+    {
+        std::shared_lock<std::shared_mutex> lock(this->keyCacheMutex);
+        auto it = this->keyCache.find(id);
+        if(it != this->keyCache.end()) {
+            return it->second;
+        }
+    }
+
+    auto cachedKey = std::make_shared<const CachedKey>(dataKey);
+
+    std::unique_lock<std::shared_mutex> lock(this->keyCacheMutex);
+    auto inserted = this->keyCache.emplace(id, cachedKey);
+    if(inserted.second) {
+        this->keyCacheOrder.push_back(id);
+        if(this->keyCacheOrder.size() > this->keyCacheCapacity) {
+            // callers still holding the evicted entry keep it alive until they finish
+            this->keyCache.erase(this->keyCacheOrder.front());
+            this->keyCacheOrder.pop_front();
+        }
+    }
+    return inserted.first->second;
+}
+
+bool V2VEncryption::seal(const CachedKey &cachedKey, PayloadCipher cipher, const uint8_t *payload, size_t length,
+                         SymmetricCiphertext &out) {
+
+    const EVP_CIPHER_CTX *cipherTemplate = cachedKey.templateFor(cipher, true);
+    EVP_CIPHER_CTX *ctx = threadWorkContext();
+    if(cipherTemplate == nullptr || ctx == nullptr || EVP_CIPHER_CTX_copy(ctx, cipherTemplate) != 1) {
+        return false;
+    }
+
+    std::vector<std::byte> nonce(NONCE_LENGTH);
+    std::vector<std::byte> ciphertext(length + TAG_LENGTH);
+    auto *nonceBytes = reinterpret_cast<uint8_t *>(nonce.data());
+    auto *ciphertextBytes = reinterpret_cast<uint8_t *>(ciphertext.data());
+    int outLength = 0;
+    int finalLength = 0;
+
+    if(RAND_bytes(nonceBytes, NONCE_LENGTH) != 1 ||
+       EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, nonceBytes) != 1) {
+        return false;
+    }
+    // CCM needs the message length before any data
+    if(cipher == PayloadCipher::aes128Ccm &&
+       EVP_EncryptUpdate(ctx, nullptr, &outLength, nullptr, static_cast<int>(length)) != 1) {
+        return false;
+    }
+    if(EVP_EncryptUpdate(ctx, ciphertextBytes, &outLength, payload, static_cast<int>(length)) != 1 ||
+       EVP_EncryptFinal_ex(ctx, ciphertextBytes + outLength, &finalLength) != 1 ||
+       EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, TAG_LENGTH, ciphertextBytes + length) != 1) {
+        return false;
+    }
+
+    out = SymmetricCiphertext(cipher == PayloadCipher::aes128Ccm ? SymmetricCiphertextChoice::aes128Ccm
+                                                                 : SymmetricCiphertextChoice::aes128Gcm,
+                              nonce, ciphertext);
+    return true;
+}
+
+bool V2VEncryption::open(const CachedKey &cachedKey, const SymmetricCiphertext &ciphertext,
+                         std::vector<uint8_t> &plaintext) {
+
+    PayloadCipher cipher;
+    if(ciphertext.getChoice() == SymmetricCiphertextChoice::aes128Ccm) {
+        cipher = PayloadCipher::aes128Ccm;
+    }
+    else if(ciphertext.getChoice() == SymmetricCiphertextChoice::aes128Gcm) {
+        cipher = PayloadCipher::aes128Gcm;
+    }
+    else {
+        return false;
+    }
+
+    const auto &body = ciphertext.getCiphertext();
+    if(body.size() < TAG_LENGTH) {
+        return false;
+    }
+    const size_t length = body.size() - TAG_LENGTH;
+    const auto *bodyBytes = reinterpret_cast<const uint8_t *>(body.data());
+    auto *tag = const_cast<uint8_t *>(bodyBytes + length);
+    auto nonce = ciphertext.getNonce();
+
+    const EVP_CIPHER_CTX *cipherTemplate = cachedKey.templateFor(cipher, false);
+    EVP_CIPHER_CTX *ctx = threadWorkContext();
+    if(cipherTemplate == nullptr || ctx == nullptr || EVP_CIPHER_CTX_copy(ctx, cipherTemplate) != 1) {
+        return false;
+    }
+
+    plaintext.resize(length);
+    int outLength = 0;
+    int finalLength = 0;
+
+    if(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, TAG_LENGTH, tag) != 1 ||
+       EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, reinterpret_cast<const uint8_t *>(nonce.data())) != 1) {
+        return false;
+    }
+    if(cipher == PayloadCipher::aes128Ccm) {
+        // CCM authenticates in the (single) update call and has nothing left to do in final
+        return EVP_DecryptUpdate(ctx, nullptr, &outLength, nullptr, static_cast<int>(length)) == 1 &&
+               EVP_DecryptUpdate(ctx, plaintext.data(), &outLength, bodyBytes, static_cast<int>(length)) == 1;
+    }
+    return EVP_DecryptUpdate(ctx, plaintext.data(), &outLength, bodyBytes, static_cast<int>(length)) == 1 &&
+           EVP_DecryptFinal_ex(ctx, plaintext.data() + outLength, &finalLength) == 1;
+}
+
+bool V2VEncryption::wrapKey(const DataKey &dataKey, const RecipientKey &recipient, KeyEncapsulation kem,
+                            EncryptedDataEncryptionKey &out) {
+
+    std::vector<std::byte> c;
+    std::vector<std::byte> t;
+
+    if(kem == KeyEncapsulation::mlKem768) {
+        if(recipient.mlKemPublicKey.size() != OQS_KEM_ml_kem_768_length_public_key) {
+            return false;
+        }
+        std::vector<std::byte> kemCiphertext(OQS_KEM_ml_kem_768_length_ciphertext);
+        uint8_t secret[OQS_KEM_ml_kem_768_length_shared_secret];
+        if(OQS_KEM_ml_kem_768_encaps(reinterpret_cast<uint8_t *>(kemCiphertext.data()), secret,
+                                     recipient.mlKemPublicKey.data()) != OQS_SUCCESS) {
+            return false;
+        }
+        wrap(dataKey, secret, sizeof(secret), c, t);
+        OPENSSL_cleanse(secret, sizeof(secret));
+        out = EncryptedDataEncryptionKey(kemCiphertext, c, t);
+        return true;
+    }
+
+    if(recipient.eciesPublicKey == nullptr) {
+        return false;
+    }
+    EVP_PKEY *ephemeral = EVP_EC_gen("P-256");
+    uint8_t secret[32];
+    uint8_t encoded[COMPRESSED_POINT_LENGTH];
+    bool ok = ephemeral != nullptr && deriveSharedSecret(ephemeral, recipient.eciesPublicKey, secret) &&
+              compressedPublicKey(ephemeral, encoded);
+    EVP_PKEY_free(ephemeral);
+    if(!ok) {
+        return false;
+    }
+
+    wrap(dataKey, secret, sizeof(secret), c, t);
+    OPENSSL_cleanse(secret, sizeof(secret));
+    EccP256CurvePoint v(encoded[0] == 0x02 ? CurvePointChoice::compressedY0 : CurvePointChoice::compressedY1,
+                        std::vector<std::byte>(reinterpret_cast<const std::byte *>(encoded + 1),
+                                               reinterpret_cast<const std::byte *>(encoded + sizeof(encoded))));
+    out = EncryptedDataEncryptionKey(EncryptedDataEncryptionKeyChoice::eciesNistP256, v, c, t);
+    return true;
+}
+
+bool V2VEncryption::unwrapKey(const EncryptedDataEncryptionKey &encKey, DataKey &dataKey) const {
+
+    if(encKey.getChoice() == EncryptedDataEncryptionKeyChoice::mlKem768) {
+        uint8_t secret[OQS_KEM_ml_kem_768_length_shared_secret];
+        auto kemCiphertext = encKey.getKemCiphertext();
+        if(OQS_KEM_ml_kem_768_decaps(secret, reinterpret_cast<const uint8_t *>(kemCiphertext.data()),
+                                     this->mlKemSecretKey.data()) != OQS_SUCCESS) {
+            return false;
+        }
+        bool ok = unwrap(encKey.getC(), encKey.getT(), secret, sizeof(secret), dataKey);
+        OPENSSL_cleanse(secret, sizeof(secret));
+        return ok;
+    }
+
+    if(encKey.getChoice() != EncryptedDataEncryptionKeyChoice::eciesNistP256) {
+        return false;
+    }
+    auto v = encKey.getV();
+    if(v.getCurvePointChoice() != CurvePointChoice::compressedY0 &&
+       v.getCurvePointChoice() != CurvePointChoice::compressedY1) {
+        return false;
+    }
+    uint8_t encoded[COMPRESSED_POINT_LENGTH];
+    encoded[0] = v.getCurvePointChoice() == CurvePointChoice::compressedY0 ? 0x02 : 0x03;
+    auto x = v.getCompressedValue();
+    std::memcpy(encoded + 1, x.data(), x.size());
+
+    EVP_PKEY *ephemeral = publicKeyFromEncoding(encoded, sizeof(encoded));
+    uint8_t secret[32];
+    bool ok = ephemeral != nullptr && deriveSharedSecret(this->eciesKey, ephemeral, secret) &&
+              unwrap(encKey.getC(), encKey.getT(), secret, sizeof(secret), dataKey);
+    EVP_PKEY_free(ephemeral);
+    OPENSSL_cleanse(secret, sizeof(secret));
+    return ok;
+}
+
+bool V2VEncryption::encrypt(const uint8_t *payload, size_t length, const std::vector<RecipientKey> &recipients,
+                            KeyEncapsulation kem, PayloadCipher cipher, EncryptedData &out, DataKey *dataKey) {
+
+    if(recipients.empty()) {
+        return false;
+    }
+
+    DataKey key{};
+    if(RAND_bytes(key.data(), static_cast<int>(key.size())) != 1) {
+        return false;
+    }
+
+    std::vector<RecipientInfo> recipientInfos;
+    recipientInfos.reserve(recipients.size());
+    for(const auto &recipient : recipients) {
+        EncryptedDataEncryptionKey encKey;
+        if(recipient.recipientId.size() != RecipientInfo::HASHED_ID8_SIZE_BYTES ||
+           !wrapKey(key, recipient, kem, encKey)) {
+            return false;
+        }
+        // no certificates here: recipients are named by the HashedId8 of their public encryption key
+        recipientInfos.emplace_back(RecipientInfoChoice::rekRecipInfo, recipient.recipientId, encKey);
+    }
+
+    SymmetricCiphertext ciphertext;
+    bool ok;
+    if(dataKey != nullptr) {
+        // the caller will reuse the key, so keep its contexts
+        ok = seal(*cachedKeyFor(key, keyId(key)), cipher, payload, length, ciphertext);
+        *dataKey = key;
+    }
+    else {
+        CachedKey oneShot(key);
+        ok = seal(oneShot, cipher, payload, length, ciphertext);
+    }
+    OPENSSL_cleanse(key.data(), key.size());
+    if(!ok) {
+        return false;
+    }
+
+    out = EncryptedData(recipientInfos, ciphertext);
+    return true;
+}
+
+bool V2VEncryption::encryptWithKey(const uint8_t *payload, size_t length, const DataKey &dataKey,
+                                   PayloadCipher cipher, EncryptedData &out) {
+
+    auto id = keyId(dataKey);
+    auto cachedKey = cachedKeyFor(dataKey, id);
+    SymmetricCiphertext ciphertext;
+    if(!seal(*cachedKey, cipher, payload, length, ciphertext)) {
+        return false;
+    }
+
+    out = EncryptedData({RecipientInfo(id)}, ciphertext);
+    return true;
+}
+
+bool V2VEncryption::decrypt(const EncryptedData &data, std::vector<uint8_t> &plaintext) {
+
+    const auto &recipients = data.getRecipients();
+
+    for(const auto &recipient : recipients) {
+        if(recipient.getChoice() == RecipientInfoChoice::pskRecipInfo) {
+            auto cachedKey = findCachedKey(recipient.getRecipientId());
+            if(cachedKey != nullptr) {
+                return open(*cachedKey, data.getCiphertext(), plaintext);
+            }
+        }
+    }
+
+    for(const auto &recipient : recipients) {
+        if(recipient.getChoice() != RecipientInfoChoice::pskRecipInfo && recipient.getRecipientId() == this->ownId) {
+            DataKey key{};
+            if(!unwrapKey(recipient.getEncKey(), key)) {
+                return false;
+            }
+            bool ok = open(*cachedKeyFor(key, keyId(key)), data.getCiphertext(), plaintext);
+            OPENSSL_cleanse(key.data(), key.size());
+            return ok;
+        }
+    }
+
+    return false;
+}
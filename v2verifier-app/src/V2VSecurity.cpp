@@ -7,11 +7,30 @@
  */
 
 #include <openssl/pem.h>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <openssl/bio.h>
+#include <openssl/ecdsa.h>
 
 #include "../include/V2VSecurity.hpp"
 
+namespace {
+
+    struct MdCtxDeleter {
+        void operator()(EVP_MD_CTX *ctx) const { EVP_MD_CTX_free(ctx); }
+    };
+
+    /** Per-thread working context. Every sign/verify overwrites it with a copy of an initialized template, so one
+     *  context per thread serves all V2VSecurity instances and keys. */
+    EVP_MD_CTX *threadWorkContext() {
+        thread_local std::unique_ptr<EVP_MD_CTX, MdCtxDeleter> ctx(EVP_MD_CTX_new());
+        return ctx.get();
+    }
+
+}
+
 
 V2VSecurity::V2VSecurity(std::string &pemFilename) {
     loadPEMFile(pemFilename);
@@ -25,6 +44,11 @@ V2VSecurity::~V2VSecurity() {
         this->pemfile.close();
 
     EVP_MD_CTX_destroy(this->mdctx_sign);
+
+    for(auto &entry : this->verifyTemplates) {
+        EVP_MD_CTX_free(entry.second);
+        EVP_PKEY_free(const_cast<EVP_PKEY *>(entry.first));
+    }
 }
 
 void V2VSecurity::loadPEMFile(std::string &filename) {
@@ -71,60 +95,133 @@ void V2VSecurity::setup() {
         throw std::runtime_error("Fatal error - could not initialize EVP digest");
     }
 
-    this->mdctx_verify = EVP_MD_CTX_create();
-    if(!this->mdctx_verify) {
-        throw std::runtime_error("Fatal error - could not create verifier context");
+}
+
+size_t V2VSecurity::maxSignatureLength() const {
+    return static_cast<size_t>(EVP_PKEY_get_size(this->pkey));
+}
+
+bool V2VSecurity::sign(const uint8_t *msg, size_t length, unsigned char *sig, size_t sigCapacity, size_t &sig_len) {
 
+    EVP_MD_CTX *ctx = threadWorkContext();
+    if(ctx == nullptr || EVP_MD_CTX_copy_ex(ctx, this->mdctx_sign) != 1) {
+        return false;
+    }
+
+    if(EVP_DigestSignUpdate(ctx, msg, length) != 1) {
+        return false;
     }
 
+    sig_len = sigCapacity;
+    return EVP_DigestSignFinal(ctx, sig, &sig_len) == 1;
 }
 
-bool V2VSecurity::signMessage(char* msg, unsigned char* &sig, size_t &sig_len) {
+const EVP_MD_CTX *V2VSecurity::verifyTemplateFor(EVP_PKEY *publicKey) {
 
-    unsigned char* localSig = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(this->verifyTemplatesMutex);
+        auto it = this->verifyTemplates.find(publicKey);
+        if(it != this->verifyTemplates.end()) {
+            return it->second;
+        }
+    }
 
-    if(EVP_DigestSignUpdate(this->mdctx_sign, msg, strlen(msg)) != 1) {
-        return false;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    if(ctx == nullptr || EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, publicKey) != 1) {
+        EVP_MD_CTX_free(ctx);
+        return nullptr;
     }
 
-    if(EVP_DigestSignFinal(this->mdctx_sign, nullptr, &sig_len) != 1) {
-        return false;
+    std::unique_lock<std::shared_mutex> lock(this->verifyTemplatesMutex);
+    auto inserted = this->verifyTemplates.emplace(publicKey, ctx);
+    if(!inserted.second) {
+        // another thread initialized the same key first
+        EVP_MD_CTX_free(ctx);
+    }
+    else {
+        // keep the key alive (and its address unique) for as long as the cache refers to it
+        EVP_PKEY_up_ref(publicKey);
     }
+    return inserted.first->second;
+}
+
+bool V2VSecurity::verify(const uint8_t *msg, size_t length, EVP_PKEY *publicKey, const unsigned char *signature,
+                         size_t sig_len) {
 
-    if(!(localSig = (unsigned char*) OPENSSL_malloc(sizeof(unsigned char) * (sig_len)))) {
-        OPENSSL_free(localSig);
+    const EVP_MD_CTX *verifyTemplate = verifyTemplateFor(publicKey);
+    EVP_MD_CTX *ctx = threadWorkContext();
+    if(verifyTemplate == nullptr || ctx == nullptr || EVP_MD_CTX_copy_ex(ctx, verifyTemplate) != 1) {
         return false;
     }
 
-    if(EVP_DigestSignFinal(this->mdctx_sign, localSig, &sig_len) != 1) {
+    if(EVP_DigestVerifyUpdate(ctx, msg, length) != 1) {
         return false;
     }
 
-    sig = new unsigned char[sig_len];
+    return EVP_DigestVerifyFinal(ctx, signature, sig_len) == 1;
+}
 
-    memcpy(sig, localSig, sig_len);
+bool V2VSecurity::signRaw(const uint8_t *msg, size_t length, uint8_t *rs) {
 
-    OPENSSL_free(localSig);
+    unsigned char der[80];  // an ECDSA P.256 signature is at most 72 bytes of DER
+    size_t der_len = 0;
+    if(!sign(msg, length, der, sizeof(der), der_len)) {
+        return false;
+    }
 
-    return true;
+    const unsigned char *cursor = der;
+    ECDSA_SIG *ecdsaSig = d2i_ECDSA_SIG(nullptr, &cursor, static_cast<long>(der_len));
+    if(ecdsaSig == nullptr) {
+        return false;
+    }
+
+    const BIGNUM *r = nullptr;
+    const BIGNUM *s = nullptr;
+    ECDSA_SIG_get0(ecdsaSig, &r, &s);
+    const bool ok = BN_bn2binpad(r, rs, 32) == 32 && BN_bn2binpad(s, rs + 32, 32) == 32;
+    ECDSA_SIG_free(ecdsaSig);
+    return ok;
 }
 
-bool V2VSecurity::verifyMessage(char *msg, evp_pkey_st *publicKey, const unsigned char* signature, size_t sig_len) {
+bool V2VSecurity::verifyRaw(const uint8_t *msg, size_t length, EVP_PKEY *publicKey, const uint8_t *rs) {
 
-    if(EVP_DigestVerifyInit(this->mdctx_verify, nullptr, EVP_sha256(), nullptr, publicKey) != 1) {
+    ECDSA_SIG *ecdsaSig = ECDSA_SIG_new();
+    BIGNUM *r = BN_bin2bn(rs, 32, nullptr);
+    BIGNUM *s = BN_bin2bn(rs + 32, 32, nullptr);
+    if(ecdsaSig == nullptr || r == nullptr || s == nullptr || ECDSA_SIG_set0(ecdsaSig, r, s) != 1) {
+        BN_free(r);
+        BN_free(s);
+        ECDSA_SIG_free(ecdsaSig);
         return false;
     }
 
-    // strlen() might not work with binary data. Need to test.
-    if(EVP_DigestVerifyUpdate(this->mdctx_verify, msg, strlen(msg)) != 1) {
+    unsigned char der[80];
+    unsigned char *cursor = der;
+    const int der_len = i2d_ECDSA_SIG(ecdsaSig, &cursor);
+    ECDSA_SIG_free(ecdsaSig);
+    if(der_len <= 0) {
         return false;
     }
 
-    if(EVP_DigestVerifyFinal(this->mdctx_verify, signature, sig_len) == 1) {
-        return true;
-    }
-    else {
+    return verify(msg, length, publicKey, der, static_cast<size_t>(der_len));
+}
+
+bool V2VSecurity::signMessage(char* msg, unsigned char* &sig, size_t &sig_len) {
+
+    const size_t capacity = maxSignatureLength();
+    auto *localSig = new unsigned char[capacity];
+
+    if(!sign(reinterpret_cast<const uint8_t *>(msg), strlen(msg), localSig, capacity, sig_len)) {
+        delete[] localSig;
         return false;
     }
 
+    sig = localSig;
+    return true;
+}
+
+bool V2VSecurity::verifyMessage(char *msg, evp_pkey_st *publicKey, const unsigned char* signature, size_t sig_len) {
+
+    return verify(reinterpret_cast<const uint8_t *>(msg), strlen(msg), publicKey, signature, sig_len);
+
 }
\ No newline at end of file
@@ -6,10 +6,69 @@
  *  @bug    No known bugs.
  */
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <thread>
+
+#include <openssl/evp.h>
 
+#include "../../logger/BinaryLog.h"
 #include "../../logger/Log.h"
 #include "../include/Vehicle.hpp"
+#include "../../v2xmessage/include/IEEE1609Dot2Data.hpp"
+
+namespace {
+
+    /** PSID of the BSM safety service. */
+    const uint32_t BSM_PSID = 0x20;
+
+    /** How long a generated SPDU stays valid, in milliseconds. */
+    const uint64_t SPDU_LIFETIME_MS = 1000 * 60 * 60;
+
+    /** Largest SPDU the receiver accepts. */
+    const size_t MAX_SPDU_BYTES = 2048;
+
+    /** @brief  Build the data input to ECDSA for a self-signed SPDU: Hash(tbsData) || Hash(empty string), as
+     *          specified in IEEE 1609.2-2022 clause 5.3.1.
+     *
+     *  @param  tbsData COER encoding of the ToBeSignedData.
+     *  @return         The 64-byte value to be signed or verified.
+     */
+    std::array<uint8_t, 64> signatureInput(const std::vector<std::byte> &tbsData) {
+        static const std::array<uint8_t, 32> emptySignerHash = []() {
+            std::array<uint8_t, 32> hash{};
+            EVP_Digest("", 0, hash.data(), nullptr, EVP_sha256(), nullptr);
+            return hash;
+        }();
+
+        std::array<uint8_t, 64> input{};
+        EVP_Digest(tbsData.data(), tbsData.size(), input.data(), nullptr, EVP_sha256(), nullptr);
+        std::copy(emptySignerHash.begin(), emptySignerHash.end(), input.begin() + 32);
+        return input;
+    }
+
+    long long microsecondsSinceEpoch() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    long long microsecondsBetween(std::chrono::steady_clock::time_point start,
+                                  std::chrono::steady_clock::time_point end) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+
+}
 
 
 Vehicle::Vehicle(double latitude, double longitude, double elevation, double speed, double heading,
@@ -60,95 +119,301 @@ int Vehicle::initializePositionAndMotion(double latitude,
 }
 
 int Vehicle::updateLatitude(const double latitude) {
-    if(-90 <= latitude && latitude <= 90) {
+    if(VehicleLimits::MIN_LATITUDE <= latitude && latitude <= VehicleLimits::MAX_LATITUDE) {
         this->locationData.latitude = latitude;
         return 0;
     }
     else {
-        auto field_name = std::string("latitude");
-        Logger::logWarning(formatErrorForInvalidValue(field_name, latitude));
+        BINLOG_WARNING("Failed to update latitude (invalid value: {})", latitude);
         return -1;
     }
 }
 
 int Vehicle::updateLongitude(const double longitude) {
-    if(-180 <= longitude && longitude <= 180) {
+    if(VehicleLimits::MIN_LONGITUDE <= longitude && longitude <= VehicleLimits::MAX_LONGITUDE) {
         this->locationData.longitude = longitude;
         return 0;
     }
     else {
-        auto field_name = std::string("longitude");
-        Logger::logWarning(formatErrorForInvalidValue(field_name, longitude));
+        BINLOG_WARNING("Failed to update longitude (invalid value: {})", longitude);
         return -1;
     }
 }
 
 int Vehicle::updateElevation(const double elevation) {
-    // The lowest elevation for a road is roughly -500m (near the Dead Sea)
-    // The highest elevation for a road is roughly 5800m (near Ladakh, India)
-    if(-600 <= elevation && elevation <= 6000) {
+    if(VehicleLimits::MIN_ELEVATION <= elevation && elevation <= VehicleLimits::MAX_ELEVATION) {
         this->locationData.elevation = elevation;
         return 0;
     }
     else {
-        auto field_name = std::string("elevation");
-        Logger::logWarning(formatErrorForInvalidValue(field_name, elevation));
+        BINLOG_WARNING("Failed to update elevation (invalid value: {})", elevation);
         return -1;
     }
 }
 
 int Vehicle::updateSpeed(const double speed) {
-    // speed should never be less than zero
-    // we do not expect a vehicle to exceed 110 m/s (250 mph)
-    if(0 <= speed && speed <= 110) {
+    if(VehicleLimits::MIN_SPEED <= speed && speed <= VehicleLimits::MAX_SPEED) {
         this->motionData.speed = speed;
         return 0;
     }
     else {
-        auto field_name = std::string("speed");
-        Logger::logWarning(formatErrorForInvalidValue(field_name, speed));
+        BINLOG_WARNING("Failed to update speed (invalid value: {})", speed);
         return -1;
     }
 }
 
 int Vehicle::updateHeading(const double heading) {
-    if(0 <= heading && heading < 360) {
+    if(VehicleLimits::MIN_HEADING <= heading && heading < VehicleLimits::MAX_HEADING) {
         this->motionData.heading = heading;
         return 0;
     }
     else {
-        auto field_name = std::string("heading");
-        Logger::logWarning(formatErrorForInvalidValue(field_name, heading));
+        BINLOG_WARNING("Failed to update heading (invalid value: {})", heading);
         return -1;
     }
 }
 
 int Vehicle::updateGPSPosition(const double latitude, const double longitude, const double elevation) {
     if(updateLatitude(latitude) != 0) {
-        Logger::logWarning(std::string("Failed to set GPS position"));
+        BINLOG_WARNING("Failed to set GPS position");
         return -1;
     }
     if(updateLongitude(longitude) != 0) {
-        Logger::logWarning(std::string("Failed to set GPS position"));
+        BINLOG_WARNING("Failed to set GPS position");
         return -1;
     }
     if(updateElevation(elevation) != 0) {
-        Logger::logWarning(std::string("Failed to set GPS position"));
+        BINLOG_WARNING("Failed to set GPS position");
         return -1;
     }
 
     return 0;
 }
 
-std::string Vehicle::formatErrorForInvalidValue(std::string &field, const double invalidValue) {
-    return  std::string("Failed to update " +
-            field +
-            std::string(" (invalid value: ") + std::to_string(invalidValue) + std::string(")"));
+std::vector<std::byte> Vehicle::generateSignedBSM(uint8_t msgCount, uint32_t vehicleId) {
+
+    uint64_t currentTime = Utility::getCurrentTimeAsUint64();
+
+    J2735BSM bsm(msgCount,
+                 vehicleId,
+                 (uint16_t) (currentTime % 60000),
+                 this->locationData.latitude,
+                 this->locationData.longitude,
+                 this->locationData.elevation,
+                 this->motionData.speed,
+                 this->motionData.heading);
+    auto bsmBytes = bsm.getCOER();
+
+    ToBeSignedData tbsData(SignedDataPayload(bsmBytes),
+                           HeaderInfo(BSM_PSID, currentTime, currentTime + SPDU_LIFETIME_MS));
+
+    auto input = signatureInput(tbsData.getCOER());
+    std::array<uint8_t, V2VSecurity::RAW_SIGNATURE_LENGTH> rs{};
+    if(!this->securityManager->signRaw(input.data(), input.size(), rs.data())) {
+        BINLOG_ERROR("Failed to sign BSM (msgCount: {})", msgCount);
+        return {};
+    }
+
+    auto *rsBytes = reinterpret_cast<const std::byte *>(rs.data());
+    Signature signature(EcdsaP256Signature(
+            EccP256CurvePoint(CurvePointChoice::xOnly, std::vector<std::byte>(rsBytes, rsBytes + 32)),
+            std::vector<std::byte>(rsBytes + 32, rsBytes + 64)));
+
+    SignedData signedData(IEEE1609Dot2DataTypes::HashAlgorithm::sha256,
+                          tbsData,
+                          SignerIdentifier(SignerIdentifierChoice::self),
+                          signature);
+
+    IEEE1609Dot2Data spdu{IEEE1609Dot2Content(signedData)};
+    return spdu.getCOER();
 }
 
-std::string Vehicle::formatErrorForInvalidValue(std::string &field, const int invalidValue) {
-    return  std::string("Failed to update " +
-                        field +
-                        std::string(" (invalid value: ") + std::to_string(invalidValue) + std::string(")"));
+bool Vehicle::verifySignedBSM(const std::vector<std::byte> &coerBytes, J2735BSM &bsm) {
+
+    try {
+        IEEE1609Dot2Data spdu(coerBytes);
+        auto content = spdu.getContent();
+        if(content.getContentChoice() != IEEE1609Dot2ContentChoice::signedData) {
+            BINLOG_WARNING("Received SPDU without signed data (content choice: {})", content.getContentChoice());
+            return false;
+        }
+
+        auto signedData = content.getSignedData();
+        auto tbsData = signedData.getTbsData();
+        bsm = J2735BSM(tbsData.getPayload().getData());
+
+        auto ecdsaSignature = signedData.getSignature().getEcdsaP256Signature();
+        auto rSig = ecdsaSignature.getRSig().getCompressedValue();
+        auto sSig = ecdsaSignature.getSSig();
+
+        std::array<uint8_t, V2VSecurity::RAW_SIGNATURE_LENGTH> rs{};
+        std::memcpy(rs.data(), rSig.data(), 32);
+        std::memcpy(rs.data() + 32, sSig.data(), 32);
+
+        auto input = signatureInput(tbsData.getCOER());
+        return this->securityManager->verifyRaw(input.data(), input.size(), this->securityManager->pkey, rs.data());
+    }
+    catch(std::exception &e) {
+        BINLOG_WARNING("Failed to decode SPDU ({} bytes): {}", coerBytes.size(), e.what());
+        return false;
+    }
 }
 
+void Vehicle::transmit(int numMessages, const PipelineOptions &options) {
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(sockfd < 0) {
+        perror("socket creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    sockaddr_in servaddr{};
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_port = htons(options.port);
+    servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    long long generateUs = 0;
+    size_t spduBytes = 0;
+    int sent = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < numMessages; i++) {
+        auto generateStart = std::chrono::steady_clock::now();
+        auto spdu = generateSignedBSM((uint8_t) i, options.vehicleId);
+        generateUs += microsecondsBetween(generateStart, std::chrono::steady_clock::now());
+
+        if(spdu.empty()) {
+            continue;
+        }
+        spduBytes = spdu.size();
+
+        if(sendto(sockfd, spdu.data(), spdu.size(), 0,
+                  reinterpret_cast<const sockaddr *>(&servaddr), sizeof(servaddr)) < 0) {
+            perror("sendto failed");
+            close(sockfd);
+            exit(EXIT_FAILURE);
+        }
+        sent++;
+
+        if(options.intervalUs > 0 && i + 1 < numMessages) {
+            std::this_thread::sleep_for(std::chrono::microseconds(options.intervalUs));
+        }
+    }
+
+    close(sockfd);
+
+    const double elapsedSeconds = microsecondsBetween(start, std::chrono::steady_clock::now()) / 1e6;
+    std::cout << "SIGNING vehicle=" << options.vehicleId
+              << " backend=v2vsecurity"
+              << " encoding=coer"
+              << " messages=" << sent
+              << " spdu_bytes=" << spduBytes
+              << " generate_us=" << generateUs
+              << " messages_per_s=" << (elapsedSeconds > 0 ? sent / elapsedSeconds : 0.0)
+              << std::endl;
+}
+
+void Vehicle::receive(int numMessages, const PipelineOptions &options) {
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(sockfd < 0) {
+        perror("socket creation failed");
+        exit(EXIT_FAILURE);
+    }
+
+    sockaddr_in servaddr{};
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_port = htons(options.port);
+    servaddr.sin_addr.s_addr = INADDR_ANY;
+
+    if(bind(sockfd, reinterpret_cast<const sockaddr *>(&servaddr), sizeof(servaddr)) < 0) {
+        perror("Socket bind failed");
+        close(sockfd);
+        exit(EXIT_FAILURE);
+    }
+
+    const char *metricsPath = std::getenv("V2X_METRICS_FILE");
+    const char *metricsRunId = std::getenv("V2X_METRICS_RUN");
+    const char *metricsNote = std::getenv("V2X_METRICS_NOTE");
+
+    std::vector<std::byte> buffer(MAX_SPDU_BYTES);
+    long long firstTimestamp = 0;
+    long long lastTimestamp = 0;
+    long long verifyUs = 0;
+    size_t spduBytes = 0;
+    int received = 0;
+    int valid = 0;
+
+    while(received < numMessages) {
+        ssize_t length = recv(sockfd, buffer.data(), buffer.size(), 0);
+        if(length < 0) {
+            perror("recv failed");
+            close(sockfd);
+            exit(EXIT_FAILURE);
+        }
+
+        if(received == 0) {
+            firstTimestamp = microsecondsSinceEpoch();
+        }
+
+        std::vector<std::byte> coerBytes(buffer.begin(), buffer.begin() + length);
+        spduBytes = coerBytes.size();
+
+        J2735BSM bsm;
+        auto verifyStart = std::chrono::steady_clock::now();
+        bool isValid = verifySignedBSM(coerBytes, bsm);
+        verifyUs += microsecondsBetween(verifyStart, std::chrono::steady_clock::now());
+
+        for(int i = 0; i < 80; i++) {
+            std::cout << "-";
+        }
+        std::cout << std::endl;
+        std::cout << "Received SPDU (" << spduBytes << " bytes)" << std::endl;
+        std::cout << "\tValid:\t" << (isValid ? "TRUE" : "FALSE") << std::endl;
+        if(isValid) {
+            std::cout << "\tVehicle:\t" << bsm.getTemporaryId()
+                      << "\tMsgCount:\t" << (int) bsm.getMsgCount() << std::endl;
+            std::cout << "\tLatitude:\t" << bsm.getLatitude()
+                      << "\tLongitude:\t" << bsm.getLongitude()
+                      << "\tElevation:\t" << bsm.getElevation() << std::endl;
+            std::cout << "\tSpeed:\t" << bsm.getSpeed()
+                      << "\tHeading:\t" << bsm.getHeading() << std::endl;
+            valid++;
+        }
+
+        received++;
+        lastTimestamp = microsecondsSinceEpoch();
+    }
+
+    close(sockfd);
+
+    if(received > 0) {
+        const long long totalDuration = lastTimestamp - firstTimestamp;
+
+        // same columns as falcon_sim so both tools can append to one metrics file; scheme 0 is ECDSA
+        if(metricsPath != nullptr) {
+            std::ofstream metricsFile(metricsPath, std::ios::app);
+            if(metricsFile.is_open()) {
+                metricsFile << (metricsRunId != nullptr ? metricsRunId : "0") << ','
+                            << 0 << ','
+                            << totalDuration << ','
+                            << firstTimestamp << ','
+                            << lastTimestamp << ','
+                            << (metricsNote != nullptr ? metricsNote : "")
+                            << '\n';
+            }
+        }
+
+        std::cout << "METRIC run=" << (metricsRunId != nullptr ? metricsRunId : "0")
+                  << " scheme=0"
+                  << " total_us=" << totalDuration
+                  << " first_us=" << firstTimestamp
+                  << " last_us=" << lastTimestamp
+                  << " encoding=coer"
+                  << " spdu_bytes=" << spduBytes
+                  << " valid=" << valid
+                  << " invalid=" << received - valid
+                  << " verify_us=" << verifyUs
+                  << std::endl;
+    }
+}
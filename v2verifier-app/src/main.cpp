@@ -1,55 +1,87 @@
 /** @file   main.cpp
  *  @brief  Main execution file for the testbed.
  *
+ *  Runs the same transmit/receive workloads as falcon_sim, but with COER-encoded IEEE 1609.2 SPDUs signed through
+ *  V2VSecurity. The number of messages comes from the scenario config (V2X_CONFIG_PATH, default config.json); the
+ *  port, message interval and metrics output use the same environment variables as falcon_sim.
+ *
  *  @author Geoff Twardokus
  *
  *  @bug    No known bugs.
  */
 
-#include <cstddef>
+#include <cstdlib>
 #include <iostream>
-#include <vector>
+#include <string>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
+#include "../../logger/BinaryLog.h"
 #include "../../logger/Log.h"
 #include "../include/Vehicle.hpp"
-#include "../../v2xmessage/include/IEEE1609Dot2.hpp"
-#include "../include/V2VSecurity.hpp"
 
-int main() {
+void printUsage() {
+    std::cout << "Usage: v2verifier {transmitter | receiver}" << std::endl;
+}
 
-    Logger::startLog("vehicleLog.txt");
+/** @brief  Read a numeric environment variable.
+ *
+ *  @param  name        Name of the variable.
+ *  @param  fallback    Value to use when the variable is unset or not a number.
+ *  @return             The value of the variable, or \\p fallback.
+ */
+long numberFromEnvironment(const char *name, long fallback) {
+    const char *env = std::getenv(name);
+    if(env != nullptr) {
+        char *end = nullptr;
+        long value = std::strtol(env, &end, 10);
+        if(end != env) {
+            return value;
+        }
+    }
+    return fallback;
+}
 
-//    std::vector<std::byte> testBytes;
-//    testBytes.push_back(std::byte{0x03});
-//    testBytes.push_back(std::byte{0x80});
-//    testBytes.push_back(std::byte{0xF3});
-//    testBytes.push_back(std::byte{0xA5});
-//
-//    auto test = Vehicle::getUnsecurePduCOERForPayload(testBytes);
+int main(int argc, char *argv[]) {
 
-    std::string pemFilename = "../../test_key.pem";
+    if(argc != 2 || (std::string(argv[1]) != "transmitter" && std::string(argv[1]) != "receiver")) {
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
 
-    Vehicle v(43, 75, 100, 100, 40, pemFilename);
+    Logger::startLog("vehicleLog.txt");
+    Logger::startBinaryLog("vehicleLog.bin");
+
+    const char *configOverride = std::getenv("V2X_CONFIG_PATH");
+    std::string configPath = configOverride != nullptr ? std::string(configOverride) : "config.json";
 
-    std::vector<std::byte> payload = {std::byte{0x00}, std::byte{0x01}};
-    std::vector<std::byte> certDigest = {std::byte{0x00}};
-    IEEE1609Dot2::Certificate cert;
+    boost::property_tree::ptree tree;
+    boost::property_tree::json_parser::read_json(configPath, tree);
 
-    uint64_t currentTime = Utility::getCurrentTimeAsUint64();
+    auto numMessages = tree.get<int>("scenario.numMessages");
 
-    auto spdu = IEEE1609Dot2Generation::generateSPDU(IEEE1609Dot2::IEEE1609Dot2ContentChoice::signedData,
-                                                     payload,
-                                                     0x20,
-                                                     currentTime,
-                                                     currentTime + (1000*60*60) /*one hour in milliseconds */,
-                                                     IEEE1609Dot2::HashAlgorithm::sha256,
-                                                     IEEE1609Dot2::SignerIdentifierChoice::self,
-                                                     certDigest,
-                                                     cert);
+    PipelineOptions options;
+    long port = numberFromEnvironment("V2X_TEST_PORT", options.port);
+    if(0 < port && port < 65536) {
+        options.port = static_cast<uint16_t>(port);
+    }
+    options.intervalUs = numberFromEnvironment("V2X_TX_INTERVAL_US",
+                                               tree.get<long>("scenario.transmitter.intervalUs", options.intervalUs));
 
-    auto spduBytes = IEEE1609Dot2Generation::encodeSPDU(spdu);
+    const char *keyOverride = std::getenv("V2X_KEY_FILE");
+    std::string pemFilename = keyOverride != nullptr ? std::string(keyOverride) : "../../test_key.pem";
+
+    Vehicle v(43, 75, 100, 100, 40, pemFilename);
 
+    if(std::string(argv[1]) == "transmitter") {
+        v.transmit(numMessages, options);
+    }
+    else {
+        v.receive(numMessages, options);
+    }
 
+    Logger::stopBinaryLog();
+    Logger::stopLog();
 
     return 0;
-}
\ No newline at end of file
+}
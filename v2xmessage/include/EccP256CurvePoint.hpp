@@ -41,6 +41,22 @@ public:
     /** @brief Default constructor */
     EccP256CurvePoint() = default;
 
+    /** @brief Create a new EccP256CurvePoint from a coordinate value.
+     *
+     *  @param curvePointChoice How the point is represented (xOnly, compressedY0 or compressedY1).
+     *  @param value            The x-coordinate of the point as a 32-byte unsigned integer.
+     */
+    EccP256CurvePoint(CurvePointChoice curvePointChoice, const std::vector<std::byte> &value) {
+        if(!isSupportedChoice(curvePointChoice)) {
+            throw std::runtime_error("Only xOnly, compressedY0 and compressedY1 are supported as a CurvePointChoice at this time.");
+        }
+        if(value.size() != ECC_P256_CURVE_POINT_SIZE_BYTES - 1) {
+            throw std::runtime_error("Invalid coordinate (wrong length) provided for EccP256CurvePoint");
+        }
+        this->curvePointChoice = curvePointChoice;
+        this->compressedValue = value;
+    }
+
     /** @brief Create a new ECCP256CurvePoint for a COER-encoded byte string
      *
      *  @param coerBytes COER encoding of an ECCP256CurvePoint object
@@ -57,15 +73,18 @@ public:
             (choiceByte & std::byte{0b11000000}) == std::byte{0b10000000}   // Make sure bit 8 is set and bit 7 is not
         ) {
             if(0 <= choiceTag && choiceTag <= 4) {
-                if (choiceTag == 0) {
+                if (isSupportedChoice((CurvePointChoice) choiceTag)) {
                     this->curvePointChoice = (CurvePointChoice) choiceTag;
                     auto start = coerBytes.begin() + 1;
                     auto end = coerBytes.end();
                     this->compressedValue = std::vector<std::byte>(start, end);
                 }
+                else {
+                    throw std::runtime_error("Only xOnly, compressedY0 and compressedY1 are supported as a CurvePointChoice at this time.");
+                }
             }
             else {
-                throw std::runtime_error("Only xOnly is supported as a CurvePointChoice at this time.");
+                throw std::runtime_error("Invalid CurvePointChoice tag number.");
             }
         }
         else {
@@ -108,6 +127,12 @@ public:
     }
 
 private:
+    /** The choices that carry a single 32-byte coordinate, which is all this class stores. */
+    static bool isSupportedChoice(CurvePointChoice choice) {
+        return choice == CurvePointChoice::xOnly || choice == CurvePointChoice::compressedY0 ||
+               choice == CurvePointChoice::compressedY1;
+    }
+
     CurvePointChoice curvePointChoice;
     std::vector<std::byte> compressedValue;
 };
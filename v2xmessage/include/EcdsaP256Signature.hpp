@@ -29,6 +29,19 @@ public:
     /** @brief Default constructor */
     EcdsaP256Signature() = default;
 
+    /** @brief Create a new EcdsaP256Signature from its r and s values.
+     *
+     *  @param rSig The r value of the signature, encoded as an x-only curve point.
+     *  @param sSig The s value of the signature as a 32-byte unsigned integer.
+     */
+    EcdsaP256Signature(const EccP256CurvePoint &rSig, const std::vector<std::byte> &sSig) {
+        if(sSig.size() != ECDSAP256_SIGNATURE_SIZE_BYTES - EccP256CurvePoint::ECC_P256_CURVE_POINT_SIZE_BYTES) {
+            throw std::runtime_error("Invalid length sSig passed for ECDSAP256Signature");
+        }
+        this->rSig = rSig;
+        this->sSig = sSig;
+    }
+
     /** @brief Create a new EcdsaP256Signature from a COER-encoded byte string
      *
      *  @param coerBytes COER encoding of the structure as a byte string
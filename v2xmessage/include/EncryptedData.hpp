@@ -0,0 +1,118 @@
+/** @file   EncryptedData.hpp
+ *  @brief  Implementation of the EncryptedData ASN.1 structure defined in IEEE 1609.2-2022.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+//EncryptedData ::= SEQUENCE {
+//    recipients SequenceOfRecipientInfo,
+//    ciphertext SymmetricCiphertext
+//}
+//
+//SequenceOfRecipientInfo ::= SEQUENCE OF RecipientInfo
+
+#ifndef V2VERIFIER_ENCRYPTEDDATA_HPP
+#define V2VERIFIER_ENCRYPTEDDATA_HPP
+
+#include "V2XMessage.hpp"
+#include "RecipientInfo.hpp"
+#include "SymmetricCiphertext.hpp"
+
+class EncryptedData : V2XMessage {
+
+public:
+    /** @brief Default constructor. */
+    EncryptedData() = default;
+
+    /** @brief Create a new EncryptedData.
+     *
+     *  @param recipients   One entry per way of recovering the data key (at least one).
+     *  @param ciphertext   The encrypted payload.
+     */
+    EncryptedData(const std::vector<RecipientInfo> &recipients, const SymmetricCiphertext &ciphertext) {
+        if(recipients.empty()) {
+            throw std::runtime_error("EncryptedData needs at least one recipient");
+        }
+        this->recipients = recipients;
+        this->ciphertext = ciphertext;
+    }
+
+    /** @brief Create a new EncryptedData from a COER encoding.
+     *
+     *  @param coerBytes The COER encoding of the object, and nothing after it.
+     */
+    EncryptedData(std::vector<std::byte> &coerBytes) {
+        size_t offset = 0;
+
+        // SEQUENCE OF quantity: a length determinant, then the count in that many octets
+        size_t quantityOctets = Utility::readLengthDeterminant(coerBytes, offset);
+        if(quantityOctets == 0 || quantityOctets > sizeof(uint32_t)) {
+            throw std::runtime_error("Invalid SequenceOfRecipientInfo quantity");
+        }
+        size_t count = 0;
+        for(size_t i = 0; i < quantityOctets; i++) {
+            count = (count << 8) | (uint8_t) coerBytes.at(offset++);
+        }
+        if(count == 0) {
+            throw std::runtime_error("EncryptedData needs at least one recipient");
+        }
+
+        for(size_t i = 0; i < count; i++) {
+            this->recipients.emplace_back(coerBytes, offset);
+        }
+        this->ciphertext = SymmetricCiphertext(coerBytes, offset);
+
+        if(offset != coerBytes.size()) {
+            throw std::runtime_error("Trailing bytes after EncryptedData");
+        }
+    }
+
+    /** @brief Get the COER encoding of the object.
+     *
+     *  @return The COER encoding of the object.
+     */
+    std::vector<std::byte> getCOER() {
+        std::vector<std::byte> coerBytes;
+
+        std::vector<std::byte> quantity;
+        for(size_t remaining = this->recipients.size(); remaining > 0; remaining >>= 8) {
+            quantity.insert(quantity.begin(), std::byte{(uint8_t) remaining});
+        }
+        Utility::appendLengthDeterminant(coerBytes, quantity.size());
+        coerBytes.insert(coerBytes.end(), quantity.begin(), quantity.end());
+
+        for(auto &recipient : this->recipients) {
+            auto recipientBytes = recipient.getCOER();
+            coerBytes.insert(coerBytes.end(), recipientBytes.begin(), recipientBytes.end());
+        }
+
+        auto ciphertextBytes = this->ciphertext.getCOER();
+        coerBytes.insert(coerBytes.end(), ciphertextBytes.begin(), ciphertextBytes.end());
+
+        return coerBytes;
+    }
+
+    /** @brief Get the recipient information.
+     *
+     *  @return One RecipientInfo per way of recovering the data key.
+     */
+    [[nodiscard]] const std::vector<RecipientInfo> &getRecipients() const {
+        return this->recipients;
+    }
+
+    /** @brief Get the encrypted payload.
+     *
+     *  @return The SymmetricCiphertext.
+     */
+    [[nodiscard]] const SymmetricCiphertext &getCiphertext() const {
+        return this->ciphertext;
+    }
+
+private:
+    std::vector<RecipientInfo> recipients;
+    SymmetricCiphertext ciphertext;
+};
+
+#endif //V2VERIFIER_ENCRYPTEDDATA_HPP
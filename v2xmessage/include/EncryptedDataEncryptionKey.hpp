@@ -0,0 +1,207 @@
+/** @file   EncryptedDataEncryptionKey.hpp
+ *  @brief  Implementation of the EncryptedDataEncryptionKey ASN.1 structure defined in IEEE 1609.2-2022.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+//EncryptedDataEncryptionKey ::= CHOICE {
+//    eciesNistP256         EciesP256EncryptedKey,
+//    eciesBrainpoolP256r1  EciesP256EncryptedKey,
+//    ...,
+//    ecencSm2256           EcencP256EncryptedKey
+//}
+//
+//EciesP256EncryptedKey ::= SEQUENCE {
+//    v EccP256CurvePoint,
+//    c OCTET STRING (SIZE (16)),
+//    t OCTET STRING (SIZE (16))
+//}
+//
+// Local extension (not in IEEE 1609.2-2022), encoded as a further extension alternative:
+//
+//    mlKem768              MlKem768EncryptedKey
+//
+//MlKem768EncryptedKey ::= SEQUENCE {
+//    kemCiphertext OCTET STRING (SIZE (1088)),
+//    c OCTET STRING (SIZE (16)),
+//    t OCTET STRING (SIZE (16))
+//}
+
+#ifndef V2VERIFIER_ENCRYPTEDDATAENCRYPTIONKEY_HPP
+#define V2VERIFIER_ENCRYPTEDDATAENCRYPTIONKEY_HPP
+
+#include "V2XMessage.hpp"
+#include "EccP256CurvePoint.hpp"
+
+/** @brief How the data encryption key is encapsulated for the recipient. */
+enum EncryptedDataEncryptionKeyChoice {
+    eciesNistP256,          ///< ECIES over NIST P-256
+    eciesBrainpoolP256r1,   ///< ECIES over brainpoolP256r1
+    ecencSm2256,            ///< SM2 encryption (extension)
+    mlKem768                ///< ML-KEM-768 (local extension)
+};
+
+class EncryptedDataEncryptionKey : V2XMessage {
+
+public:
+    /** @brief Size of the wrapped data encryption key (c) and of its authentication tag (t). */
+    static const uint16_t WRAPPED_KEY_SIZE_BYTES = 16;
+
+    /** @brief Size of an ML-KEM-768 ciphertext. */
+    static const uint16_t ML_KEM_768_CIPHERTEXT_SIZE_BYTES = 1088;
+
+    /** @brief Default constructor. */
+    EncryptedDataEncryptionKey() = default;
+
+    /** @brief Create a new ECIES-encapsulated key.
+     *
+     *  @param choice   eciesNistP256 or eciesBrainpoolP256r1.
+     *  @param v        The sender's ephemeral public key (compressed).
+     *  @param c        The data encryption key, masked (16 bytes).
+     *  @param t        Authentication tag over c (16 bytes).
+     */
+    EncryptedDataEncryptionKey(EncryptedDataEncryptionKeyChoice choice, const EccP256CurvePoint &v,
+                               const std::vector<std::byte> &c, const std::vector<std::byte> &t) {
+        if(choice != EncryptedDataEncryptionKeyChoice::eciesNistP256 &&
+           choice != EncryptedDataEncryptionKeyChoice::eciesBrainpoolP256r1) {
+            throw std::runtime_error("An EccP256CurvePoint only goes with an ECIES EncryptedDataEncryptionKey");
+        }
+        checkWrappedKey(c, t);
+        this->choice = choice;
+        this->v = v;
+        this->c = c;
+        this->t = t;
+    }
+
+    /** @brief Create a new ML-KEM-768-encapsulated key.
+     *
+     *  @param kemCiphertext    The ML-KEM-768 ciphertext (1088 bytes).
+     *  @param c                The data encryption key, masked (16 bytes).
+     *  @param t                Authentication tag over c (16 bytes).
+     */
+    EncryptedDataEncryptionKey(const std::vector<std::byte> &kemCiphertext, const std::vector<std::byte> &c,
+                               const std::vector<std::byte> &t) {
+        if(kemCiphertext.size() != ML_KEM_768_CIPHERTEXT_SIZE_BYTES) {
+            throw std::runtime_error("Invalid length kemCiphertext passed for EncryptedDataEncryptionKey");
+        }
+        checkWrappedKey(c, t);
+        this->choice = EncryptedDataEncryptionKeyChoice::mlKem768;
+        this->kemCiphertext = kemCiphertext;
+        this->c = c;
+        this->t = t;
+    }
+
+    /** @brief Decode an EncryptedDataEncryptionKey from the middle of a COER encoding.
+     *
+     *  @param coerBytes    The COER encoding containing the object.
+     *  @param offset       Position of the object; advanced past it.
+     */
+    EncryptedDataEncryptionKey(const std::vector<std::byte> &coerBytes, size_t &offset) {
+        auto choiceByte = coerBytes.at(offset++);
+        if((choiceByte & std::byte{0b11000000}) != std::byte{0b10000000}) {
+            throw std::runtime_error("Invalid tag value passed to decoder");
+        }
+        auto tag = (uint8_t) (choiceByte & std::byte{0b00111111});
+
+        if(tag == EncryptedDataEncryptionKeyChoice::eciesNistP256 ||
+           tag == EncryptedDataEncryptionKeyChoice::eciesBrainpoolP256r1) {
+            this->choice = (EncryptedDataEncryptionKeyChoice) tag;
+            auto pointBytes = Utility::readOctets(coerBytes, offset, EccP256CurvePoint::ECC_P256_CURVE_POINT_SIZE_BYTES);
+            this->v = EccP256CurvePoint(pointBytes);
+        }
+        else if(tag == EncryptedDataEncryptionKeyChoice::mlKem768) {
+            // extension alternatives are wrapped in an open type
+            size_t length = Utility::readLengthDeterminant(coerBytes, offset);
+            if(length != ML_KEM_768_CIPHERTEXT_SIZE_BYTES + 2 * WRAPPED_KEY_SIZE_BYTES) {
+                throw std::runtime_error("Invalid length mlKem768 EncryptedDataEncryptionKey");
+            }
+            this->choice = EncryptedDataEncryptionKeyChoice::mlKem768;
+            this->kemCiphertext = Utility::readOctets(coerBytes, offset, ML_KEM_768_CIPHERTEXT_SIZE_BYTES);
+        }
+        else {
+            throw std::runtime_error("Unsupported EncryptedDataEncryptionKey type requested.");
+        }
+
+        this->c = Utility::readOctets(coerBytes, offset, WRAPPED_KEY_SIZE_BYTES);
+        this->t = Utility::readOctets(coerBytes, offset, WRAPPED_KEY_SIZE_BYTES);
+    }
+
+    /** @brief Get the COER encoding of the object.
+     *
+     *  @return The COER encoding of the object.
+     */
+    std::vector<std::byte> getCOER() {
+        std::vector<std::byte> coerBytes;
+        coerBytes.push_back(std::byte{0x80} | std::byte{(uint8_t) this->choice});
+
+        if(this->choice == EncryptedDataEncryptionKeyChoice::mlKem768) {
+            Utility::appendLengthDeterminant(coerBytes, this->kemCiphertext.size() + this->c.size() + this->t.size());
+            coerBytes.insert(coerBytes.end(), this->kemCiphertext.begin(), this->kemCiphertext.end());
+        }
+        else {
+            auto pointBytes = this->v.getCOER();
+            coerBytes.insert(coerBytes.end(), pointBytes.begin(), pointBytes.end());
+        }
+        coerBytes.insert(coerBytes.end(), this->c.begin(), this->c.end());
+        coerBytes.insert(coerBytes.end(), this->t.begin(), this->t.end());
+
+        return coerBytes;
+    }
+
+    /** @brief Get how the key is encapsulated.
+     *
+     *  @return The choice for this object.
+     */
+    [[nodiscard]] EncryptedDataEncryptionKeyChoice getChoice() const {
+        return this->choice;
+    }
+
+    /** @brief Get the sender's ephemeral public key (ECIES choices only).
+     *
+     *  @return The ephemeral public key.
+     */
+    [[nodiscard]] EccP256CurvePoint getV() const {
+        return this->v;
+    }
+
+    /** @brief Get the ML-KEM-768 ciphertext (mlKem768 only).
+     *
+     *  @return The KEM ciphertext.
+     */
+    [[nodiscard]] std::vector<std::byte> getKemCiphertext() const {
+        return this->kemCiphertext;
+    }
+
+    /** @brief Get the masked data encryption key.
+     *
+     *  @return c (16 bytes).
+     */
+    [[nodiscard]] std::vector<std::byte> getC() const {
+        return this->c;
+    }
+
+    /** @brief Get the authentication tag over c.
+     *
+     *  @return t (16 bytes).
+     */
+    [[nodiscard]] std::vector<std::byte> getT() const {
+        return this->t;
+    }
+
+private:
+    static void checkWrappedKey(const std::vector<std::byte> &c, const std::vector<std::byte> &t) {
+        if(c.size() != WRAPPED_KEY_SIZE_BYTES || t.size() != WRAPPED_KEY_SIZE_BYTES) {
+            throw std::runtime_error("Invalid length c or t passed for EncryptedDataEncryptionKey");
+        }
+    }
+
+    EncryptedDataEncryptionKeyChoice choice;
+    EccP256CurvePoint v;
+    std::vector<std::byte> kemCiphertext;
+    std::vector<std::byte> c;
+    std::vector<std::byte> t;
+};
+
+#endif //V2VERIFIER_ENCRYPTEDDATAENCRYPTIONKEY_HPP
@@ -36,6 +36,15 @@ public:
     /** @brief Default constructor. */
     HeaderInfo() = default;
 
+    /** @brief Create a new HeaderInfo from its field values.
+     *
+     *  @param psid             The service identifier (0x20 for BSM safety service).
+     *  @param generationTime   Generation time in milliseconds.
+     *  @param expiryTime       Expiration time in milliseconds.
+     */
+    HeaderInfo(uint32_t psid, uint64_t generationTime, uint64_t expiryTime)
+        : psid(psid), generationTime(generationTime), expiryTime(expiryTime) {}
+
     /** @brief Create a new HeaderInfo from a COER-encoded byte string */
     HeaderInfo(std::vector<std::byte> &coerBytes) {
 
@@ -9,6 +9,7 @@
 #ifndef V2VERIFIER_IEEE1609DOT2CONTENT_HPP
 #define V2VERIFIER_IEEE1609DOT2CONTENT_HPP
 
+#include "EncryptedData.hpp"
 #include "SignedData.hpp"
 #include "V2XMessage.hpp"
 #include "UnsecuredData.hpp"
@@ -27,6 +28,27 @@ public:
     /** @brief Default constructor. */
     IEEE1609Dot2Content() = default;
 
+    /** @brief Create a new IEEE1609Dot2Content carrying signed data.
+     *
+     *  @param signedData The SignedData to encapsulate.
+     */
+    explicit IEEE1609Dot2Content(const SignedData &signedData)
+        : contentChoice(IEEE1609Dot2ContentChoice::signedData), signedData(signedData) {}
+
+    /** @brief Create a new IEEE1609Dot2Content carrying unsecured data.
+     *
+     *  @param unsecuredData The UnsecuredData to encapsulate.
+     */
+    explicit IEEE1609Dot2Content(const UnsecuredData &unsecuredData)
+        : contentChoice(IEEE1609Dot2ContentChoice::unsecuredData), unsecuredData(unsecuredData) {}
+
+    /** @brief Create a new IEEE1609Dot2Content carrying encrypted data.
+     *
+     *  @param encryptedData The EncryptedData to encapsulate.
+     */
+    explicit IEEE1609Dot2Content(const EncryptedData &encryptedData)
+        : contentChoice(IEEE1609Dot2ContentChoice::encryptedData), encryptedData(encryptedData) {}
+
     /** @brief  Create a new IEEE1609Dot2Content from a COER-encoded byte string.
      *
      *  @param coerBytes The COER encoding use to create the object.
@@ -53,9 +75,11 @@ public:
                     case IEEE1609Dot2ContentChoice::signedData:
                         this->signedData = SignedData(newCOER);
                         break;
-
-                        // For now, we only support unsecuredData and signedData. TODO: eventually - implement other types.
                     case IEEE1609Dot2ContentChoice::encryptedData:
+                        this->encryptedData = EncryptedData(newCOER);
+                        break;
+
+                        // TODO: eventually - implement signedCertificateRequest.
                     case IEEE1609Dot2ContentChoice::signedCertificateRequest:
                     default:
                         throw   std::runtime_error("Unsupported IEEE1609Dot2Content type requested.");
@@ -88,19 +112,55 @@ public:
 
             return coerBytes;
         }
+        else if(this->contentChoice == IEEE1609Dot2ContentChoice::encryptedData) {
+            coerBytes.push_back(std::byte{0x80} | std::byte{(uint8_t) IEEE1609Dot2ContentChoice::encryptedData});
+            auto contentBytes = this->encryptedData.getCOER();
+            coerBytes.insert(coerBytes.end(), contentBytes.begin(), contentBytes.end());
+
+            return coerBytes;
+        }
         else {
             throw std::runtime_error("Somehow this got an invalid content type. Aborting.");
         }
     }
 
+    /** @brief Get the type of content contained in this object.
+     *
+     *  @return The content choice for this object.
+     */
     [[nodiscard]] IEEE1609Dot2ContentChoice getContentChoice() const {
         return this->contentChoice;
     }
 
+    /** @brief Get the encapsulated SignedData (only meaningful when the content choice is signedData).
+     *
+     *  @return The SignedData contained in this object.
+     */
+    [[nodiscard]] SignedData getSignedData() const {
+        return this->signedData;
+    }
+
+    /** @brief Get the encapsulated UnsecuredData (only meaningful when the content choice is unsecuredData).
+     *
+     *  @return The UnsecuredData contained in this object.
+     */
+    [[nodiscard]] UnsecuredData getUnsecuredData() const {
+        return this->unsecuredData;
+    }
+
+    /** @brief Get the encapsulated EncryptedData (only meaningful when the content choice is encryptedData).
+     *
+     *  @return The EncryptedData contained in this object.
+     */
+    [[nodiscard]] const EncryptedData &getEncryptedData() const {
+        return this->encryptedData;
+    }
+
 private:
     IEEE1609Dot2ContentChoice contentChoice;
     SignedData signedData;
     UnsecuredData unsecuredData;
+    EncryptedData encryptedData;
 };
 
 #endif //V2VERIFIER_IEEE1609DOT2CONTENT_HPP
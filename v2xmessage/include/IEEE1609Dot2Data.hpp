@@ -19,6 +19,12 @@ public:
     /** @brief Default constructor. */
     IEEE1609Dot2Data() = default;
 
+    /** @brief Create a new IEEE1609Dot2Data (protocol version 3) for the given content.
+     *
+     *  @param content The content of the SPDU.
+     */
+    explicit IEEE1609Dot2Data(const IEEE1609Dot2Content &content) : protocolVersion(0x03), content(content) {}
+
     /** @brief Create a new IEEE1609Dot2Data from a COER-encoded byte string
      *
      *  @param coerBytes The COER-encoded byte string used to create the object.
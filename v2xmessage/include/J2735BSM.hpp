@@ -8,15 +8,94 @@
 #include "V2XMessage.hpp"
 #include <vector>
 
+//BSMcoreData ::= SEQUENCE {
+//    msgCnt    MsgCount,
+//    id        TemporaryID,
+//    secMark   DSecond,
+//    lat       Latitude,
+//    long      Longitude,
+//    elev      Elevation,
+//    ...
+//    speed     Speed,
+//    heading   Heading,
+//    ...
+//}
+
+/** @brief  The BSMcoreData fields of an SAE J2735 Basic Safety Message.
+ *
+ *  Only the position and motion fields used by the testbed are carried. Each field is stored in its J2735 unit and
+ *  encoded as a fixed-width integer, in the same way as the other structures in this library.
+ */
 class J2735BSM : V2XMessage {
 
 public:
 
+    /** @brief Size of the encoding of this object (in bytes). */
+    static const uint16_t BSM_SIZE_BYTES = 23;
+
+    /** @brief Default constructor. */
     J2735BSM() = default;
 
+    /** @brief Create a new J2735BSM from vehicle state, converting each value to its J2735 unit.
+     *
+     *  @param msgCount     Message sequence number (wraps at 128).
+     *  @param temporaryId  Temporary vehicle identifier.
+     *  @param secMark      Milliseconds within the current minute.
+     *  @param latitude     Latitude in degrees.
+     *  @param longitude    Longitude in degrees.
+     *  @param elevation    Elevation in meters.
+     *  @param speed        Speed in meters per second.
+     *  @param heading      Heading in degrees.
+     */
+    J2735BSM(uint8_t msgCount, uint32_t temporaryId, uint16_t secMark, double latitude, double longitude,
+             double elevation, double speed, double heading);
+
+    /** @brief Create a new J2735BSM from its encoding.
+     *
+     *  @param coerBytes The encoding from which to create the object.
+     */
+    J2735BSM(const std::vector<std::byte> &coerBytes);
 
+    /** @brief Get the encoding of this object.
+     *
+     *  @return The encoding of the object.
+     */
     std::vector<std::byte> getCOER();
 
+    /** @brief Get the message count. */
+    [[nodiscard]] uint8_t getMsgCount() const { return this->msgCount; }
+
+    /** @brief Get the temporary identifier. */
+    [[nodiscard]] uint32_t getTemporaryId() const { return this->temporaryId; }
+
+    /** @brief Get the milliseconds within the current minute. */
+    [[nodiscard]] uint16_t getSecMark() const { return this->secMark; }
+
+    /** @brief Get the latitude in degrees. */
+    [[nodiscard]] double getLatitude() const;
+
+    /** @brief Get the longitude in degrees. */
+    [[nodiscard]] double getLongitude() const;
+
+    /** @brief Get the elevation in meters. */
+    [[nodiscard]] double getElevation() const;
+
+    /** @brief Get the speed in meters per second. */
+    [[nodiscard]] double getSpeed() const;
+
+    /** @brief Get the heading in degrees. */
+    [[nodiscard]] double getHeading() const;
+
+private:
+    uint8_t msgCount = 0;       // 0..127
+    uint32_t temporaryId = 0;
+    uint16_t secMark = 0;       // milliseconds, 0..59999
+    int32_t latitude = 0;       // 1/10 microdegree
+    int32_t longitude = 0;      // 1/10 microdegree
+    int32_t elevation = 0;      // 0.1 m
+    uint16_t speed = 0;         // 0.02 m/s
+    uint16_t heading = 0;       // 0.0125 degrees
+
 };
 
 
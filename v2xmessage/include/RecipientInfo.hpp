@@ -0,0 +1,151 @@
+/** @file   RecipientInfo.hpp
+ *  @brief  Implementation of the RecipientInfo ASN.1 structure defined in IEEE 1609.2-2022.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+//RecipientInfo ::= CHOICE {
+//    pskRecipInfo        PreSharedKeyRecipientInfo,
+//    symmRecipInfo       SymmRecipientInfo,
+//    certRecipInfo       PKRecipientInfo,
+//    signedDataRecipInfo PKRecipientInfo,
+//    rekRecipInfo        PKRecipientInfo
+//}
+//
+//PreSharedKeyRecipientInfo ::= HashedId8
+//
+//PKRecipientInfo ::= SEQUENCE {
+//    recipientId HashedId8,
+//    encKey      EncryptedDataEncryptionKey
+//}
+
+#ifndef V2VERIFIER_RECIPIENTINFO_HPP
+#define V2VERIFIER_RECIPIENTINFO_HPP
+
+#include "V2XMessage.hpp"
+#include "EncryptedDataEncryptionKey.hpp"
+
+/** @brief How the recipient finds the data encryption key. */
+enum RecipientInfoChoice {
+    pskRecipInfo,           ///< a pre-shared (or previously received) symmetric key, identified by its HashedId8
+    symmRecipInfo,          ///< the data key encrypted with a symmetric key
+    certRecipInfo,          ///< the data key encapsulated to the public key in a certificate
+    signedDataRecipInfo,    ///< the data key encapsulated to a key from a signed SPDU
+    rekRecipInfo            ///< the data key encapsulated to a response encryption key
+};
+
+class RecipientInfo : V2XMessage {
+
+public:
+    /** @brief Size of a HashedId8 */
+    static const uint16_t HASHED_ID8_SIZE_BYTES = 8;
+
+    /** @brief Default constructor. */
+    RecipientInfo() = default;
+
+    /** @brief Create a pskRecipInfo naming a symmetric key the recipient already holds.
+     *
+     *  @param keyId    HashedId8 of the symmetric key.
+     */
+    explicit RecipientInfo(const std::vector<std::byte> &keyId) {
+        checkHashedId8(keyId);
+        this->choice = RecipientInfoChoice::pskRecipInfo;
+        this->recipientId = keyId;
+    }
+
+    /** @brief Create a PKRecipientInfo carrying the data key encapsulated to one recipient.
+     *
+     *  @param choice       certRecipInfo, signedDataRecipInfo or rekRecipInfo.
+     *  @param recipientId  HashedId8 of the recipient's certificate or public key.
+     *  @param encKey       The encapsulated data key.
+     */
+    RecipientInfo(RecipientInfoChoice choice, const std::vector<std::byte> &recipientId,
+                  const EncryptedDataEncryptionKey &encKey) {
+        if(choice == RecipientInfoChoice::pskRecipInfo || choice == RecipientInfoChoice::symmRecipInfo) {
+            throw std::runtime_error("An EncryptedDataEncryptionKey only goes with a PKRecipientInfo");
+        }
+        checkHashedId8(recipientId);
+        this->choice = choice;
+        this->recipientId = recipientId;
+        this->encKey = encKey;
+    }
+
+    /** @brief Decode a RecipientInfo from the middle of a COER encoding.
+     *
+     *  @param coerBytes    The COER encoding containing the object.
+     *  @param offset       Position of the object; advanced past it.
+     */
+    RecipientInfo(const std::vector<std::byte> &coerBytes, size_t &offset) {
+        auto choiceByte = coerBytes.at(offset++);
+        if((choiceByte & std::byte{0b11000000}) != std::byte{0b10000000}) {
+            throw std::runtime_error("Invalid tag value passed to decoder");
+        }
+        auto tag = (uint8_t) (choiceByte & std::byte{0b00111111});
+        if(tag > RecipientInfoChoice::rekRecipInfo) {
+            throw std::out_of_range("Invalid choice tag number");
+        }
+        if(tag == RecipientInfoChoice::symmRecipInfo) {
+            throw std::runtime_error("Unsupported RecipientInfo type requested.");
+        }
+
+        this->choice = (RecipientInfoChoice) tag;
+        this->recipientId = Utility::readOctets(coerBytes, offset, HASHED_ID8_SIZE_BYTES);
+        if(this->choice != RecipientInfoChoice::pskRecipInfo) {
+            this->encKey = EncryptedDataEncryptionKey(coerBytes, offset);
+        }
+    }
+
+    /** @brief Get the COER encoding of the object.
+     *
+     *  @return The COER encoding of the object.
+     */
+    std::vector<std::byte> getCOER() {
+        std::vector<std::byte> coerBytes;
+        coerBytes.push_back(std::byte{0x80} | std::byte{(uint8_t) this->choice});
+        coerBytes.insert(coerBytes.end(), this->recipientId.begin(), this->recipientId.end());
+        if(this->choice != RecipientInfoChoice::pskRecipInfo) {
+            auto keyBytes = this->encKey.getCOER();
+            coerBytes.insert(coerBytes.end(), keyBytes.begin(), keyBytes.end());
+        }
+        return coerBytes;
+    }
+
+    /** @brief Get the type of recipient information.
+     *
+     *  @return The choice for this object.
+     */
+    [[nodiscard]] RecipientInfoChoice getChoice() const {
+        return this->choice;
+    }
+
+    /** @brief Get the HashedId8 of the recipient (PKRecipientInfo) or of the symmetric key (pskRecipInfo).
+     *
+     *  @return The 8-byte identifier.
+     */
+    [[nodiscard]] std::vector<std::byte> getRecipientId() const {
+        return this->recipientId;
+    }
+
+    /** @brief Get the encapsulated data key (PKRecipientInfo choices only).
+     *
+     *  @return The EncryptedDataEncryptionKey for this recipient.
+     */
+    [[nodiscard]] EncryptedDataEncryptionKey getEncKey() const {
+        return this->encKey;
+    }
+
+private:
+    static void checkHashedId8(const std::vector<std::byte> &id) {
+        if(id.size() != HASHED_ID8_SIZE_BYTES) {
+            throw std::runtime_error("Invalid length HashedId8 passed for RecipientInfo");
+        }
+    }
+
+    RecipientInfoChoice choice;
+    std::vector<std::byte> recipientId;
+    EncryptedDataEncryptionKey encKey;
+};
+
+#endif //V2VERIFIER_RECIPIENTINFO_HPP
@@ -45,6 +45,13 @@ public:
     /** @brief Default constructor. */
     Signature() = default;
 
+    /** @brief Create a new ECDSA NIST P.256 Signature.
+     *
+     *  @param ecdsaP256Signature The signature value.
+     */
+    explicit Signature(const EcdsaP256Signature &ecdsaP256Signature)
+        : signatureChoice(SignatureChoice::ecdsaNistP256Signature), ecdsaP256Signature(ecdsaP256Signature) {}
+
     /** @brief Create a new Signature using a COER-encoded byte string.
      *
      * @param coerBytes The COER encoding from which to create the object.
@@ -27,6 +27,19 @@ public:
     /** @brief Default constructor. */
     SignedData() = default;
 
+    /** @brief Create a new SignedData from its components.
+     *
+     *  @param hashID       The hash algorithm used to generate the signature.
+     *  @param tbsData      The signed data.
+     *  @param signer       The identity of the signer.
+     *  @param signature    The signature over \p tbsData.
+     */
+    SignedData(IEEE1609Dot2DataTypes::HashAlgorithm hashID,
+               const ToBeSignedData &tbsData,
+               const SignerIdentifier &signer,
+               const Signature &signature)
+        : hashID(hashID), tbsData(tbsData), signer(signer), signature(signature) {}
+
     /** @brief Create a new SignedData from a COER encoding
      *
      *  @param coerBytes The COER encoding from which to create this object.
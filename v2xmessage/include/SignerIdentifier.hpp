@@ -36,6 +36,17 @@ public:
     /** @brief Defaul constructor */
     SignerIdentifier() = default;
 
+    /** @brief Create a new SignerIdentifier for a given choice of identifier.
+     *
+     *  @param signerIdentifierChoice How the signer identifies itself (only self is supported at this time).
+     */
+    explicit SignerIdentifier(SignerIdentifierChoice signerIdentifierChoice) {
+        if(signerIdentifierChoice != SignerIdentifierChoice::self) {
+            throw std::runtime_error("Invalid SignerIdentifier, only self-signed supported at this time.");
+        }
+        this->signerIdentifierChoice = signerIdentifierChoice;
+    }
+
     /** @brief Create a new SignerIdentifier from a COER encoding.
      *
      *  @param coerBytes The COER encoding from which to create a new object.
@@ -0,0 +1,140 @@
+/** @file   SymmetricCiphertext.hpp
+ *  @brief  Implementation of the SymmetricCiphertext ASN.1 structure defined in IEEE 1609.2-2022.
+ *
+ *  @author Geoff Twardokus
+ *
+ *  @bug    No known bugs.
+ */
+
+//SymmetricCiphertext ::= CHOICE {
+//    aes128ccm   One28BitCcmCiphertext,
+//    ...,
+//    sm4Ccm      One28BitCcmCiphertext
+//}
+//
+//One28BitCcmCiphertext ::= SEQUENCE {
+//    nonce         OCTET STRING (SIZE (12)),
+//    ccmCiphertext Opaque
+//}
+//
+// Local extension (not in IEEE 1609.2-2022), encoded as a further extension alternative with the same contents:
+//
+//    aes128Gcm   One28BitCcmCiphertext
+
+#ifndef V2VERIFIER_SYMMETRICCIPHERTEXT_HPP
+#define V2VERIFIER_SYMMETRICCIPHERTEXT_HPP
+
+#include "V2XMessage.hpp"
+
+/** @brief The symmetric algorithm that encrypted the payload. */
+enum SymmetricCiphertextChoice {
+    aes128Ccm,      ///< AES-128 in CCM mode
+    sm4Ccm,         ///< SM4 in CCM mode (extension)
+    aes128Gcm       ///< AES-128 in GCM mode (local extension)
+};
+
+class SymmetricCiphertext : V2XMessage {
+
+public:
+    /** @brief Size of the nonce. */
+    static const uint16_t NONCE_SIZE_BYTES = 12;
+
+    /** @brief Default constructor. */
+    SymmetricCiphertext() = default;
+
+    /** @brief Create a new SymmetricCiphertext.
+     *
+     *  @param choice       The algorithm used.
+     *  @param nonce        The nonce (12 bytes).
+     *  @param ciphertext   The ciphertext followed by the authentication tag.
+     */
+    SymmetricCiphertext(SymmetricCiphertextChoice choice, const std::vector<std::byte> &nonce,
+                        const std::vector<std::byte> &ciphertext) {
+        if(nonce.size() != NONCE_SIZE_BYTES) {
+            throw std::runtime_error("Invalid length nonce passed for SymmetricCiphertext");
+        }
+        this->choice = choice;
+        this->nonce = nonce;
+        this->ciphertext = ciphertext;
+    }
+
+    /** @brief Decode a SymmetricCiphertext from the middle of a COER encoding.
+     *
+     *  @param coerBytes    The COER encoding containing the object.
+     *  @param offset       Position of the object; advanced past it.
+     */
+    SymmetricCiphertext(const std::vector<std::byte> &coerBytes, size_t &offset) {
+        auto choiceByte = coerBytes.at(offset++);
+        if((choiceByte & std::byte{0b11000000}) != std::byte{0b10000000}) {
+            throw std::runtime_error("Invalid tag value passed to decoder");
+        }
+        auto tag = (uint8_t) (choiceByte & std::byte{0b00111111});
+        if(tag > SymmetricCiphertextChoice::aes128Gcm) {
+            throw std::out_of_range("Invalid choice tag number");
+        }
+        this->choice = (SymmetricCiphertextChoice) tag;
+
+        size_t end = 0;
+        if(this->choice != SymmetricCiphertextChoice::aes128Ccm) {
+            // extension alternatives are wrapped in an open type
+            size_t length = Utility::readLengthDeterminant(coerBytes, offset);
+            end = offset + length;
+        }
+        this->nonce = Utility::readOctets(coerBytes, offset, NONCE_SIZE_BYTES);
+        size_t length = Utility::readLengthDeterminant(coerBytes, offset);
+        this->ciphertext = Utility::readOctets(coerBytes, offset, length);
+        if(end != 0 && offset != end) {
+            throw std::runtime_error("Invalid length SymmetricCiphertext extension");
+        }
+    }
+
+    /** @brief Get the COER encoding of the object.
+     *
+     *  @return The COER encoding of the object.
+     */
+    std::vector<std::byte> getCOER() {
+        std::vector<std::byte> contents;
+        contents.insert(contents.end(), this->nonce.begin(), this->nonce.end());
+        Utility::appendLengthDeterminant(contents, this->ciphertext.size());
+        contents.insert(contents.end(), this->ciphertext.begin(), this->ciphertext.end());
+
+        std::vector<std::byte> coerBytes;
+        coerBytes.push_back(std::byte{0x80} | std::byte{(uint8_t) this->choice});
+        if(this->choice != SymmetricCiphertextChoice::aes128Ccm) {
+            Utility::appendLengthDeterminant(coerBytes, contents.size());
+        }
+        coerBytes.insert(coerBytes.end(), contents.begin(), contents.end());
+        return coerBytes;
+    }
+
+    /** @brief Get the algorithm used.
+     *
+     *  @return The choice for this object.
+     */
+    [[nodiscard]] SymmetricCiphertextChoice getChoice() const {
+        return this->choice;
+    }
+
+    /** @brief Get the nonce.
+     *
+     *  @return The nonce (12 bytes).
+     */
+    [[nodiscard]] std::vector<std::byte> getNonce() const {
+        return this->nonce;
+    }
+
+    /** @brief Get the ciphertext, which ends with the authentication tag.
+     *
+     *  @return The ciphertext.
+     */
+    [[nodiscard]] const std::vector<std::byte> &getCiphertext() const {
+        return this->ciphertext;
+    }
+
+private:
+    SymmetricCiphertextChoice choice;
+    std::vector<std::byte> nonce;
+    std::vector<std::byte> ciphertext;
+};
+
+#endif //V2VERIFIER_SYMMETRICCIPHERTEXT_HPP
@@ -25,6 +25,14 @@ public:
     /** @brief Default constructor. */
     ToBeSignedData() = default;
 
+    /** @brief Create a new ToBeSignedData from its components.
+     *
+     *  @param payload      The data to be signed.
+     *  @param headerInfo   The header information for the data.
+     */
+    ToBeSignedData(const SignedDataPayload &payload, const HeaderInfo &headerInfo)
+        : payload(payload), headerInfo(headerInfo) {}
+
     /** @brief Create a new ToBeSignedData from a COER encoding.
      *
      *  @param coerBytes The COER encoding from which to create a new object.
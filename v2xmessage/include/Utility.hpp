@@ -11,6 +11,7 @@
 
 #include <cstring>
 #include <random>
+#include <stdexcept>
 #include <vector>
 
 //! Utility functions to be reused throughout the project.
@@ -67,6 +68,67 @@ namespace Utility {
         return randomBytes;
     }
 
+    /** @brief Append a COER length determinant (ITU-T Rec. X.696 Clause 8.6) to a byte string.
+     *
+     *  @param coerBytes    The byte string to append to.
+     *  @param length       The length to encode: one octet below 128, otherwise 0x80 | n followed by n octets.
+     */
+    inline void appendLengthDeterminant(std::vector<std::byte> &coerBytes, size_t length) {
+        if(length < 128) {
+            coerBytes.push_back(std::byte{(uint8_t) length});
+            return;
+        }
+        uint8_t octets = 0;
+        for(size_t remaining = length; remaining > 0; remaining >>= 8) {
+            octets++;
+        }
+        coerBytes.push_back(std::byte{0x80} | std::byte{octets});
+        for(int shift = (octets - 1) * 8; shift >= 0; shift -= 8) {
+            coerBytes.push_back(std::byte{(uint8_t) (length >> shift)});
+        }
+    }
+
+    /** @brief Read a COER length determinant and check that that many octets follow it.
+     *
+     *  @param coerBytes    The byte string to read from.
+     *  @param offset       Position of the determinant; advanced past it.
+     *  @return The decoded length.
+     */
+    inline size_t readLengthDeterminant(const std::vector<std::byte> &coerBytes, size_t &offset) {
+        auto first = (uint8_t) coerBytes.at(offset++);
+        size_t length = first;
+        if(first & 0x80) {
+            uint8_t octets = first & 0x7F;
+            if(octets == 0 || octets > sizeof(size_t)) {
+                throw std::runtime_error("Invalid COER length determinant");
+            }
+            length = 0;
+            for(uint8_t i = 0; i < octets; i++) {
+                length = (length << 8) | (uint8_t) coerBytes.at(offset++);
+            }
+        }
+        if(length > coerBytes.size() - offset) {
+            throw std::runtime_error("COER length determinant runs past the end of the encoding");
+        }
+        return length;
+    }
+
+    /** @brief Copy \p n octets out of a byte string.
+     *
+     *  @param coerBytes    The byte string to read from.
+     *  @param offset       Position of the first octet; advanced past the last one.
+     *  @param n            Number of octets to copy.
+     *  @return The \p n octets.
+     */
+    inline std::vector<std::byte> readOctets(const std::vector<std::byte> &coerBytes, size_t &offset, size_t n) {
+        if(n > coerBytes.size() || offset > coerBytes.size() - n) {
+            throw std::runtime_error("COER encoding is too short");
+        }
+        std::vector<std::byte> octets(coerBytes.begin() + offset, coerBytes.begin() + offset + n);
+        offset += n;
+        return octets;
+    }
+
     static uint64_t getCurrentTimeAsUint64() {
         auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
         uint64_t generationTime = now.time_since_epoch().count();
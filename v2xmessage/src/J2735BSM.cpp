@@ -2,5 +2,80 @@
 // Created by Geoff Twardokus on 4/22/24.
 //
 
+#include <cmath>
+
 #include "../include/J2735BSM.hpp"
 
+J2735BSM::J2735BSM(uint8_t msgCount, uint32_t temporaryId, uint16_t secMark, double latitude, double longitude,
+                   double elevation, double speed, double heading) {
+    this->msgCount = msgCount % 128;
+    this->temporaryId = temporaryId;
+    this->secMark = secMark;
+    this->latitude = (int32_t) std::lround(latitude * 1e7);
+    this->longitude = (int32_t) std::lround(longitude * 1e7);
+    this->elevation = (int32_t) std::lround(elevation * 10);
+    this->speed = (uint16_t) std::lround(speed / 0.02);
+    this->heading = (uint16_t) std::lround(heading / 0.0125);
+}
+
+J2735BSM::J2735BSM(const std::vector<std::byte> &coerBytes) {
+    if(coerBytes.size() != BSM_SIZE_BYTES) {
+        throw std::runtime_error("Invalid COER (wrong length) for a J2735BSM.");
+    }
+
+    const std::byte *cursor = coerBytes.data();
+    auto read = [&cursor](auto &field) {
+        std::memcpy(&field, cursor, sizeof(field));
+        cursor += sizeof(field);
+    };
+
+    read(this->msgCount);
+    read(this->temporaryId);
+    read(this->secMark);
+    read(this->latitude);
+    read(this->longitude);
+    read(this->elevation);
+    read(this->speed);
+    read(this->heading);
+}
+
+std::vector<std::byte> J2735BSM::getCOER() {
+    std::vector<std::byte> coerBytes(BSM_SIZE_BYTES);
+
+    std::byte *cursor = coerBytes.data();
+    auto write = [&cursor](const auto &field) {
+        std::memcpy(cursor, &field, sizeof(field));
+        cursor += sizeof(field);
+    };
+
+    write(this->msgCount);
+    write(this->temporaryId);
+    write(this->secMark);
+    write(this->latitude);
+    write(this->longitude);
+    write(this->elevation);
+    write(this->speed);
+    write(this->heading);
+
+    return coerBytes;
+}
+
+double J2735BSM::getLatitude() const {
+    return this->latitude / 1e7;
+}
+
+double J2735BSM::getLongitude() const {
+    return this->longitude / 1e7;
+}
+
+double J2735BSM::getElevation() const {
+    return this->elevation / 10.0;
+}
+
+double J2735BSM::getSpeed() const {
+    return this->speed * 0.02;
+}
+
+double J2735BSM::getHeading() const {
+    return this->heading * 0.0125;
+}
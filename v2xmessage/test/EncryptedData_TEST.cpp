@@ -0,0 +1,82 @@
+//
+// Round trips of EncryptedData through its COER encoding, on its own and inside an IEEE1609Dot2Content.
+//
+
+#include "../include/IEEE1609Dot2Content.hpp"
+
+#include <vector>
+
+
+int main() {
+
+    auto recipientId = Utility::randomBytesOfLength(8);
+    auto c = Utility::randomBytesOfLength(16);
+    auto t = Utility::randomBytesOfLength(16);
+
+    EccP256CurvePoint v(CurvePointChoice::compressedY1, Utility::randomBytesOfLength(32));
+    EncryptedDataEncryptionKey eciesKey(EncryptedDataEncryptionKeyChoice::eciesNistP256, v, c, t);
+    EncryptedDataEncryptionKey kemKey(Utility::randomBytesOfLength(1088), c, t);
+
+    std::vector<RecipientInfo> recipients;
+    recipients.emplace_back(RecipientInfoChoice::certRecipInfo, recipientId, eciesKey);
+    recipients.emplace_back(RecipientInfoChoice::certRecipInfo, recipientId, kemKey);
+    recipients.emplace_back(Utility::randomBytesOfLength(8));
+
+    auto nonce = Utility::randomBytesOfLength(12);
+    auto payload = Utility::randomBytesOfLength(300);
+    EncryptedData ccm(recipients, SymmetricCiphertext(SymmetricCiphertextChoice::aes128Ccm, nonce, payload));
+
+    auto coer = ccm.getCOER();
+    EncryptedData decoded(coer);
+
+    if(decoded.getRecipients().size() != 3)
+        return 1;
+
+    auto decodedEcies = decoded.getRecipients()[0].getEncKey();
+    if(decodedEcies.getChoice() != EncryptedDataEncryptionKeyChoice::eciesNistP256 ||
+       decodedEcies.getV().getCurvePointChoice() != CurvePointChoice::compressedY1 ||
+       decodedEcies.getC() != c || decodedEcies.getT() != t)
+        return 2;
+
+    auto decodedKem = decoded.getRecipients()[1].getEncKey();
+    if(decodedKem.getChoice() != EncryptedDataEncryptionKeyChoice::mlKem768 ||
+       decodedKem.getKemCiphertext() != kemKey.getKemCiphertext())
+        return 3;
+
+    if(decoded.getRecipients()[2].getChoice() != RecipientInfoChoice::pskRecipInfo ||
+       decoded.getRecipients()[2].getRecipientId() != recipients[2].getRecipientId())
+        return 4;
+
+    if(decoded.getCiphertext().getNonce() != nonce || decoded.getCiphertext().getCiphertext() != payload)
+        return 5;
+
+    if(decoded.getCOER() != coer)
+        return 6;
+
+    // the GCM extension alternative inside an IEEE1609Dot2Content
+    EncryptedData gcm(recipients, SymmetricCiphertext(SymmetricCiphertextChoice::aes128Gcm, nonce, payload));
+    IEEE1609Dot2Content content(gcm);
+    auto contentCoer = content.getCOER();
+    IEEE1609Dot2Content decodedContent(contentCoer);
+
+    if(decodedContent.getContentChoice() != IEEE1609Dot2ContentChoice::encryptedData)
+        return 7;
+
+    if(decodedContent.getEncryptedData().getCiphertext().getChoice() != SymmetricCiphertextChoice::aes128Gcm ||
+       decodedContent.getEncryptedData().getCiphertext().getCiphertext() != payload)
+        return 8;
+
+    if(decodedContent.getCOER() != contentCoer)
+        return 9;
+
+    // truncated encodings are rejected rather than read past the end
+    auto truncated = std::vector<std::byte>(coer.begin(), coer.end() - 1);
+    try {
+        EncryptedData bad(truncated);
+        return 10;
+    }
+    catch(std::exception &e) {
+    }
+
+    return 0;
+}
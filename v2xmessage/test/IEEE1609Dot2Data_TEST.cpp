@@ -30,7 +30,38 @@ int main() {
 
     // SignedData test
 
-    // TODO implement this
+    auto payloadBytes = Utility::randomBytesOfLength(40);
+    uint64_t generationTime = Utility::getCurrentTimeAsUint64();
+
+    SignedData signedData(IEEE1609Dot2DataTypes::HashAlgorithm::sha256,
+                          ToBeSignedData(SignedDataPayload(payloadBytes),
+                                         HeaderInfo(0x20, generationTime, generationTime + 100000)),
+                          SignerIdentifier(SignerIdentifierChoice::self),
+                          Signature(EcdsaP256Signature(EccP256CurvePoint(CurvePointChoice::xOnly,
+                                                                         Utility::randomBytesOfLength(32)),
+                                                       Utility::randomBytesOfLength(32))));
+
+    IEEE1609Dot2Data s{IEEE1609Dot2Content(signedData)};
+    auto signedBytes = s.getCOER();
+
+    IEEE1609Dot2Data decoded(signedBytes);
+
+    if(decoded.getCOER() != signedBytes)
+        return 3;
+
+    if(decoded.getContent().getContentChoice() != IEEE1609Dot2ContentChoice::signedData)
+        return 4;
+
+    auto decodedTbsData = decoded.getContent().getSignedData().getTbsData();
+    if(decodedTbsData.getPayload().getData() != payloadBytes)
+        return 5;
+
+    if(decodedTbsData.getHeaderInfo().getPsid() != 0x20 ||
+       decodedTbsData.getHeaderInfo().getGenerationTime() != generationTime)
+        return 6;
+
+    if(decoded.getContent().getSignedData().getSignature().getCOER() != signedData.getSignature().getCOER())
+        return 7;
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,45 @@
+//
+// Created by Geoff Twardokus on 4/22/24.
+//
+
+#include <cmath>
+
+#include "../include/J2735BSM.hpp"
+
+int main() {
+
+    J2735BSM bsm(130, 0xDEADBEEF, 42123, 42.3601, -71.0589, 12.3, 27.5, 271.25);
+
+    // msgCnt wraps at 128
+    if(bsm.getMsgCount() != 2)
+        return 1;
+
+    auto coerBytes = bsm.getCOER();
+    if(coerBytes.size() != J2735BSM::BSM_SIZE_BYTES)
+        return 2;
+
+    J2735BSM decoded(coerBytes);
+
+    if(decoded.getCOER() != coerBytes)
+        return 3;
+
+    if(decoded.getTemporaryId() != 0xDEADBEEF || decoded.getSecMark() != 42123)
+        return 4;
+
+    if(std::fabs(decoded.getLatitude() - 42.3601) > 1e-7 || std::fabs(decoded.getLongitude() + 71.0589) > 1e-7)
+        return 5;
+
+    if(std::fabs(decoded.getElevation() - 12.3) > 0.1 || std::fabs(decoded.getSpeed() - 27.5) > 0.02 ||
+       std::fabs(decoded.getHeading() - 271.25) > 0.0125)
+        return 6;
+
+    auto truncated = std::vector<std::byte>(coerBytes.begin(), coerBytes.end() - 1);
+    try {
+        J2735BSM invalid(truncated);
+        return 7;
+    }
+    catch(std::runtime_error &e) {
+    }
+
+    return 0;
+}